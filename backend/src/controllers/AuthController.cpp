@@ -1,9 +1,12 @@
 #include "AuthController.h"
+#include "../utils/AuthAdmission.h"
 #include "../utils/Database.h"
 #include "../utils/Session.h"
+#include "../utils/SessionCache.h"
+#include "../utils/SessionRenewal.h"
+#include "../utils/SessionToken.h"
 #include "../utils/PasswordHash.h"
 #include "../filters/AuthFilter.h"
-#include <cstdlib>
 
 namespace kanba {
 namespace controllers {
@@ -13,27 +16,66 @@ void AuthController::setSessionCookie(
     const std::string& sessionId,
     bool clear
 ) const {
-    drogon::Cookie cookie(utils::Session::COOKIE_NAME, sessionId);
-    cookie.setHttpOnly(true);
-    cookie.setPath("/");
-
-    const char* nodeEnv = std::getenv("NODE_ENV");
-    bool isProduction = nodeEnv && std::string(nodeEnv) == "production";
-
-    if (isProduction) {
-        cookie.setSecure(true);
-        cookie.setSameSite(drogon::Cookie::SameSite::kNone);
-    } else {
-        cookie.setSameSite(drogon::Cookie::SameSite::kLax);
-    }
+    resp->addCookie(utils::Session::makeCookie(sessionId, clear));
+}
 
-    if (clear) {
-        cookie.setMaxAge(0);
-    } else {
-        cookie.setMaxAge(utils::Session::SESSION_TTL_SECONDS);
+Json::Value AuthController::userToJson(const utils::SessionUser& user) const {
+    Json::Value json;
+    json["id"] = user.id;
+    json["name"] = user.name;
+    json["email"] = user.email;
+    if (user.avatarUrl.has_value()) {
+        json["avatar_url"] = *user.avatarUrl;
     }
+    return json;
+}
+
+drogon::HttpResponsePtr AuthController::serviceBusyResponse() const {
+    Json::Value error;
+    error["error"] = "Server is busy, please retry shortly";
+    auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
+    resp->setStatusCode(drogon::k503ServiceUnavailable);
+    resp->addHeader("Retry-After", "1");
+    return resp;
+}
+
+drogon::HttpResponsePtr AuthController::tooManyAttemptsResponse(
+    utils::AuthAdmission::Decision decision
+) const {
+    Json::Value error;
+    error["error"] = "Too many attempts, please retry later";
+    auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
+    resp->setStatusCode(drogon::k429TooManyRequests);
+    resp->addHeader("Retry-After", std::to_string(utils::AuthAdmission::retryAfterSeconds(decision)));
+    return resp;
+}
+
+void AuthController::rehashPassword(
+    const std::string& userId,
+    const std::string& password,
+    const std::string& oldHash
+) const {
+    // Best effort: if the queue is full the next login tries again
+    utils::PasswordHash::hashAsync(
+        password,
+        [userId, oldHash](std::optional<std::string> newHash) {
+            if (!newHash.has_value()) {
+                return;
+            }
 
-    resp->addCookie(cookie);
+            // Only replace the hash we verified, never a concurrently changed one
+            utils::Database::execute(
+                utils::Statements::REHASH_PASSWORD,
+                [](const drogon::orm::Result&) {},
+                [](const drogon::orm::DrogonDbException& e) {
+                    LOG_ERROR << "Failed to upgrade password hash: " << e.base().what();
+                },
+                *newHash,
+                userId,
+                oldHash
+            );
+        }
+    );
 }
 
 void AuthController::login(
@@ -53,9 +95,22 @@ void AuthController::login(
     std::string email = (*json)["email"].asString();
     std::string password = (*json)["password"].asString();
 
-    auto db = utils::Database::getClient();
-    db->execSqlAsync(
-        "SELECT * FROM get_user_by_email($1)",
+    // Rate limits and the in-flight cap are checked before any query or hash
+    auto admission = utils::AuthAdmission::admit(req->peerAddr().toIp(), email);
+    if (admission.decision != utils::AuthAdmission::Decision::Admitted) {
+        callback(tooManyAttemptsResponse(admission.decision));
+        return;
+    }
+
+    // Hold the in-flight slot until the response is sent
+    callback = [callback = std::move(callback), permit = std::move(admission.permit)](
+        const drogon::HttpResponsePtr& resp
+    ) {
+        callback(resp);
+    };
+
+    utils::Database::execute(
+        utils::Statements::GET_USER_BY_EMAIL,
         [this, password, callback](const drogon::orm::Result& result) {
             if (result.empty()) {
                 Json::Value error;
@@ -68,48 +123,62 @@ void AuthController::login(
 
             auto row = result[0];
             std::string storedHash = row["password_hash"].as<std::string>();
-            std::string userId = row["id"].as<std::string>();
-            std::string name = row["name"].as<std::string>();
-            std::string userEmail = row["email"].as<std::string>();
-
-            // Verify password
-            if (!utils::PasswordHash::verify(password, storedHash)) {
-                Json::Value error;
-                error["error"] = "Invalid email or password";
-                auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
-                resp->setStatusCode(drogon::k401Unauthorized);
-                callback(resp);
-                return;
+            utils::SessionUser user;
+            user.id = row["id"].as<std::string>();
+            user.name = row["name"].as<std::string>();
+            user.email = row["email"].as<std::string>();
+            if (!row["avatar_url"].isNull()) {
+                user.avatarUrl = row["avatar_url"].as<std::string>();
             }
 
-            // Create session
-            std::string sessionId = utils::Session::generateSessionId();
-            utils::Session::createSession(
-                sessionId,
-                userId,
-                [this, sessionId, userId, name, userEmail, callback](bool success) {
-                    if (!success) {
+            // Verify password off the IO loop
+            bool queued = utils::PasswordHash::verifyAsync(
+                password,
+                storedHash,
+                [this, user, password, storedHash, callback](bool valid, bool needsRehash) {
+                    if (!valid) {
                         Json::Value error;
-                        error["error"] = "Failed to create session";
+                        error["error"] = "Invalid email or password";
                         auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
-                        resp->setStatusCode(drogon::k500InternalServerError);
+                        resp->setStatusCode(drogon::k401Unauthorized);
                         callback(resp);
                         return;
                     }
 
-                    Json::Value user;
-                    user["id"] = userId;
-                    user["name"] = name;
-                    user["email"] = userEmail;
-
-                    Json::Value response;
-                    response["user"] = user;
+                    // Stored with older cost parameters: upgrade in the background
+                    if (needsRehash) {
+                        rehashPassword(user.id, password, storedHash);
+                    }
 
-                    auto resp = drogon::HttpResponse::newHttpJsonResponse(response);
-                    setSessionCookie(resp, sessionId);
-                    callback(resp);
+                    // Create session
+                    std::string sessionId = utils::Session::generateSessionId(user.id);
+                    utils::Session::createSession(
+                        sessionId,
+                        user,
+                        [this, sessionId, user, callback](bool success) {
+                            if (!success) {
+                                Json::Value error;
+                                error["error"] = "Failed to create session";
+                                auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
+                                resp->setStatusCode(drogon::k500InternalServerError);
+                                callback(resp);
+                                return;
+                            }
+
+                            Json::Value response;
+                            response["user"] = userToJson(user);
+
+                            auto resp = drogon::HttpResponse::newHttpJsonResponse(response);
+                            setSessionCookie(resp, sessionId);
+                            callback(resp);
+                        }
+                    );
                 }
             );
+
+            if (!queued) {
+                callback(serviceBusyResponse());
+            }
         },
         [callback](const drogon::orm::DrogonDbException& e) {
             Json::Value error;
@@ -140,81 +209,99 @@ void AuthController::registerUser(
     std::string password = (*json)["password"].asString();
     std::string name = (*json)["name"].asString();
 
-    // Hash password
-    std::string passwordHash;
-    try {
-        passwordHash = utils::PasswordHash::hash(password);
-    } catch (const std::exception& e) {
-        Json::Value error;
-        error["error"] = "Failed to hash password";
-        auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
-        resp->setStatusCode(drogon::k500InternalServerError);
-        callback(resp);
+    // Rate limits and the in-flight cap are checked before any query or hash
+    auto admission = utils::AuthAdmission::admit(req->peerAddr().toIp(), email);
+    if (admission.decision != utils::AuthAdmission::Decision::Admitted) {
+        callback(tooManyAttemptsResponse(admission.decision));
         return;
     }
 
-    auto db = utils::Database::getClient();
-    db->execSqlAsync(
-        "SELECT * FROM create_user($1, $2, $3)",
-        [this, callback](const drogon::orm::Result& result) {
-            if (result.empty()) {
+    // Hold the in-flight slot until the response is sent
+    callback = [callback = std::move(callback), permit = std::move(admission.permit)](
+        const drogon::HttpResponsePtr& resp
+    ) {
+        callback(resp);
+    };
+
+    // Hash password off the IO loop
+    bool queued = utils::PasswordHash::hashAsync(
+        password,
+        [this, email, name, callback](std::optional<std::string> passwordHash) {
+            if (!passwordHash.has_value()) {
                 Json::Value error;
-                error["error"] = "Failed to create user";
+                error["error"] = "Failed to hash password";
                 auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
                 resp->setStatusCode(drogon::k500InternalServerError);
                 callback(resp);
                 return;
             }
 
-            auto row = result[0];
-            std::string userId = row["id"].as<std::string>();
-            std::string userName = row["name"].as<std::string>();
-            std::string userEmail = row["email"].as<std::string>();
-
-            // Create session
-            std::string sessionId = utils::Session::generateSessionId();
-            utils::Session::createSession(
-                sessionId,
-                userId,
-                [this, sessionId, userId, userName, userEmail, callback](bool success) {
-                    if (!success) {
+            utils::Database::execute(
+                utils::Statements::CREATE_USER,
+                [this, callback](const drogon::orm::Result& result) {
+                    if (result.empty()) {
                         Json::Value error;
-                        error["error"] = "Failed to create session";
+                        error["error"] = "Failed to create user";
                         auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
                         resp->setStatusCode(drogon::k500InternalServerError);
                         callback(resp);
                         return;
                     }
 
-                    Json::Value user;
-                    user["id"] = userId;
-                    user["name"] = userName;
-                    user["email"] = userEmail;
-
-                    Json::Value response;
-                    response["user"] = user;
+                    auto row = result[0];
+                    utils::SessionUser user;
+                    user.id = row["id"].as<std::string>();
+                    user.name = row["name"].as<std::string>();
+                    user.email = row["email"].as<std::string>();
+                    if (!row["avatar_url"].isNull()) {
+                        user.avatarUrl = row["avatar_url"].as<std::string>();
+                    }
 
-                    auto resp = drogon::HttpResponse::newHttpJsonResponse(response);
-                    setSessionCookie(resp, sessionId);
+                    // Create session
+                    std::string sessionId = utils::Session::generateSessionId(user.id);
+                    utils::Session::createSession(
+                        sessionId,
+                        user,
+                        [this, sessionId, user, callback](bool success) {
+                            if (!success) {
+                                Json::Value error;
+                                error["error"] = "Failed to create session";
+                                auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
+                                resp->setStatusCode(drogon::k500InternalServerError);
+                                callback(resp);
+                                return;
+                            }
+
+                            Json::Value response;
+                            response["user"] = userToJson(user);
+
+                            auto resp = drogon::HttpResponse::newHttpJsonResponse(response);
+                            setSessionCookie(resp, sessionId);
+                            callback(resp);
+                        }
+                    );
+                },
+                [callback](const drogon::orm::DrogonDbException& e) {
+                    Json::Value error;
+                    if (std::string(e.base().what()).find("duplicate") != std::string::npos) {
+                        error["error"] = "Email already registered";
+                    } else {
+                        error["error"] = "Database error";
+                    }
+                    auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
+                    resp->setStatusCode(drogon::k400BadRequest);
                     callback(resp);
-                }
+                },
+                email,
+                *passwordHash,
+                name
             );
-        },
-        [callback](const drogon::orm::DrogonDbException& e) {
-            Json::Value error;
-            if (std::string(e.base().what()).find("duplicate") != std::string::npos) {
-                error["error"] = "Email already registered";
-            } else {
-                error["error"] = "Database error";
-            }
-            auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
-            resp->setStatusCode(drogon::k400BadRequest);
-            callback(resp);
-        },
-        email,
-        passwordHash,
-        name
+        }
     );
+
+    if (!queued) {
+        callback(serviceBusyResponse());
+    }
 }
 
 void AuthController::logout(
@@ -249,46 +336,21 @@ void AuthController::me(
         return;
     }
 
-    utils::Session::getUserIdFromSession(
+    // Session check and profile load in one round-trip, or none when cached
+    utils::Session::getUserFromSession(
         sessionId,
-        [callback](std::optional<std::string> userId) {
-            if (!userId.has_value()) {
-                Json::Value response;
+        [this, sessionId, callback](utils::SessionUserPtr user) {
+            Json::Value response;
+            if (user) {
+                response["user"] = userToJson(*user);
+            } else {
                 response["user"] = Json::nullValue;
-                auto resp = drogon::HttpResponse::newHttpJsonResponse(response);
-                callback(resp);
-                return;
             }
-
-            auto db = utils::Database::getClient();
-            db->execSqlAsync(
-                "SELECT * FROM get_user_by_id($1)",
-                [callback](const drogon::orm::Result& result) {
-                    Json::Value response;
-                    if (result.empty()) {
-                        response["user"] = Json::nullValue;
-                    } else {
-                        auto row = result[0];
-                        Json::Value user;
-                        user["id"] = row["id"].as<std::string>();
-                        user["name"] = row["name"].as<std::string>();
-                        user["email"] = row["email"].as<std::string>();
-                        if (!row["avatar_url"].isNull()) {
-                            user["avatar_url"] = row["avatar_url"].as<std::string>();
-                        }
-                        response["user"] = user;
-                    }
-                    auto resp = drogon::HttpResponse::newHttpJsonResponse(response);
-                    callback(resp);
-                },
-                [callback](const drogon::orm::DrogonDbException& e) {
-                    Json::Value response;
-                    response["user"] = Json::nullValue;
-                    auto resp = drogon::HttpResponse::newHttpJsonResponse(response);
-                    callback(resp);
-                },
-                *userId
-            );
+            auto resp = drogon::HttpResponse::newHttpJsonResponse(response);
+            if (user && !utils::SessionToken::isEnabled() && utils::SessionRenewal::touch(sessionId)) {
+                setSessionCookie(resp, sessionId);
+            }
+            callback(resp);
         }
     );
 }
@@ -310,10 +372,9 @@ void AuthController::update(
     std::string userId = req->attributes()->get<std::string>(filters::AuthFilter::USER_ID_KEY);
     std::string name = (*json)["name"].asString();
 
-    auto db = utils::Database::getClient();
-    db->execSqlAsync(
-        "UPDATE users SET name = $1 WHERE id = $2 RETURNING id, email, name, avatar_url",
-        [callback](const drogon::orm::Result& result) {
+    utils::Database::execute(
+        utils::Statements::UPDATE_USER_NAME,
+        [this, callback](const drogon::orm::Result& result) {
             if (result.empty()) {
                 Json::Value error;
                 error["error"] = "User not found";
@@ -324,16 +385,19 @@ void AuthController::update(
             }
 
             auto row = result[0];
-            Json::Value user;
-            user["id"] = row["id"].as<std::string>();
-            user["name"] = row["name"].as<std::string>();
-            user["email"] = row["email"].as<std::string>();
+            auto user = std::make_shared<utils::SessionUser>();
+            user->id = row["id"].as<std::string>();
+            user->name = row["name"].as<std::string>();
+            user->email = row["email"].as<std::string>();
             if (!row["avatar_url"].isNull()) {
-                user["avatar_url"] = row["avatar_url"].as<std::string>();
+                user->avatarUrl = row["avatar_url"].as<std::string>();
             }
 
+            // Keep cached sessions of this user in sync with the new profile
+            utils::SessionCache::updateUser(user);
+
             Json::Value response;
-            response["user"] = user;
+            response["user"] = userToJson(*user);
 
             auto resp = drogon::HttpResponse::newHttpJsonResponse(response);
             callback(resp);
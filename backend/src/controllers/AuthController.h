@@ -1,6 +1,8 @@
 #pragma once
 
 #include <drogon/HttpController.h>
+#include "../utils/AuthAdmission.h"
+#include "../utils/SessionCache.h"
 
 namespace kanba {
 namespace controllers {
@@ -49,6 +51,21 @@ private:
         const std::string& sessionId,
         bool clear = false
     ) const;
+
+    Json::Value userToJson(const utils::SessionUser& user) const;
+
+    // 503 with Retry-After, sent when the password hash queue is full
+    drogon::HttpResponsePtr serviceBusyResponse() const;
+
+    // Replace a valid hash made with outdated cost parameters (fire and forget)
+    void rehashPassword(
+        const std::string& userId,
+        const std::string& password,
+        const std::string& oldHash
+    ) const;
+
+    // 429 with Retry-After, sent when admission control rejects an attempt
+    drogon::HttpResponsePtr tooManyAttemptsResponse(utils::AuthAdmission::Decision decision) const;
 };
 
 } // namespace controllers
@@ -1,5 +1,7 @@
 #include "ColumnController.h"
 #include "../utils/Database.h"
+#include "../utils/ProjectAccess.h"
+#include "../utils/RowMapper.h"
 #include "../filters/AuthFilter.h"
 
 namespace kanba {
@@ -19,47 +21,52 @@ void ColumnController::createColumn(
         return;
     }
 
+    std::string userId = req->attributes()->get<std::string>(filters::AuthFilter::USER_ID_KEY);
     std::string projectId = (*json)["project_id"].asString();
     std::string name = (*json)["name"].asString();
     std::string color = json->isMember("color") ? (*json)["color"].asString() : "";
 
-    auto db = utils::Database::getClient();
-    db->execSqlAsync(
-        "SELECT * FROM create_column($1, $2, $3)",
-        [callback](const drogon::orm::Result& result) {
-            if (result.empty()) {
-                Json::Value error;
-                error["error"] = "Failed to create column";
-                auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
-                resp->setStatusCode(drogon::k500InternalServerError);
-                callback(resp);
+    utils::ProjectAccess::checkProject(
+        userId,
+        projectId,
+        utils::ProjectAccess::Role::Member,
+        [projectId, name, color, callback](utils::ProjectAccess::Access access) {
+            if (access != utils::ProjectAccess::Access::Allowed) {
+                callback(utils::ProjectAccess::errorResponse(access, "Project not found"));
                 return;
             }
 
-            auto row = result[0];
-            Json::Value column;
-            column["id"] = row["id"].as<std::string>();
-            column["project_id"] = row["project_id"].as<std::string>();
-            column["name"] = row["name"].as<std::string>();
-            if (!row["color"].isNull()) {
-                column["color"] = row["color"].as<std::string>();
-            }
-            column["position"] = row["position"].as<int>();
-
-            auto resp = drogon::HttpResponse::newHttpJsonResponse(column);
-            resp->setStatusCode(drogon::k201Created);
-            callback(resp);
-        },
-        [callback](const drogon::orm::DrogonDbException& e) {
-            Json::Value error;
-            error["error"] = "Database error";
-            auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
-            resp->setStatusCode(drogon::k500InternalServerError);
-            callback(resp);
-        },
-        projectId,
-        name,
-        color
+            utils::Database::execute(
+                utils::Statements::CREATE_COLUMN,
+                [callback](const drogon::orm::Result& result) {
+                    if (result.empty()) {
+                        Json::Value error;
+                        error["error"] = "Failed to create column";
+                        auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
+                        resp->setStatusCode(drogon::k500InternalServerError);
+                        callback(resp);
+                        return;
+                    }
+
+                    Json::Value column = utils::COLUMN_MAPPER.object(result);
+                    utils::ProjectAccess::rememberColumn(column["id"].asString(), column["project_id"].asString());
+
+                    auto resp = drogon::HttpResponse::newHttpJsonResponse(column);
+                    resp->setStatusCode(drogon::k201Created);
+                    callback(resp);
+                },
+                [callback](const drogon::orm::DrogonDbException& e) {
+                    Json::Value error;
+                    error["error"] = "Database error";
+                    auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
+                    resp->setStatusCode(drogon::k500InternalServerError);
+                    callback(resp);
+                },
+                projectId,
+                name,
+                color
+            );
+        }
     );
 }
 
@@ -77,45 +84,112 @@ void ColumnController::updateColumn(
         return;
     }
 
+    std::string userId = req->attributes()->get<std::string>(filters::AuthFilter::USER_ID_KEY);
     std::string id = (*json)["id"].asString();
     std::string name = json->isMember("name") ? (*json)["name"].asString() : "";
     std::string color = json->isMember("color") ? (*json)["color"].asString() : "";
 
-    auto db = utils::Database::getClient();
-    db->execSqlAsync(
-        "SELECT * FROM update_column($1, $2, $3)",
-        [callback](const drogon::orm::Result& result) {
-            if (result.empty()) {
-                Json::Value error;
-                error["error"] = "Column not found";
-                auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
-                resp->setStatusCode(drogon::k404NotFound);
-                callback(resp);
+    utils::ProjectAccess::checkColumn(
+        userId,
+        id,
+        utils::ProjectAccess::Role::Member,
+        [id, name, color, callback](utils::ProjectAccess::Access access) {
+            if (access != utils::ProjectAccess::Access::Allowed) {
+                callback(utils::ProjectAccess::errorResponse(access, "Column not found"));
                 return;
             }
 
-            auto row = result[0];
-            Json::Value column;
-            column["id"] = row["id"].as<std::string>();
-            column["name"] = row["name"].as<std::string>();
-            if (!row["color"].isNull()) {
-                column["color"] = row["color"].as<std::string>();
-            }
-            column["position"] = row["position"].as<int>();
-
-            auto resp = drogon::HttpResponse::newHttpJsonResponse(column);
-            callback(resp);
-        },
-        [callback](const drogon::orm::DrogonDbException& e) {
-            Json::Value error;
-            error["error"] = "Database error";
-            auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
-            resp->setStatusCode(drogon::k500InternalServerError);
-            callback(resp);
-        },
+            utils::Database::execute(
+                utils::Statements::UPDATE_COLUMN,
+                [callback](const drogon::orm::Result& result) {
+                    if (result.empty()) {
+                        Json::Value error;
+                        error["error"] = "Column not found";
+                        auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
+                        resp->setStatusCode(drogon::k404NotFound);
+                        callback(resp);
+                        return;
+                    }
+
+                    Json::Value column = utils::COLUMN_MAPPER.object(result);
+
+                    auto resp = drogon::HttpResponse::newHttpJsonResponse(column);
+                    callback(resp);
+                },
+                [callback](const drogon::orm::DrogonDbException& e) {
+                    Json::Value error;
+                    error["error"] = "Database error";
+                    auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
+                    resp->setStatusCode(drogon::k500InternalServerError);
+                    callback(resp);
+                },
+                id,
+                name,
+                color
+            );
+        }
+    );
+}
+
+void ColumnController::moveColumn(
+    const drogon::HttpRequestPtr& req,
+    std::function<void(const drogon::HttpResponsePtr&)>&& callback
+) {
+    auto json = req->getJsonObject();
+    if (!json || !json->isMember("column_id") || !json->isMember("position")) {
+        Json::Value error;
+        error["error"] = "Column ID and position are required";
+        auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
+        resp->setStatusCode(drogon::k400BadRequest);
+        callback(resp);
+        return;
+    }
+
+    std::string userId = req->attributes()->get<std::string>(filters::AuthFilter::USER_ID_KEY);
+    std::string id = (*json)["column_id"].asString();
+    // Index among the project's other columns; move_column turns it into a
+    // rank between the neighbours at that index
+    int position = (*json)["position"].asInt();
+
+    utils::ProjectAccess::checkColumn(
+        userId,
         id,
-        name,
-        color
+        utils::ProjectAccess::Role::Member,
+        [id, position, callback](utils::ProjectAccess::Access access) {
+            if (access != utils::ProjectAccess::Access::Allowed) {
+                callback(utils::ProjectAccess::errorResponse(access, "Column not found"));
+                return;
+            }
+
+            utils::Database::execute(
+                utils::Statements::MOVE_COLUMN,
+                [callback](const drogon::orm::Result& result) {
+                    if (result.empty() || !result[0]["moved"].as<bool>()) {
+                        Json::Value error;
+                        error["error"] = "Column not found";
+                        auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
+                        resp->setStatusCode(drogon::k404NotFound);
+                        callback(resp);
+                        return;
+                    }
+
+                    Json::Value response;
+                    response["success"] = true;
+
+                    auto resp = drogon::HttpResponse::newHttpJsonResponse(response);
+                    callback(resp);
+                },
+                [callback](const drogon::orm::DrogonDbException& e) {
+                    Json::Value error;
+                    error["error"] = "Database error";
+                    auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
+                    resp->setStatusCode(drogon::k500InternalServerError);
+                    callback(resp);
+                },
+                id,
+                position
+            );
+        }
     );
 }
 
@@ -124,6 +198,7 @@ void ColumnController::deleteColumn(
     std::function<void(const drogon::HttpResponsePtr&)>&& callback
 ) {
     std::string id = req->getParameter("id");
+    std::string userId = req->attributes()->get<std::string>(filters::AuthFilter::USER_ID_KEY);
 
     if (id.empty()) {
         Json::Value error;
@@ -134,24 +209,35 @@ void ColumnController::deleteColumn(
         return;
     }
 
-    auto db = utils::Database::getClient();
-    db->execSqlAsync(
-        "SELECT * FROM delete_column($1)",
-        [callback](const drogon::orm::Result& result) {
-            Json::Value response;
-            response["success"] = true;
-
-            auto resp = drogon::HttpResponse::newHttpJsonResponse(response);
-            callback(resp);
-        },
-        [callback](const drogon::orm::DrogonDbException& e) {
-            Json::Value error;
-            error["error"] = "Database error";
-            auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
-            resp->setStatusCode(drogon::k500InternalServerError);
-            callback(resp);
-        },
-        id
+    utils::ProjectAccess::checkColumn(
+        userId,
+        id,
+        utils::ProjectAccess::Role::Member,
+        [id, callback](utils::ProjectAccess::Access access) {
+            if (access != utils::ProjectAccess::Access::Allowed) {
+                callback(utils::ProjectAccess::errorResponse(access, "Column not found"));
+                return;
+            }
+
+            utils::Database::execute(
+                utils::Statements::DELETE_COLUMN,
+                [callback](const drogon::orm::Result& result) {
+                    Json::Value response;
+                    response["success"] = true;
+
+                    auto resp = drogon::HttpResponse::newHttpJsonResponse(response);
+                    callback(resp);
+                },
+                [callback](const drogon::orm::DrogonDbException& e) {
+                    Json::Value error;
+                    error["error"] = "Database error";
+                    auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
+                    resp->setStatusCode(drogon::k500InternalServerError);
+                    callback(resp);
+                },
+                id
+            );
+        }
     );
 }
 
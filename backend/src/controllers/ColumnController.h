@@ -11,6 +11,7 @@ public:
     // All column routes require authentication
     ADD_METHOD_TO(ColumnController::createColumn, "/api/columns", drogon::Post, "kanba::filters::AuthFilter");
     ADD_METHOD_TO(ColumnController::updateColumn, "/api/columns", drogon::Put, "kanba::filters::AuthFilter");
+    ADD_METHOD_TO(ColumnController::moveColumn, "/api/columns/move", drogon::Post, "kanba::filters::AuthFilter");
     ADD_METHOD_TO(ColumnController::deleteColumn, "/api/columns", drogon::Delete, "kanba::filters::AuthFilter");
     METHOD_LIST_END
 
@@ -24,6 +25,11 @@ public:
         std::function<void(const drogon::HttpResponsePtr&)>&& callback
     );
 
+    void moveColumn(
+        const drogon::HttpRequestPtr& req,
+        std::function<void(const drogon::HttpResponsePtr&)>&& callback
+    );
+
     void deleteColumn(
         const drogon::HttpRequestPtr& req,
         std::function<void(const drogon::HttpResponsePtr&)>&& callback
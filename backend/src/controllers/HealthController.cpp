@@ -1,4 +1,5 @@
 #include "HealthController.h"
+#include "../utils/DbCircuitBreaker.h"
 
 namespace kanba {
 namespace controllers {
@@ -7,8 +8,14 @@ void HealthController::health(
     const drogon::HttpRequestPtr& req,
     std::function<void(const drogon::HttpResponsePtr&)>&& callback
 ) {
+    // Still 200 while degraded: the process is up, and load balancers should
+    // not restart it for a database outage
+    auto breaker = utils::DbCircuitBreaker::stats();
     Json::Value result;
-    result["status"] = "ok";
+    result["status"] = breaker.state == utils::DbCircuitBreaker::State::Closed ? "ok" : "degraded";
+    result["database"]["circuit"] = utils::DbCircuitBreaker::stateName(breaker.state);
+    result["database"]["in_flight"] = Json::UInt64(breaker.inFlight);
+    result["database"]["latency_ms"] = breaker.latencyMs;
 
     auto resp = drogon::HttpResponse::newHttpJsonResponse(result);
     callback(resp);
@@ -0,0 +1,201 @@
+#include "MetricsController.h"
+#include "../utils/ActivityLog.h"
+#include "../utils/AuthAdmission.h"
+#include "../utils/Database.h"
+#include "../utils/DbCircuitBreaker.h"
+#include "../utils/HashExecutor.h"
+#include "../utils/NegativeSessionCache.h"
+#include "../utils/PasswordHash.h"
+#include "../utils/ProjectAccess.h"
+#include "../utils/QueryMetrics.h"
+#include "../utils/RankRebalancer.h"
+#include "../utils/RevocationList.h"
+#include "../utils/SessionCache.h"
+#include "../utils/SessionReaper.h"
+#include "../utils/SessionRenewal.h"
+#include "../utils/SlowQueryLog.h"
+
+namespace kanba {
+namespace controllers {
+
+void MetricsController::metrics(
+    const drogon::HttpRequestPtr& req,
+    std::function<void(const drogon::HttpResponsePtr&)>&& callback
+) {
+    auto sessionStats = utils::SessionCache::stats();
+    Json::Value sessionCache;
+    sessionCache["hits"] = Json::UInt64(sessionStats.hits);
+    sessionCache["misses"] = Json::UInt64(sessionStats.misses);
+    sessionCache["evictions"] = Json::UInt64(sessionStats.evictions);
+    sessionCache["size"] = Json::UInt64(sessionStats.size);
+    sessionCache["capacity"] = Json::UInt64(sessionStats.capacity);
+    sessionCache["ttl_seconds"] = Json::Int64(sessionStats.ttlSeconds);
+
+    auto rejectStats = utils::NegativeSessionCache::stats();
+    Json::Value sessionRejections;
+    sessionRejections["malformed"] = Json::UInt64(rejectStats.rejectedMalformed);
+    sessionRejections["known_bad"] = Json::UInt64(rejectStats.rejectedKnownBad);
+    sessionRejections["bloom"] = Json::UInt64(rejectStats.rejectedBloom);
+    sessionRejections["bloom_miss_checks"] = Json::UInt64(rejectStats.bloomMissChecks);
+    sessionRejections["known_bad_size"] = Json::UInt64(rejectStats.knownBadSize);
+    sessionRejections["bloom_ready"] = rejectStats.bloomReady;
+    sessionRejections["bloom_entries"] = Json::UInt64(rejectStats.bloomEntries);
+    sessionRejections["bloom_bits"] = Json::UInt64(rejectStats.bloomBits);
+
+    auto revocationStats = utils::RevocationList::stats();
+    Json::Value sessionRevocations;
+    sessionRevocations["size"] = Json::UInt64(revocationStats.size);
+    sessionRevocations["rejected"] = Json::UInt64(revocationStats.rejected);
+
+    auto renewalStats = utils::SessionRenewal::stats();
+    Json::Value sessionRenewal;
+    sessionRenewal["queued"] = Json::UInt64(renewalStats.queued);
+    sessionRenewal["skipped"] = Json::UInt64(renewalStats.skipped);
+    sessionRenewal["pending"] = Json::UInt64(renewalStats.pending);
+    sessionRenewal["flushes"] = Json::UInt64(renewalStats.flushes);
+    sessionRenewal["renewed"] = Json::UInt64(renewalStats.renewed);
+    sessionRenewal["retried"] = Json::UInt64(renewalStats.retried);
+
+    auto reaperStats = utils::SessionReaper::stats();
+    Json::Value sessionReaper;
+    sessionReaper["runs"] = Json::UInt64(reaperStats.runs);
+    sessionReaper["batches"] = Json::UInt64(reaperStats.batches);
+    sessionReaper["sessions_deleted"] = Json::UInt64(reaperStats.sessionsDeleted);
+    sessionReaper["revocations_deleted"] = Json::UInt64(reaperStats.revocationsDeleted);
+    sessionReaper["partitions_created"] = Json::UInt64(reaperStats.partitionsCreated);
+    sessionReaper["partitions_dropped"] = Json::UInt64(reaperStats.partitionsDropped);
+
+    auto rebalanceStats = utils::RankRebalancer::stats();
+    Json::Value rankRebalancer;
+    rankRebalancer["runs"] = Json::UInt64(rebalanceStats.runs);
+    rankRebalancer["columns_rebalanced"] = Json::UInt64(rebalanceStats.columnsRebalanced);
+    rankRebalancer["projects_rebalanced"] = Json::UInt64(rebalanceStats.projectsRebalanced);
+
+    auto activityStats = utils::ActivityLog::stats();
+    Json::Value activityLog;
+    activityLog["recorded"] = Json::UInt64(activityStats.recorded);
+    activityLog["written"] = Json::UInt64(activityStats.written);
+    activityLog["dropped"] = Json::UInt64(activityStats.dropped);
+    activityLog["failed"] = Json::UInt64(activityStats.failed);
+    activityLog["retried"] = Json::UInt64(activityStats.retried);
+    activityLog["batches"] = Json::UInt64(activityStats.batches);
+    activityLog["pending"] = Json::UInt64(activityStats.pending);
+    activityLog["lag_ms"] = activityStats.lagMs;
+    activityLog["max_lag_ms"] = activityStats.maxLagMs;
+
+    auto hashStats = utils::HashExecutor::stats();
+    Json::Value passwordHashing;
+    passwordHashing["workers"] = Json::UInt64(hashStats.workers);
+    passwordHashing["queue_capacity"] = Json::UInt64(hashStats.queueCapacity);
+    passwordHashing["queue_depth"] = Json::UInt64(hashStats.queueDepth);
+    passwordHashing["active"] = Json::UInt64(hashStats.active);
+    passwordHashing["completed"] = Json::UInt64(hashStats.completed);
+    passwordHashing["rejected"] = Json::UInt64(hashStats.rejected);
+    passwordHashing["total_queue_wait_us"] = Json::UInt64(hashStats.totalQueueWaitUs);
+    passwordHashing["total_hash_us"] = Json::UInt64(hashStats.totalHashUs);
+    passwordHashing["max_hash_us"] = Json::UInt64(hashStats.maxHashUs);
+    passwordHashing["ops_limit"] = Json::UInt64(utils::PasswordHash::opsLimit());
+    passwordHashing["mem_limit_bytes"] = Json::UInt64(utils::PasswordHash::memoryPerHash());
+
+    auto admissionStats = utils::AuthAdmission::stats();
+    Json::Value authAdmission;
+    authAdmission["admitted"] = Json::UInt64(admissionStats.admitted);
+    authAdmission["rejected_ip"] = Json::UInt64(admissionStats.rejectedIp);
+    authAdmission["rejected_email"] = Json::UInt64(admissionStats.rejectedEmail);
+    authAdmission["rejected_overload"] = Json::UInt64(admissionStats.rejectedOverload);
+    authAdmission["in_flight"] = Json::UInt64(admissionStats.inFlight);
+    authAdmission["tracked_keys"] = Json::UInt64(admissionStats.trackedKeys);
+
+    auto accessStats = utils::ProjectAccess::stats();
+    Json::Value projectAccess;
+    projectAccess["hits"] = Json::UInt64(accessStats.hits);
+    projectAccess["loads"] = Json::UInt64(accessStats.loads);
+    projectAccess["resolver_hits"] = Json::UInt64(accessStats.resolverHits);
+    projectAccess["resolver_loads"] = Json::UInt64(accessStats.resolverLoads);
+    projectAccess["denied"] = Json::UInt64(accessStats.denied);
+    projectAccess["cached_users"] = Json::UInt64(accessStats.cachedUsers);
+    projectAccess["resolved_ids"] = Json::UInt64(accessStats.resolvedIds);
+
+    const auto& dbOptions = utils::Database::options();
+    auto dbStats = utils::Database::stats();
+    auto poolJson = [](const utils::Database::PoolStats& pool) {
+        Json::Value json;
+        json["connections"] = Json::UInt64(pool.connections);
+        json["queries"] = Json::UInt64(pool.queries);
+        json["in_flight"] = Json::UInt64(pool.inFlight);
+        json["errors"] = Json::UInt64(pool.errors);
+        return json;
+    };
+    Json::Value database;
+    database["fast_clients"] = dbOptions.fastClients;
+    database["io_threads"] = Json::UInt64(drogon::app().getThreadNum());
+    database["connections"] = Json::UInt64(dbOptions.connections);
+    database["total_connections"] = Json::UInt64(dbStats.primary.connections);
+    database["auto_batch"] = dbOptions.autoBatch;
+    database["timeout_seconds"] = dbOptions.timeoutSeconds;
+    database["primary"] = poolJson(dbStats.primary);
+    database["replica"] = poolJson(dbStats.replica);
+    database["replica"]["configured"] = dbStats.replicaConfigured;
+    database["replica"]["healthy"] = dbStats.replicaHealthy;
+    database["replica"]["lag_ms"] = dbStats.replicaLagMs;
+    database["read_routing"]["replica_reads"] = Json::UInt64(dbStats.replicaReads);
+    database["read_routing"]["pinned_reads"] = Json::UInt64(dbStats.pinnedReads);
+    database["read_routing"]["fallback_reads"] = Json::UInt64(dbStats.fallbackReads);
+    database["read_routing"]["pinned_users"] = Json::UInt64(dbStats.pinnedUsers);
+
+    auto breaker = utils::DbCircuitBreaker::stats();
+    database["circuit"]["state"] = utils::DbCircuitBreaker::stateName(breaker.state);
+    database["circuit"]["opened"] = Json::UInt64(breaker.opened);
+    database["circuit"]["rejected"] = Json::UInt64(breaker.rejected);
+    database["circuit"]["probes"] = Json::UInt64(breaker.probes);
+    database["circuit"]["in_flight"] = Json::UInt64(breaker.inFlight);
+    database["circuit"]["latency_ms"] = breaker.latencyMs;
+    database["circuit"]["failure_ratio"] = breaker.failureRatio;
+    database["query_deadline_ms"] = dbOptions.queryDeadlineMs;
+
+    // Per statement, since startup; latencies are ms from send to result
+    Json::Value statements(Json::objectValue);
+    for (const auto& stats : utils::QueryMetrics::snapshot()) {
+        Json::Value json;
+        json["calls"] = Json::UInt64(stats.calls);
+        json["errors"] = Json::UInt64(stats.errors);
+        json["rows"] = Json::UInt64(stats.rows);
+        json["total_ms"] = stats.totalMs;
+        json["mean_ms"] = stats.calls ? stats.totalMs / static_cast<double>(stats.calls) : 0.0;
+        json["p50_ms"] = stats.p50Ms;
+        json["p90_ms"] = stats.p90Ms;
+        json["p99_ms"] = stats.p99Ms;
+        json["p999_ms"] = stats.p999Ms;
+        json["max_ms"] = stats.maxMs;
+        statements[stats.name] = json;
+    }
+
+    auto slowStats = utils::SlowQueryLog::stats();
+    Json::Value slowQueries;
+    slowQueries["logged"] = Json::UInt64(slowStats.slowQueries);
+    slowQueries["dropped"] = Json::UInt64(slowStats.dropped);
+    slowQueries["explained"] = Json::UInt64(slowStats.explained);
+    slowQueries["explain_failures"] = Json::UInt64(slowStats.explainFailures);
+    slowQueries["nested_plans"] = slowStats.nestedPlans;
+
+    Json::Value result;
+    result["session_cache"] = sessionCache;
+    result["session_rejections"] = sessionRejections;
+    result["session_revocations"] = sessionRevocations;
+    result["session_renewal"] = sessionRenewal;
+    result["session_reaper"] = sessionReaper;
+    result["rank_rebalancer"] = rankRebalancer;
+    result["activity_log"] = activityLog;
+    result["password_hashing"] = passwordHashing;
+    result["auth_admission"] = authAdmission;
+    result["project_access"] = projectAccess;
+    result["database"] = database;
+    result["statements"] = statements;
+    result["slow_queries"] = slowQueries;
+
+    auto resp = drogon::HttpResponse::newHttpJsonResponse(result);
+    callback(resp);
+}
+
+} // namespace controllers
+} // namespace kanba
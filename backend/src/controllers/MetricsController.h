@@ -0,0 +1,21 @@
+#pragma once
+
+#include <drogon/HttpController.h>
+
+namespace kanba {
+namespace controllers {
+
+class MetricsController : public drogon::HttpController<MetricsController> {
+public:
+    METHOD_LIST_BEGIN
+    ADD_METHOD_TO(MetricsController::metrics, "/api/metrics", drogon::Get, "kanba::filters::MetricsFilter");
+    METHOD_LIST_END
+
+    void metrics(
+        const drogon::HttpRequestPtr& req,
+        std::function<void(const drogon::HttpResponsePtr&)>&& callback
+    );
+};
+
+} // namespace controllers
+} // namespace kanba
@@ -1,5 +1,7 @@
 #include "ProjectController.h"
 #include "../utils/Database.h"
+#include "../utils/ProjectAccess.h"
+#include "../utils/RowMapper.h"
 #include "../filters/AuthFilter.h"
 
 namespace kanba {
@@ -11,31 +13,12 @@ void ProjectController::getProjects(
 ) {
     std::string userId = req->attributes()->get<std::string>(filters::AuthFilter::USER_ID_KEY);
 
-    auto db = utils::Database::getClient();
-    db->execSqlAsync(
-        "SELECT * FROM get_user_projects($1)",
+    utils::Database::executeOn(
+        utils::Database::readTarget(userId),
+        utils::Statements::GET_USER_PROJECTS,
         [callback](const drogon::orm::Result& result) {
-            Json::Value projects(Json::arrayValue);
-
-            for (const auto& row : result) {
-                Json::Value project;
-                project["id"] = row["id"].as<std::string>();
-                project["name"] = row["name"].as<std::string>();
-                if (!row["description"].isNull()) {
-                    project["description"] = row["description"].as<std::string>();
-                }
-                if (!row["icon"].isNull()) {
-                    project["icon"] = row["icon"].as<std::string>();
-                }
-                project["owner_id"] = row["owner_id"].as<std::string>();
-                project["task_count"] = row["task_count"].as<int>();
-                project["member_count"] = row["member_count"].as<int>();
-                project["created_at"] = row["created_at"].as<std::string>();
-                projects.append(project);
-            }
-
             Json::Value response;
-            response["projects"] = projects;
+            response["projects"] = utils::PROJECT_MAPPER.array(result);
             auto resp = drogon::HttpResponse::newHttpJsonResponse(response);
             callback(resp);
         },
@@ -69,10 +52,9 @@ void ProjectController::createProject(
     std::string description = json->isMember("description") ? (*json)["description"].asString() : "";
     std::string icon = json->isMember("icon") ? (*json)["icon"].asString() : "";
 
-    auto db = utils::Database::getClient();
-    db->execSqlAsync(
-        "SELECT create_project($1, $2, $3, $4) AS id",
-        [callback](const drogon::orm::Result& result) {
+    utils::Database::execute(
+        utils::Statements::CREATE_PROJECT,
+        [callback, userId](const drogon::orm::Result& result) {
             if (result.empty()) {
                 Json::Value error;
                 error["error"] = "Failed to create project";
@@ -82,6 +64,9 @@ void ProjectController::createProject(
                 return;
             }
 
+            // The owner's cached memberships no longer list every project
+            utils::ProjectAccess::invalidateUser(userId);
+
             Json::Value response;
             response["id"] = result[0]["id"].as<std::string>();
             response["success"] = true;
@@ -111,175 +96,51 @@ void ProjectController::getProject(
 ) {
     std::string userId = req->attributes()->get<std::string>(filters::AuthFilter::USER_ID_KEY);
 
-    auto db = utils::Database::getClient();
-
-    // Get project details
-    db->execSqlAsync(
-        "SELECT * FROM get_project_details($1)",
-        [db, id, callback](const drogon::orm::Result& projectResult) {
-            if (projectResult.empty()) {
-                Json::Value error;
-                error["error"] = "Project not found";
-                auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
-                resp->setStatusCode(drogon::k404NotFound);
-                callback(resp);
+    utils::ProjectAccess::checkProject(
+        userId,
+        id,
+        utils::ProjectAccess::Role::Member,
+        [id, userId, callback](utils::ProjectAccess::Access access) {
+            if (access != utils::ProjectAccess::Access::Allowed) {
+                callback(utils::ProjectAccess::errorResponse(access, "Project not found"));
                 return;
             }
+            sendProject(id, utils::Database::readTarget(userId), callback);
+        }
+    );
+}
 
-            auto projectRow = projectResult[0];
-            Json::Value project;
-            project["id"] = projectRow["id"].as<std::string>();
-            project["name"] = projectRow["name"].as<std::string>();
-            if (!projectRow["description"].isNull()) {
-                project["description"] = projectRow["description"].as<std::string>();
-            }
-            if (!projectRow["icon"].isNull()) {
-                project["icon"] = projectRow["icon"].as<std::string>();
-            }
-            project["owner_id"] = projectRow["owner_id"].as<std::string>();
-            project["created_at"] = projectRow["created_at"].as<std::string>();
-
-            // Get columns
-            db->execSqlAsync(
-                "SELECT * FROM get_project_columns($1)",
-                [db, id, project, callback](const drogon::orm::Result& columnsResult) mutable {
-                    Json::Value columns(Json::arrayValue);
-                    for (const auto& row : columnsResult) {
-                        Json::Value column;
-                        column["id"] = row["id"].as<std::string>();
-                        column["name"] = row["name"].as<std::string>();
-                        if (!row["color"].isNull()) {
-                            column["color"] = row["color"].as<std::string>();
-                        }
-                        column["position"] = row["position"].as<int>();
-                        column["task_count"] = row["task_count"].as<int>();
-                        columns.append(column);
-                    }
-                    project["columns"] = columns;
-
-                    // Get tasks
-                    db->execSqlAsync(
-                        "SELECT * FROM get_project_tasks($1)",
-                        [db, id, project, callback](const drogon::orm::Result& tasksResult) mutable {
-                            Json::Value tasks(Json::arrayValue);
-                            for (const auto& row : tasksResult) {
-                                Json::Value task;
-                                task["id"] = row["id"].as<std::string>();
-                                task["column_id"] = row["column_id"].as<std::string>();
-                                task["title"] = row["title"].as<std::string>();
-                                if (!row["description"].isNull()) {
-                                    task["description"] = row["description"].as<std::string>();
-                                }
-                                task["priority"] = row["priority"].as<std::string>();
-                                task["position"] = row["position"].as<int>();
-                                if (!row["assignee_id"].isNull()) {
-                                    task["assignee_id"] = row["assignee_id"].as<std::string>();
-                                }
-                                if (!row["assignee_name"].isNull()) {
-                                    task["assignee_name"] = row["assignee_name"].as<std::string>();
-                                }
-                                if (!row["due_date"].isNull()) {
-                                    task["due_date"] = row["due_date"].as<std::string>();
-                                }
-                                if (!row["tags"].isNull()) {
-                                    // Parse tags JSON array
-                                    Json::Reader reader;
-                                    Json::Value tagsArray;
-                                    if (reader.parse(row["tags"].as<std::string>(), tagsArray)) {
-                                        task["tags"] = tagsArray;
-                                    }
-                                }
-                                task["created_at"] = row["created_at"].as<std::string>();
-                                tasks.append(task);
-                            }
-                            project["tasks"] = tasks;
-
-                            // Get members
-                            db->execSqlAsync(
-                                "SELECT * FROM get_project_members($1)",
-                                [project, callback](const drogon::orm::Result& membersResult) mutable {
-                                    Json::Value members(Json::arrayValue);
-                                    for (const auto& row : membersResult) {
-                                        Json::Value member;
-                                        member["id"] = row["id"].as<std::string>();
-                                        member["user_id"] = row["user_id"].as<std::string>();
-                                        member["name"] = row["name"].as<std::string>();
-                                        member["email"] = row["email"].as<std::string>();
-                                        member["role"] = row["role"].as<std::string>();
-                                        if (!row["avatar_url"].isNull()) {
-                                            member["avatar_url"] = row["avatar_url"].as<std::string>();
-                                        }
-                                        members.append(member);
-                                    }
-                                    // Nest tasks inside their columns (frontend reads column.tasks)
-                                    Json::Value columns = project["columns"];
-                                    Json::Value tasks = project["tasks"];
-                                    for (Json::ArrayIndex i = 0; i < columns.size(); i++) {
-                                        columns[i]["tasks"] = Json::Value(Json::arrayValue);
-                                    }
-                                    for (Json::ArrayIndex t = 0; t < tasks.size(); t++) {
-                                        std::string taskColId = tasks[t]["column_id"].asString();
-                                        for (Json::ArrayIndex i = 0; i < columns.size(); i++) {
-                                            if (columns[i]["id"].asString() == taskColId) {
-                                                columns[i]["tasks"].append(tasks[t]);
-                                                break;
-                                            }
-                                        }
-                                    }
-
-                                    Json::Value response;
-                                    response["project"] = Json::Value();
-                                    response["project"]["id"] = project["id"];
-                                    response["project"]["name"] = project["name"];
-                                    response["project"]["description"] = project["description"];
-                                    response["project"]["icon"] = project["icon"];
-                                    response["project"]["owner_id"] = project["owner_id"];
-                                    response["project"]["created_at"] = project["created_at"];
-                                    response["columns"] = columns;
-                                    response["members"] = members;
-
-                                    auto resp = drogon::HttpResponse::newHttpJsonResponse(response);
-                                    callback(resp);
-                                },
-                                [callback](const drogon::orm::DrogonDbException& e) {
-                                    Json::Value error;
-                                    error["error"] = "Database error";
-                                    auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
-                                    resp->setStatusCode(drogon::k500InternalServerError);
-                                    callback(resp);
-                                },
-                                id
-                            );
-                        },
-                        [callback](const drogon::orm::DrogonDbException& e) {
-                            Json::Value error;
-                            error["error"] = "Database error";
-                            auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
-                            resp->setStatusCode(drogon::k500InternalServerError);
-                            callback(resp);
-                        },
-                        id
-                    );
-                },
-                [callback](const drogon::orm::DrogonDbException& e) {
-                    Json::Value error;
-                    error["error"] = "Database error";
-                    auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
-                    resp->setStatusCode(drogon::k500InternalServerError);
-                    callback(resp);
-                },
-                id
-            );
-        },
-        [callback](const drogon::orm::DrogonDbException& e) {
+drogon::AsyncTask ProjectController::sendProject(
+    std::string id,
+    utils::Database::Target target,
+    std::function<void(const drogon::HttpResponsePtr&)> callback
+) {
+    try {
+        // get_project_board returns the response document itself, so its
+        // bytes become the body without being parsed or re-serialized
+        auto result = co_await utils::Database::executeCoro(target, utils::Statements::GET_PROJECT_BOARD, id);
+        if (result.empty() || result[0]["board"].isNull()) {
             Json::Value error;
-            error["error"] = "Database error";
+            error["error"] = "Project not found";
             auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
-            resp->setStatusCode(drogon::k500InternalServerError);
+            resp->setStatusCode(drogon::k404NotFound);
             callback(resp);
-        },
-        id
-    );
+            co_return;
+        }
+
+        auto board = result[0]["board"];
+        auto resp = drogon::HttpResponse::newHttpResponse();
+        resp->setContentTypeCode(drogon::CT_APPLICATION_JSON);
+        resp->setBody(std::string(board.c_str(), board.length()));
+        callback(resp);
+    } catch (const drogon::orm::DrogonDbException& e) {
+        LOG_ERROR << "Database error: " << e.base().what();
+        Json::Value error;
+        error["error"] = "Database error";
+        auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
+        resp->setStatusCode(drogon::k500InternalServerError);
+        callback(resp);
+    }
 }
 
 void ProjectController::deleteProject(
@@ -289,10 +150,34 @@ void ProjectController::deleteProject(
 ) {
     std::string userId = req->attributes()->get<std::string>(filters::AuthFilter::USER_ID_KEY);
 
-    auto db = utils::Database::getClient();
-    db->execSqlAsync(
-        "SELECT * FROM delete_project($1, $2)",
-        [callback](const drogon::orm::Result& result) {
+    utils::ProjectAccess::checkProject(
+        userId,
+        id,
+        utils::ProjectAccess::Role::Owner,
+        [id, userId, callback](utils::ProjectAccess::Access access) {
+            if (access != utils::ProjectAccess::Access::Allowed) {
+                callback(utils::ProjectAccess::errorResponse(
+                    access,
+                    "Project not found",
+                    "Only the project owner can delete this project"
+                ));
+                return;
+            }
+            deleteOwnedProject(id, userId, callback);
+        }
+    );
+}
+
+void ProjectController::deleteOwnedProject(
+    const std::string& id,
+    const std::string& userId,
+    std::function<void(const drogon::HttpResponsePtr&)> callback
+) {
+    utils::Database::execute(
+        utils::Statements::DELETE_PROJECT,
+        [id, callback](const drogon::orm::Result& result) {
+            utils::ProjectAccess::invalidateProject(id);
+
             Json::Value response;
             response["success"] = true;
 
@@ -335,13 +220,42 @@ void ProjectController::inviteMember(
         return;
     }
 
+    std::string userId = req->attributes()->get<std::string>(filters::AuthFilter::USER_ID_KEY);
     std::string email = (*json)["email"].asString();
     std::string role = json->isMember("role") ? (*json)["role"].asString() : "member";
 
-    auto db = utils::Database::getClient();
-    db->execSqlAsync(
-        "SELECT * FROM add_project_member($1, $2, $3)",
+    utils::ProjectAccess::checkProject(
+        userId,
+        id,
+        utils::ProjectAccess::Role::Admin,
+        [id, email, role, callback](utils::ProjectAccess::Access access) {
+            if (access != utils::ProjectAccess::Access::Allowed) {
+                callback(utils::ProjectAccess::errorResponse(
+                    access,
+                    "Project not found",
+                    "Only project owners and admins can invite members"
+                ));
+                return;
+            }
+            addMember(id, email, role, callback);
+        }
+    );
+}
+
+void ProjectController::addMember(
+    const std::string& id,
+    const std::string& email,
+    const std::string& role,
+    std::function<void(const drogon::HttpResponsePtr&)> callback
+) {
+    utils::Database::execute(
+        utils::Statements::ADD_PROJECT_MEMBER,
         [callback](const drogon::orm::Result& result) {
+            // The invitee's cached memberships are now missing this project
+            if (!result.empty() && !result[0]["user_id"].isNull()) {
+                utils::ProjectAccess::invalidateUser(result[0]["user_id"].as<std::string>());
+            }
+
             Json::Value response;
             response["success"] = true;
 
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <drogon/HttpController.h>
+#include <drogon/utils/coroutine.h>
+#include "../utils/Database.h"
 
 namespace kanba {
 namespace controllers {
@@ -43,6 +45,27 @@ public:
         std::function<void(const drogon::HttpResponsePtr&)>&& callback,
         const std::string& id
     );
+
+private:
+    // Handlers after the project access check has passed
+    static drogon::AsyncTask sendProject(
+        std::string id,
+        utils::Database::Target target,
+        std::function<void(const drogon::HttpResponsePtr&)> callback
+    );
+
+    static void deleteOwnedProject(
+        const std::string& id,
+        const std::string& userId,
+        std::function<void(const drogon::HttpResponsePtr&)> callback
+    );
+
+    static void addMember(
+        const std::string& id,
+        const std::string& email,
+        const std::string& role,
+        std::function<void(const drogon::HttpResponsePtr&)> callback
+    );
 };
 
 } // namespace controllers
@@ -1,10 +1,37 @@
 #include "TaskController.h"
+#include "../utils/ActivityLog.h"
 #include "../utils/Database.h"
+#include "../utils/ProjectAccess.h"
+#include "../utils/RowMapper.h"
 #include "../filters/AuthFilter.h"
 
 namespace kanba {
 namespace controllers {
 
+namespace {
+
+// Send resp once the activity event may be acknowledged. The task change is
+// already committed; with ACTIVITY_LOG_DURABILITY=flush an event that could
+// not be written is reported rather than answered with success
+std::function<void(bool)> respondAfterActivity(
+    std::function<void(const drogon::HttpResponsePtr&)> callback,
+    drogon::HttpResponsePtr resp
+) {
+    return [callback = std::move(callback), resp = std::move(resp)](bool written) {
+        if (written) {
+            callback(resp);
+            return;
+        }
+        Json::Value error;
+        error["error"] = "Change saved, but its activity could not be recorded";
+        auto errorResp = drogon::HttpResponse::newHttpJsonResponse(error);
+        errorResp->setStatusCode(drogon::k500InternalServerError);
+        callback(errorResp);
+    };
+}
+
+} // namespace
+
 void TaskController::createTask(
     const drogon::HttpRequestPtr& req,
     std::function<void(const drogon::HttpResponsePtr&)>&& callback
@@ -34,70 +61,60 @@ void TaskController::createTask(
         tagsJson = Json::writeString(writer, (*json)["tags"]);
     }
 
-    auto db = utils::Database::getClient();
-
-    // Use NULLIF to convert empty strings to NULL (avoids nullptr crash in Drogon)
-    db->execSqlAsync(
-        "SELECT * FROM create_task("
-        "$1::uuid, $2, $3, $4, "
-        "NULLIF($5,'')::uuid, "
-        "NULLIF($6,'')::timestamptz, "
-        "$7::jsonb, $8::uuid)",
-        [callback](const drogon::orm::Result& result) {
-            if (result.empty()) {
-                Json::Value error;
-                error["error"] = "Failed to create task";
-                auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
-                resp->setStatusCode(drogon::k500InternalServerError);
-                callback(resp);
+    utils::ProjectAccess::checkColumn(
+        userId,
+        columnId,
+        utils::ProjectAccess::Role::Member,
+        [columnId, title, description, priority, assigneeId, dueDate, tagsJson, userId, callback](utils::ProjectAccess::Access access) {
+            if (access != utils::ProjectAccess::Access::Allowed) {
+                callback(utils::ProjectAccess::errorResponse(access, "Column not found"));
                 return;
             }
 
-            auto row = result[0];
-            Json::Value task;
-            task["id"] = row["id"].as<std::string>();
-            task["column_id"] = row["column_id"].as<std::string>();
-            task["title"] = row["title"].as<std::string>();
-            if (!row["description"].isNull()) {
-                task["description"] = row["description"].as<std::string>();
-            }
-            task["priority"] = row["priority"].as<std::string>();
-            task["position"] = row["position"].as<int>();
-            if (!row["assignee_id"].isNull()) {
-                task["assignee_id"] = row["assignee_id"].as<std::string>();
-            }
-            if (!row["due_date"].isNull()) {
-                task["due_date"] = row["due_date"].as<std::string>();
-            }
-            if (!row["tags"].isNull()) {
-                Json::Reader reader;
-                Json::Value tagsArray;
-                if (reader.parse(row["tags"].as<std::string>(), tagsArray)) {
-                    task["tags"] = tagsArray;
-                }
-            }
-            task["created_at"] = row["created_at"].as<std::string>();
+            // Use NULLIF to convert empty strings to NULL (avoids nullptr crash in Drogon)
+            utils::Database::execute(
+                utils::Statements::CREATE_TASK,
+                [userId, callback](const drogon::orm::Result& result) {
+                    if (result.empty()) {
+                        Json::Value error;
+                        error["error"] = "Failed to create task";
+                        auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
+                        resp->setStatusCode(drogon::k500InternalServerError);
+                        callback(resp);
+                        return;
+                    }
 
-            auto resp = drogon::HttpResponse::newHttpJsonResponse(task);
-            resp->setStatusCode(drogon::k201Created);
-            callback(resp);
-        },
-        [callback](const drogon::orm::DrogonDbException& e) {
-            LOG_ERROR << "Create task error: " << e.base().what();
-            Json::Value error;
-            error["error"] = "Database error";
-            auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
-            resp->setStatusCode(drogon::k500InternalServerError);
-            callback(resp);
-        },
-        columnId,
-        title,
-        description,
-        priority,
-        assigneeId,
-        dueDate,
-        tagsJson,
-        userId
+                    Json::Value task = utils::TASK_MAPPER.object(result);
+                    utils::ProjectAccess::rememberTaskInColumn(task["id"].asString(), task["column_id"].asString());
+
+                    auto resp = drogon::HttpResponse::newHttpJsonResponse(task);
+                    resp->setStatusCode(drogon::k201Created);
+
+                    Json::Value details;
+                    details["title"] = task["title"];
+                    utils::ActivityLog::record(
+                        {result[0]["project_id"].as<std::string>(), userId, "created", "task", task["id"].asString(), details},
+                        respondAfterActivity(callback, resp)
+                    );
+                },
+                [callback](const drogon::orm::DrogonDbException& e) {
+                    LOG_ERROR << "Create task error: " << e.base().what();
+                    Json::Value error;
+                    error["error"] = "Database error";
+                    auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
+                    resp->setStatusCode(drogon::k500InternalServerError);
+                    callback(resp);
+                },
+                columnId,
+                title,
+                description,
+                priority,
+                assigneeId,
+                dueDate,
+                tagsJson,
+                userId
+            );
+        }
     );
 }
 
@@ -129,61 +146,57 @@ void TaskController::updateTask(
         tagsJson = Json::writeString(writer, (*json)["tags"]);
     }
 
-    auto db = utils::Database::getClient();
-
-    // Use NULLIF to convert empty strings to NULL (avoids nullptr crash in Drogon)
-    db->execSqlAsync(
-        "SELECT * FROM update_task("
-        "$1::uuid, "
-        "NULLIF($2,''), NULLIF($3,''), NULLIF($4,''), "
-        "NULLIF($5,'')::uuid, "
-        "NULLIF($6,'')::timestamptz, "
-        "NULLIF($7,'null')::jsonb, $8::uuid)",
-        [callback](const drogon::orm::Result& result) {
-            if (result.empty()) {
-                Json::Value error;
-                error["error"] = "Task not found";
-                auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
-                resp->setStatusCode(drogon::k404NotFound);
-                callback(resp);
+    utils::ProjectAccess::checkTask(
+        userId,
+        id,
+        utils::ProjectAccess::Role::Member,
+        [id, title, description, priority, assigneeId, dueDate, tagsJson, userId, callback](utils::ProjectAccess::Access access) {
+            if (access != utils::ProjectAccess::Access::Allowed) {
+                callback(utils::ProjectAccess::errorResponse(access, "Task not found"));
                 return;
             }
 
-            auto row = result[0];
-            Json::Value task;
-            task["id"] = row["id"].as<std::string>();
-            task["column_id"] = row["column_id"].as<std::string>();
-            task["title"] = row["title"].as<std::string>();
-            if (!row["description"].isNull()) {
-                task["description"] = row["description"].as<std::string>();
-            }
-            task["priority"] = row["priority"].as<std::string>();
-            task["position"] = row["position"].as<int>();
-            if (!row["assignee_id"].isNull()) {
-                task["assignee_id"] = row["assignee_id"].as<std::string>();
-            }
-            if (!row["due_date"].isNull()) {
-                task["due_date"] = row["due_date"].as<std::string>();
-            }
+            // Use NULLIF to convert empty strings to NULL (avoids nullptr crash in Drogon)
+            utils::Database::execute(
+                utils::Statements::UPDATE_TASK,
+                [userId, callback](const drogon::orm::Result& result) {
+                    if (result.empty()) {
+                        Json::Value error;
+                        error["error"] = "Task not found";
+                        auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
+                        resp->setStatusCode(drogon::k404NotFound);
+                        callback(resp);
+                        return;
+                    }
 
-            auto resp = drogon::HttpResponse::newHttpJsonResponse(task);
-            callback(resp);
-        },
-        [callback](const drogon::orm::DrogonDbException& e) {
-            Json::Value error;
-            error["error"] = "Database error";
-            auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
-            resp->setStatusCode(drogon::k500InternalServerError);
-            callback(resp);
-        },
-        id,
-        title,
-        description,
-        priority,
-        assigneeId,
-        dueDate,
-        tagsJson,
-        userId
+                    Json::Value task = utils::TASK_MAPPER.object(result);
+
+                    auto resp = drogon::HttpResponse::newHttpJsonResponse(task);
+
+                    Json::Value details;
+                    details["title"] = task["title"];
+                    utils::ActivityLog::record(
+                        {result[0]["project_id"].as<std::string>(), userId, "updated", "task", task["id"].asString(), details},
+                        respondAfterActivity(callback, resp)
+                    );
+                },
+                [callback](const drogon::orm::DrogonDbException& e) {
+                    Json::Value error;
+                    error["error"] = "Database error";
+                    auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
+                    resp->setStatusCode(drogon::k500InternalServerError);
+                    callback(resp);
+                },
+                id,
+                title,
+                description,
+                priority,
+                assigneeId,
+                dueDate,
+                tagsJson,
+                userId
+            );
+        }
     );
 }
 
@@ -203,25 +216,46 @@ void TaskController::deleteTask(
         return;
     }
 
-    auto db = utils::Database::getClient();
-    db->execSqlAsync(
-        "SELECT * FROM delete_task($1::uuid, $2::uuid)",
-        [callback](const drogon::orm::Result& result) {
-            Json::Value response;
-            response["success"] = true;
-
-            auto resp = drogon::HttpResponse::newHttpJsonResponse(response);
-            callback(resp);
-        },
-        [callback](const drogon::orm::DrogonDbException& e) {
-            Json::Value error;
-            error["error"] = "Database error";
-            auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
-            resp->setStatusCode(drogon::k500InternalServerError);
-            callback(resp);
-        },
+    utils::ProjectAccess::checkTask(
+        userId,
         id,
-        userId
+        utils::ProjectAccess::Role::Member,
+        [id, userId, callback](utils::ProjectAccess::Access access) {
+            if (access != utils::ProjectAccess::Access::Allowed) {
+                callback(utils::ProjectAccess::errorResponse(access, "Task not found"));
+                return;
+            }
+
+            utils::Database::execute(
+                utils::Statements::DELETE_TASK,
+                [id, userId, callback](const drogon::orm::Result& result) {
+                    Json::Value response;
+                    response["success"] = true;
+
+                    auto resp = drogon::HttpResponse::newHttpJsonResponse(response);
+                    if (result.empty()) {
+                        callback(resp);
+                        return;
+                    }
+
+                    Json::Value details;
+                    details["title"] = result[0]["title"].as<std::string>();
+                    utils::ActivityLog::record(
+                        {result[0]["project_id"].as<std::string>(), userId, "deleted", "task", id, details},
+                        respondAfterActivity(callback, resp)
+                    );
+                },
+                [callback](const drogon::orm::DrogonDbException& e) {
+                    Json::Value error;
+                    error["error"] = "Database error";
+                    auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
+                    resp->setStatusCode(drogon::k500InternalServerError);
+                    callback(resp);
+                },
+                id,
+                userId
+            );
+        }
     );
 }
 
@@ -242,29 +276,73 @@ void TaskController::moveTask(
     std::string userId = req->attributes()->get<std::string>(filters::AuthFilter::USER_ID_KEY);
     std::string taskId = (*json)["task_id"].asString();
     std::string columnId = (*json)["column_id"].asString();
+    // Index in the target column among its other tasks; move_task turns it
+    // into a rank between the neighbours at that index
     int position = json->isMember("position") ? (*json)["position"].asInt() : 0;
 
-    auto db = utils::Database::getClient();
-    db->execSqlAsync(
-        "SELECT * FROM move_task($1::uuid, $2::uuid, $3, $4::uuid)",
-        [callback](const drogon::orm::Result& result) {
-            Json::Value response;
-            response["success"] = true;
-
-            auto resp = drogon::HttpResponse::newHttpJsonResponse(response);
-            callback(resp);
-        },
-        [callback](const drogon::orm::DrogonDbException& e) {
-            Json::Value error;
-            error["error"] = "Database error";
-            auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
-            resp->setStatusCode(drogon::k500InternalServerError);
-            callback(resp);
-        },
+    // The caller must be a member of the task's project and of the target
+    // column's; move_task then refuses a column of any other project
+    utils::ProjectAccess::checkTask(
+        userId,
         taskId,
-        columnId,
-        position,
-        userId
+        utils::ProjectAccess::Role::Member,
+        [userId, taskId, columnId, position, callback](utils::ProjectAccess::Access access) {
+            if (access != utils::ProjectAccess::Access::Allowed) {
+                callback(utils::ProjectAccess::errorResponse(access, "Task not found"));
+                return;
+            }
+
+            utils::ProjectAccess::checkColumn(
+                userId,
+                columnId,
+                utils::ProjectAccess::Role::Member,
+                [userId, taskId, columnId, position, callback](utils::ProjectAccess::Access access) {
+                    if (access != utils::ProjectAccess::Access::Allowed) {
+                        callback(utils::ProjectAccess::errorResponse(access, "Column not found"));
+                        return;
+                    }
+
+                    utils::Database::execute(
+                        utils::Statements::MOVE_TASK,
+                        [userId, taskId, columnId, callback](const drogon::orm::Result& result) {
+                            // move_task refuses a column outside the task's project
+                            if (result.empty() || !result[0]["moved"].as<bool>()) {
+                                callback(utils::ProjectAccess::errorResponse(
+                                    utils::ProjectAccess::Access::NotFound, "Column not found"));
+                                return;
+                            }
+
+                            Json::Value response;
+                            response["success"] = true;
+
+                            auto resp = drogon::HttpResponse::newHttpJsonResponse(response);
+                            if (result[0]["project_id"].isNull()) {
+                                callback(resp);
+                                return;
+                            }
+
+                            Json::Value details;
+                            details["column"] = result[0]["column_name"].as<std::string>();
+                            utils::ActivityLog::record(
+                                {result[0]["project_id"].as<std::string>(), userId, "moved", "task", taskId, details},
+                                respondAfterActivity(callback, resp)
+                            );
+                        },
+                        [callback](const drogon::orm::DrogonDbException& e) {
+                            Json::Value error;
+                            error["error"] = "Database error";
+                            auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
+                            resp->setStatusCode(drogon::k500InternalServerError);
+                            callback(resp);
+                        },
+                        taskId,
+                        columnId,
+                        position,
+                        userId
+                    );
+                }
+            );
+        }
     );
 }
 
@@ -1,5 +1,7 @@
 #include "AuthFilter.h"
 #include "../utils/Session.h"
+#include "../utils/SessionRenewal.h"
+#include "../utils/SessionToken.h"
 
 namespace kanba {
 namespace filters {
@@ -22,11 +24,32 @@ void AuthFilter::doFilter(
         return;
     }
 
-    // Validate session and get user ID
-    utils::Session::getUserIdFromSession(
+    // Signed tokens are checked in memory; the profile is attached only if cached
+    if (utils::SessionToken::isEnabled()) {
+        auto userId = utils::Session::verifySignedSession(sessionId);
+        if (!userId) {
+            auto resp = drogon::HttpResponse::newHttpJsonResponse(
+                Json::Value(Json::objectValue)
+            );
+            (*resp->jsonObject())["error"] = "Unauthorized";
+            resp->setStatusCode(drogon::k401Unauthorized);
+            fcb(resp);
+            return;
+        }
+
+        req->attributes()->insert(USER_ID_KEY, *userId);
+        if (auto user = utils::SessionCache::get(sessionId)) {
+            req->attributes()->insert(USER_KEY, user);
+        }
+        fccb();
+        return;
+    }
+
+    // Validate session and get the user profile
+    utils::Session::getUserFromSession(
         sessionId,
-        [req, fcb = std::move(fcb), fccb = std::move(fccb)](std::optional<std::string> userId) mutable {
-            if (!userId.has_value()) {
+        [req, sessionId, fcb = std::move(fcb), fccb = std::move(fccb)](utils::SessionUserPtr user) mutable {
+            if (!user) {
                 auto resp = drogon::HttpResponse::newHttpJsonResponse(
                     Json::Value(Json::objectValue)
                 );
@@ -36,8 +59,15 @@ void AuthFilter::doFilter(
                 return;
             }
 
-            // Store user ID in request attributes for controllers to access
-            req->attributes()->insert(USER_ID_KEY, *userId);
+            // Store user ID and profile in request attributes for controllers to access
+            req->attributes()->insert(USER_ID_KEY, user->id);
+            req->attributes()->insert(USER_KEY, user);
+
+            // Sliding expiry: the row is extended by the background flusher and
+            // the cookie is re-sent by the post-handling advice in main.cpp
+            if (utils::SessionRenewal::touch(sessionId)) {
+                req->attributes()->insert(RENEWED_SESSION_KEY, sessionId);
+            }
 
             // Continue to the handler
             fccb();
@@ -17,6 +17,13 @@ public:
 
     // Key used to store user ID in request attributes
     static constexpr const char* USER_ID_KEY = "userId";
+
+    // Key used to store the user profile (utils::SessionUserPtr). In signed
+    // session mode it is only set when the profile is already cached.
+    static constexpr const char* USER_KEY = "user";
+
+    // Set (to the session ID) when this request queued a session renewal
+    static constexpr const char* RENEWED_SESSION_KEY = "renewedSession";
 };
 
 } // namespace filters
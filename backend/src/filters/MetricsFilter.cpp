@@ -0,0 +1,48 @@
+#include "MetricsFilter.h"
+#include "../utils/Config.h"
+#include <sodium.h>
+
+namespace kanba {
+namespace filters {
+
+namespace {
+
+const std::string& metricsToken() {
+    static const std::string token = utils::Config::getString("METRICS_TOKEN", "");
+    return token;
+}
+
+void reject(drogon::FilterCallback& fcb, drogon::HttpStatusCode status, const char* message) {
+    auto resp = drogon::HttpResponse::newHttpJsonResponse(Json::Value(Json::objectValue));
+    (*resp->jsonObject())["error"] = message;
+    resp->setStatusCode(status);
+    fcb(resp);
+}
+
+} // namespace
+
+void MetricsFilter::doFilter(
+    const drogon::HttpRequestPtr& req,
+    drogon::FilterCallback&& fcb,
+    drogon::FilterChainCallback&& fccb
+) {
+    const std::string& token = metricsToken();
+    if (token.empty()) {
+        reject(fcb, drogon::k404NotFound, "Not found");
+        return;
+    }
+
+    // Constant-time comparison, so the token cannot be guessed byte by byte
+    static const std::string prefix = "Bearer ";
+    const std::string& header = req->getHeader("authorization");
+    if (header.size() != prefix.size() + token.size() ||
+        header.compare(0, prefix.size(), prefix) != 0 ||
+        sodium_memcmp(header.data() + prefix.size(), token.data(), token.size()) != 0) {
+        reject(fcb, drogon::k401Unauthorized, "Unauthorized");
+        return;
+    }
+    fccb();
+}
+
+} // namespace filters
+} // namespace kanba
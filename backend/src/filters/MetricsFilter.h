@@ -0,0 +1,24 @@
+#pragma once
+
+#include <drogon/HttpFilter.h>
+
+namespace kanba {
+namespace filters {
+
+// Guards /api/metrics, which reports cache sizes, rate-limit counters, query
+// statistics and the database topology. Requests must carry
+// "Authorization: Bearer <METRICS_TOKEN>"; with METRICS_TOKEN unset the
+// endpoint answers 404. /api/health remains the only public probe.
+class MetricsFilter : public drogon::HttpFilter<MetricsFilter> {
+public:
+    MetricsFilter() = default;
+
+    void doFilter(
+        const drogon::HttpRequestPtr& req,
+        drogon::FilterCallback&& fcb,
+        drogon::FilterChainCallback&& fccb
+    ) override;
+};
+
+} // namespace filters
+} // namespace kanba
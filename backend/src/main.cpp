@@ -1,8 +1,26 @@
 #include <drogon/drogon.h>
+#include <algorithm>
 #include <cstdlib>
 #include <iostream>
+#include <thread>
+#include "filters/AuthFilter.h"
+#include "utils/ActivityLog.h"
+#include "utils/AuthAdmission.h"
+#include "utils/Config.h"
 #include "utils/Database.h"
+#include "utils/DbCircuitBreaker.h"
+#include "utils/HashExecutor.h"
+#include "utils/NegativeSessionCache.h"
 #include "utils/PasswordHash.h"
+#include "utils/ProjectAccess.h"
+#include "utils/RankRebalancer.h"
+#include "utils/Session.h"
+#include "utils/RevocationList.h"
+#include "utils/SessionCache.h"
+#include "utils/SessionReaper.h"
+#include "utils/SessionRenewal.h"
+#include "utils/SessionToken.h"
+#include "utils/SlowQueryLog.h"
 
 using namespace drogon;
 
@@ -33,24 +51,196 @@ int main() {
     std::cout << "Database: " << dbHost << ":" << dbPort << "/" << dbName << std::endl;
     std::cout << "Port: " << port << std::endl;
 
-    // Configure database connection
-    app().createDbClient(
-        "postgresql",           // rdbms
-        dbHost,                 // host
-        static_cast<unsigned short>(std::stoi(dbPort)),  // port
-        dbName,                 // dbname
-        dbUser,                 // user
-        dbPassword,             // password
-        10,                     // connection number
-        "",                     // filename (for sqlite)
-        "default",              // name
-        false,                  // is_fast
-        "",                     // characterSet
-        30.0,                   // timeout
-        false                   // autoBatch
+    // Database clients: DATABASE_FAST_CLIENTS=true gives every IO loop its own
+    // lock-free client with DATABASE_CONNECTIONS connections; otherwise all
+    // loops share one pool of DATABASE_CONNECTIONS
+    kanba::utils::Database::Options dbOptions;
+    dbOptions.host = dbHost;
+    dbOptions.port = static_cast<unsigned short>(std::stoi(dbPort));
+    dbOptions.name = dbName;
+    dbOptions.user = dbUser;
+    dbOptions.password = dbPassword;
+    dbOptions.connections = static_cast<size_t>(kanba::utils::Config::getInt("DATABASE_CONNECTIONS", 10));
+    dbOptions.fastClients = kanba::utils::Config::getBool("DATABASE_FAST_CLIENTS", false);
+    dbOptions.fallbackConnections = static_cast<size_t>(kanba::utils::Config::getInt("DATABASE_FALLBACK_CONNECTIONS", 2));
+    dbOptions.autoBatch = kanba::utils::Config::getBool("DATABASE_AUTO_BATCH", false);
+    dbOptions.timeoutSeconds = kanba::utils::Config::getDouble("DATABASE_TIMEOUT_SECONDS", 30.0);
+    dbOptions.queryDeadlineMs = static_cast<int>(kanba::utils::Config::getInt("DATABASE_QUERY_DEADLINE_MS", 10000));
+    // Read replica for the project read handlers (DATABASE_REPLICA_HOST unset: primary only)
+    dbOptions.replicaHost = kanba::utils::Config::getString("DATABASE_REPLICA_HOST", "");
+    dbOptions.replicaPort = static_cast<unsigned short>(kanba::utils::Config::getInt("DATABASE_REPLICA_PORT", 5432));
+    dbOptions.replicaConnections = static_cast<size_t>(kanba::utils::Config::getInt("DATABASE_REPLICA_CONNECTIONS", 10));
+    dbOptions.replicaPollMs = static_cast<int>(kanba::utils::Config::getInt("DATABASE_REPLICA_POLL_MS", 100));
+    dbOptions.replicaMaxLagMs = static_cast<int>(kanba::utils::Config::getInt("DATABASE_REPLICA_MAX_LAG_MS", 2000));
+    dbOptions.maxPinnedUsers = static_cast<size_t>(kanba::utils::Config::getInt("DATABASE_REPLICA_MAX_PINNED_USERS", 100000));
+    kanba::utils::Database::createClients(dbOptions);
+
+    // Fast-fail API requests with 503 while the database is unavailable or
+    // saturated, instead of queueing them behind the pool timeout
+    kanba::utils::DbCircuitBreaker::Options breakerOptions;
+    breakerOptions.enabled = kanba::utils::Config::getBool("DATABASE_BREAKER_ENABLED", true);
+    breakerOptions.maxInFlight = static_cast<size_t>(kanba::utils::Config::getInt("DATABASE_BREAKER_MAX_IN_FLIGHT", 200));
+    breakerOptions.latencyThresholdMs = kanba::utils::Config::getDouble("DATABASE_BREAKER_LATENCY_MS", 2000);
+    breakerOptions.failureRatio = kanba::utils::Config::getDouble("DATABASE_BREAKER_FAILURE_RATIO", 0.5);
+    breakerOptions.minSamples = static_cast<size_t>(kanba::utils::Config::getInt("DATABASE_BREAKER_MIN_SAMPLES", 20));
+    breakerOptions.openSeconds = static_cast<int>(kanba::utils::Config::getInt("DATABASE_BREAKER_OPEN_SECONDS", 5));
+    breakerOptions.halfOpenProbes = static_cast<size_t>(kanba::utils::Config::getInt("DATABASE_BREAKER_HALF_OPEN_PROBES", 5));
+    kanba::utils::DbCircuitBreaker::configure(breakerOptions);
+
+    // Slow queries are logged with their parameters redacted; with
+    // SLOW_QUERY_EXPLAIN a few read-only ones are re-run under EXPLAIN
+    // ANALYZE (rolled back) into a rotating plan log
+    kanba::utils::SlowQueryLog::Options slowQueryOptions;
+    slowQueryOptions.enabled = kanba::utils::Config::getBool("SLOW_QUERY_LOG_ENABLED", true);
+    slowQueryOptions.thresholdMs = kanba::utils::Config::getDouble("SLOW_QUERY_THRESHOLD_MS", 500);
+    slowQueryOptions.explain = kanba::utils::Config::getBool("SLOW_QUERY_EXPLAIN", false);
+    slowQueryOptions.explainIntervalSeconds = static_cast<int>(kanba::utils::Config::getInt("SLOW_QUERY_EXPLAIN_INTERVAL_SECONDS", 60));
+    slowQueryOptions.statementIntervalSeconds = static_cast<int>(kanba::utils::Config::getInt("SLOW_QUERY_STATEMENT_INTERVAL_SECONDS", 600));
+    slowQueryOptions.explainTimeoutMs = static_cast<int>(kanba::utils::Config::getInt("SLOW_QUERY_EXPLAIN_TIMEOUT_MS", 10000));
+    slowQueryOptions.path = kanba::utils::Config::getString("SLOW_QUERY_LOG_PATH", "logs/slow_queries.log");
+    slowQueryOptions.maxFileBytes = static_cast<size_t>(kanba::utils::Config::getInt("SLOW_QUERY_LOG_MAX_BYTES", 10 * 1024 * 1024));
+    slowQueryOptions.maxFiles = static_cast<size_t>(kanba::utils::Config::getInt("SLOW_QUERY_LOG_MAX_FILES", 5));
+    kanba::utils::SlowQueryLog::start(slowQueryOptions);
+
+    size_t serverThreads = static_cast<size_t>(std::max(1LL, kanba::utils::Config::getInt("SERVER_THREADS", 4)));
+    std::cout << "IO threads: " << serverThreads << ", database connections: " << dbOptions.connections
+              << (dbOptions.fastClients ? " per thread" : " shared") << std::endl;
+
+    // Session cache sizing (SESSION_CACHE_TTL_SECONDS=0 disables the cache)
+    kanba::utils::SessionCache::configure(
+        static_cast<size_t>(kanba::utils::Config::getInt("SESSION_CACHE_MAX_ENTRIES", 100000)),
+        std::chrono::seconds(kanba::utils::Config::getInt("SESSION_CACHE_TTL_SECONDS", 60))
+    );
+
+    // Negative session lookups: bad-cookie LRU plus a Bloom filter of live sessions
+    kanba::utils::NegativeSessionCache::configure(
+        static_cast<size_t>(kanba::utils::Config::getInt("SESSION_REJECT_CACHE_MAX_ENTRIES", 50000)),
+        std::chrono::seconds(kanba::utils::Config::getInt("SESSION_REJECT_CACHE_TTL_SECONDS", 30)),
+        static_cast<size_t>(kanba::utils::Config::getInt("SESSION_BLOOM_CAPACITY", 1000000)),
+        kanba::utils::Config::getBool("SESSION_BLOOM_ENABLED", true),
+        kanba::utils::Config::getDouble("SESSION_BLOOM_MISS_CHECKS_PER_SECOND", 20)
     );
 
-    // Handle CORS preflight OPTIONS requests before routing
+    // SESSION_MODE=signed issues stateless tokens instead of rows in sessions
+    if (kanba::utils::Config::getString("SESSION_MODE", "database") == "signed") {
+        if (!kanba::utils::SessionToken::configure(
+                kanba::utils::Config::getString("SESSION_SIGNING_KEYS", ""),
+                kanba::utils::Config::getString("SESSION_SIGNING_KEY_ID", ""))) {
+            LOG_FATAL << "SESSION_MODE=signed requires valid SESSION_SIGNING_KEYS";
+            return 1;
+        }
+        std::cout << "Session mode: signed tokens" << std::endl;
+    }
+
+    // Sliding expiry: active sessions are extended in batches, at most once per
+    // SESSION_RENEW_MIN_INTERVAL_SECONDS each (signed tokens carry a fixed expiry)
+    kanba::utils::SessionRenewal::configure(
+        kanba::utils::Config::getBool("SESSION_SLIDING_EXPIRY", true) && !kanba::utils::SessionToken::isEnabled(),
+        std::chrono::seconds(kanba::utils::Config::getInt("SESSION_RENEW_MIN_INTERVAL_SECONDS", 3600)),
+        std::chrono::seconds(kanba::utils::Session::SESSION_TTL_SECONDS)
+    );
+
+    // Expired session cleanup (SESSION_PARTITIONING=true expects the sessions
+    // table from database/sessions_partitioned.sql)
+    kanba::utils::SessionReaper::Options reaperOptions;
+    reaperOptions.interval = std::chrono::seconds(kanba::utils::Config::getInt("SESSION_REAPER_INTERVAL_SECONDS", 300));
+    reaperOptions.batchSize = static_cast<int>(kanba::utils::Config::getInt("SESSION_REAPER_BATCH_SIZE", 1000));
+    reaperOptions.batchPause = std::chrono::milliseconds(kanba::utils::Config::getInt("SESSION_REAPER_BATCH_PAUSE_MS", 100));
+    reaperOptions.partitioned = kanba::utils::Config::getBool("SESSION_PARTITIONING", false);
+    reaperOptions.partitionDaysAhead = static_cast<int>(kanba::utils::Config::getInt("SESSION_PARTITION_DAYS_AHEAD", 8));
+
+    // Renumbers task and column ranks that ran short of room between neighbours
+    kanba::utils::RankRebalancer::Options rebalanceOptions;
+    rebalanceOptions.interval = std::chrono::seconds(kanba::utils::Config::getInt("RANK_REBALANCE_INTERVAL_SECONDS", 30));
+    rebalanceOptions.batchSize = static_cast<int>(kanba::utils::Config::getInt("RANK_REBALANCE_BATCH_SIZE", 20));
+    rebalanceOptions.batchPause = std::chrono::milliseconds(kanba::utils::Config::getInt("RANK_REBALANCE_BATCH_PAUSE_MS", 100));
+
+    // Task activity is appended to activity_log in batches off the request
+    // path; ACTIVITY_LOG_DURABILITY=flush holds each response until its
+    // event is written, async (the default) acknowledges at once
+    kanba::utils::ActivityLog::Options activityOptions;
+    activityOptions.durability = kanba::utils::Config::getString("ACTIVITY_LOG_DURABILITY", "async") == "flush"
+        ? kanba::utils::ActivityLog::Durability::FlushBeforeAck
+        : kanba::utils::ActivityLog::Durability::Async;
+    activityOptions.flushInterval = std::chrono::milliseconds(kanba::utils::Config::getInt("ACTIVITY_LOG_FLUSH_MS", 250));
+    activityOptions.maxBatch = static_cast<size_t>(kanba::utils::Config::getInt("ACTIVITY_LOG_BATCH_SIZE", 500));
+    activityOptions.capacity = static_cast<size_t>(kanba::utils::Config::getInt("ACTIVITY_LOG_CAPACITY", 20000));
+    activityOptions.maxAttempts = static_cast<size_t>(kanba::utils::Config::getInt("ACTIVITY_LOG_MAX_ATTEMPTS", 3));
+    activityOptions.drainTimeout = std::chrono::milliseconds(kanba::utils::Config::getInt("ACTIVITY_LOG_DRAIN_MS", 5000));
+    kanba::utils::ActivityLog::configure(activityOptions);
+
+    app().registerBeginningAdvice([reaperOptions, rebalanceOptions]() {
+        kanba::utils::Database::startReplicaMonitor();
+        kanba::utils::SessionReaper::start(reaperOptions);
+        kanba::utils::RankRebalancer::start(rebalanceOptions);
+        kanba::utils::ActivityLog::start();
+        kanba::utils::SessionRenewal::startFlusher(
+            std::chrono::seconds(kanba::utils::Config::getInt("SESSION_RENEW_FLUSH_SECONDS", 5))
+        );
+
+        if (kanba::utils::SessionToken::isEnabled()) {
+            kanba::utils::RevocationList::startSync(
+                std::chrono::seconds(kanba::utils::Config::getInt("SESSION_REVOCATION_SYNC_SECONDS", 5))
+            );
+            return;
+        }
+        kanba::utils::NegativeSessionCache::startSync(
+            std::chrono::seconds(kanba::utils::Config::getInt("SESSION_BLOOM_REBUILD_SECONDS", 300)),
+            std::chrono::seconds(kanba::utils::Config::getInt("SESSION_BLOOM_SYNC_SECONDS", 5))
+        );
+    });
+
+    // Argon2id cost: tune ops/mem to HASH_TIME_BUDGET_MS on this machine
+    // (0 keeps libsodium's interactive limits). Existing hashes are upgraded
+    // on the next successful login.
+    long long hashBudgetMs = kanba::utils::Config::getInt("HASH_TIME_BUDGET_MS", 0);
+    if (hashBudgetMs > 0) {
+        kanba::utils::PasswordHash::calibrate(
+            std::chrono::milliseconds(hashBudgetMs),
+            static_cast<size_t>(kanba::utils::Config::getInt("HASH_MEMLIMIT_MB", 64)) * 1024 * 1024
+        );
+    }
+
+    // Password hashing pool: worker count is capped so that concurrent Argon2
+    // hashes never use more than HASH_MAX_MEMORY_MB in total
+    size_t defaultHashWorkers = std::max(1u, std::thread::hardware_concurrency() / 2);
+    size_t hashWorkers = static_cast<size_t>(
+        kanba::utils::Config::getInt("HASH_WORKERS", static_cast<long long>(defaultHashWorkers))
+    );
+    size_t hashMemoryBudget =
+        static_cast<size_t>(kanba::utils::Config::getInt("HASH_MAX_MEMORY_MB", 512)) * 1024 * 1024;
+    size_t maxHashWorkers = std::max<size_t>(1, hashMemoryBudget / kanba::utils::PasswordHash::memoryPerHash());
+    kanba::utils::HashExecutor::start(
+        std::min(hashWorkers, maxHashWorkers),
+        static_cast<size_t>(kanba::utils::Config::getInt("HASH_QUEUE_CAPACITY", 64))
+    );
+
+    // Login/registration admission control: per-IP and per-email token buckets
+    // plus a cap on attempts in flight (each one ends in an Argon2 hash)
+    kanba::utils::AuthAdmission::Options admissionOptions;
+    admissionOptions.enabled = kanba::utils::Config::getBool("AUTH_ADMISSION_ENABLED", true);
+    admissionOptions.ipRatePerMinute = kanba::utils::Config::getDouble("AUTH_IP_RATE_PER_MINUTE", 30);
+    admissionOptions.ipBurst = kanba::utils::Config::getDouble("AUTH_IP_BURST", 10);
+    admissionOptions.emailRatePerMinute = kanba::utils::Config::getDouble("AUTH_EMAIL_RATE_PER_MINUTE", 10);
+    admissionOptions.emailBurst = kanba::utils::Config::getDouble("AUTH_EMAIL_BURST", 5);
+    admissionOptions.maxInFlight = static_cast<size_t>(kanba::utils::Config::getInt(
+        "AUTH_MAX_IN_FLIGHT",
+        static_cast<long long>(std::min(hashWorkers, maxHashWorkers) +
+                               static_cast<size_t>(kanba::utils::Config::getInt("HASH_QUEUE_CAPACITY", 64)))
+    ));
+    admissionOptions.maxTrackedKeys = static_cast<size_t>(kanba::utils::Config::getInt("AUTH_MAX_TRACKED_KEYS", 100000));
+    kanba::utils::AuthAdmission::configure(admissionOptions);
+
+    // Project membership cache and column/task -> project resolver used by
+    // the project, column and task routes
+    kanba::utils::ProjectAccess::configure(
+        static_cast<size_t>(kanba::utils::Config::getInt("PROJECT_ACCESS_MAX_USERS", 100000)),
+        static_cast<size_t>(kanba::utils::Config::getInt("PROJECT_ACCESS_MAX_RESOLVED", 1000000)),
+        std::chrono::seconds(kanba::utils::Config::getInt("PROJECT_ACCESS_TTL_SECONDS", 30))
+    );
+
+    // Handle CORS preflight OPTIONS requests before routing, and shed API
+    // requests while the database circuit is open
     app().registerPreRoutingAdvice(
         [](const drogon::HttpRequestPtr& req,
            drogon::AdviceCallback&& acb,
@@ -69,6 +259,25 @@ int main() {
                 acb(resp);
                 return;
             }
+
+            // Health and the token-guarded metrics stay up to report the outage
+            const std::string& path = req->path();
+            uint64_t probe = 0;
+            if (path.rfind("/api/", 0) == 0 && path != "/api/health" && path != "/api/metrics" &&
+                !kanba::utils::DbCircuitBreaker::allowRequest(probe)) {
+                Json::Value error;
+                error["error"] = "Database unavailable, please retry shortly";
+                auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
+                resp->setStatusCode(drogon::k503ServiceUnavailable);
+                resp->addHeader("Retry-After", std::to_string(kanba::utils::DbCircuitBreaker::retryAfterSeconds()));
+                resp->addHeader("Access-Control-Allow-Origin", origin);
+                resp->addHeader("Access-Control-Allow-Credentials", "true");
+                acb(resp);
+                return;
+            }
+            // Routing continues on this thread, so the handler's first queries
+            // (and those chained from their callbacks) carry the probe
+            kanba::utils::DbCircuitBreaker::ProbeScope scope(probe);
             accb();
         }
     );
@@ -83,13 +292,37 @@ int main() {
             resp->addHeader("Access-Control-Allow-Methods", "GET, POST, PUT, DELETE, OPTIONS");
             resp->addHeader("Access-Control-Allow-Headers", "Content-Type, Authorization");
             resp->addHeader("Access-Control-Max-Age", "86400");
+
+            // A successful authenticated write pins the user's reads to the
+            // primary until the replica has replayed it
+            if (req->method() != drogon::Get && req->method() != drogon::Options &&
+                resp->statusCode() < drogon::k300MultipleChoices &&
+                req->attributes()->find(kanba::filters::AuthFilter::USER_ID_KEY)) {
+                kanba::utils::Database::markWrite(
+                    req->attributes()->get<std::string>(kanba::filters::AuthFilter::USER_ID_KEY)
+                );
+            }
+
+            // Re-send the session cookie when AuthFilter renewed the session
+            if (req->attributes()->find(kanba::filters::AuthFilter::RENEWED_SESSION_KEY)) {
+                resp->addCookie(kanba::utils::Session::makeCookie(
+                    req->attributes()->get<std::string>(kanba::filters::AuthFilter::RENEWED_SESSION_KEY)
+                ));
+            }
         }
     );
 
     // Configure app settings
     app().setLogLevel(trantor::Logger::kInfo);
     app().addListener("0.0.0.0", static_cast<uint16_t>(std::stoi(port)));
-    app().setThreadNum(4);
+    app().setThreadNum(serverThreads);
+
+    // On SIGTERM/SIGINT write out queued activity before the loops stop
+    auto drainAndQuit = [] {
+        kanba::utils::ActivityLog::stop([] { app().quit(); });
+    };
+    app().setTermSignalHandler(drainAndQuit);
+    app().setIntSignalHandler(drainAndQuit);
 
     // Log startup
     LOG_INFO << "Kanba C++ Backend starting on port " << port;
@@ -97,5 +330,8 @@ int main() {
     // Run the application
     app().run();
 
+    kanba::utils::HashExecutor::stop();
+    kanba::utils::SlowQueryLog::stop();
+
     return 0;
 }
@@ -0,0 +1,332 @@
+#include "ActivityLog.h"
+#include "Database.h"
+#include <uuid/uuid.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace kanba {
+namespace utils {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Queued {
+    ActivityLog::Event event;
+    std::function<void(bool)> done; // FlushBeforeAck only
+    Clock::time_point recordedAt;
+    double createdAt;               // seconds since the epoch, for created_at
+    std::string id;                 // activity_log.id, so a retried batch inserts each row once
+    size_t attempts = 0;
+};
+
+using Batch = std::shared_ptr<std::vector<Queued>>;
+
+ActivityLog::Options options;       // written once by configure()
+
+std::mutex queueMutex;
+std::vector<Queued> queue;
+
+std::atomic<bool> flushing{false};          // one batch sequence at a time
+std::atomic<bool> flushScheduled{false};    // an early flush is queued on the main loop
+std::atomic<bool> stopping{false};
+std::atomic<int64_t> inFlightSince{0};      // recordedAt of the oldest event being written, 0 if none
+std::atomic<uint64_t> inFlight{0};
+
+std::atomic<uint64_t> recorded{0};
+std::atomic<uint64_t> written{0};
+std::atomic<uint64_t> dropped{0};
+std::atomic<uint64_t> failed{0};
+std::atomic<uint64_t> retried{0};
+std::atomic<uint64_t> batches{0};
+std::atomic<int64_t> maxLagUs{0};
+
+int64_t ticks(Clock::time_point at) {
+    return at.time_since_epoch().count();
+}
+
+// Quoted Postgres array element; an empty value is NULL when nullable
+void appendElement(std::string& literal, const std::string& value, bool nullable) {
+    if (literal.size() > 1) {
+        literal += ',';
+    }
+    if (nullable && value.empty()) {
+        literal += "NULL";
+        return;
+    }
+    literal += '"';
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            literal += '\\';
+        }
+        literal += c;
+    }
+    literal += '"';
+}
+
+void scheduleFlush();
+void writeBatch(const Batch& events, size_t offset);
+
+std::string newEventId() {
+    uuid_t uuid;
+    char uuidStr[37];
+    uuid_generate_random(uuid);
+    uuid_unparse_lower(uuid, uuidStr);
+    return std::string(uuidStr);
+}
+
+// After a failed batch the next attempt waits for the timer, not a full queue
+void finishFlush(bool backOff) {
+    inFlightSince.store(0, std::memory_order_relaxed);
+    size_t waiting;
+    {
+        std::lock_guard lock(queueMutex);
+        waiting = queue.size();
+    }
+    flushing.store(false, std::memory_order_release);
+    if (!backOff && waiting >= options.maxBatch) {
+        scheduleFlush();
+    }
+}
+
+void acknowledge(Queued& queued, bool written) {
+    if (queued.done) {
+        queued.done(written);
+    }
+}
+
+// Acknowledge the events of a written batch and write the next one. A failed
+// batch goes back to the front of the queue, with the rest of this flush,
+// until its events have had maxAttempts tries; then they are acknowledged as
+// not written.
+void settle(const Batch& events, size_t offset, size_t end, bool written) {
+    if (written) {
+        inFlight.fetch_sub(end - offset, std::memory_order_relaxed);
+        for (size_t i = offset; i < end; ++i) {
+            acknowledge((*events)[i], true);
+        }
+        if (end < events->size()) {
+            writeBatch(events, end);
+        } else {
+            finishFlush(false);
+        }
+        return;
+    }
+
+    std::vector<Queued> retry;
+    for (size_t i = offset; i < end; ++i) {
+        auto& queued = (*events)[i];
+        if (++queued.attempts < options.maxAttempts) {
+            retry.push_back(std::move(queued));
+        } else {
+            failed.fetch_add(1, std::memory_order_relaxed);
+            acknowledge(queued, false);
+        }
+    }
+    retried.fetch_add(retry.size(), std::memory_order_relaxed);
+    retry.insert(retry.end(), std::make_move_iterator(events->begin() + static_cast<std::ptrdiff_t>(end)),
+                 std::make_move_iterator(events->end()));
+    {
+        std::lock_guard lock(queueMutex);
+        inFlight.fetch_sub(events->size() - offset, std::memory_order_relaxed);
+        queue.insert(queue.begin(), std::make_move_iterator(retry.begin()), std::make_move_iterator(retry.end()));
+    }
+    finishFlush(true);
+}
+
+void writeBatch(const Batch& events, size_t offset) {
+    size_t end = std::min(events->size(), offset + options.maxBatch);
+    inFlightSince.store(ticks((*events)[offset].recordedAt), std::memory_order_relaxed);
+
+    std::string ids = "{", projectIds = "{", userIds = "{", actions = "{", entityTypes = "{",
+                entityIds = "{", details = "{", createdAt = "{";
+    Json::StreamWriterBuilder writer;
+    writer["indentation"] = "";
+    char seconds[32];
+    for (size_t i = offset; i < end; ++i) {
+        const auto& queued = (*events)[i];
+        appendElement(ids, queued.id, false);
+        appendElement(projectIds, queued.event.projectId, false);
+        appendElement(userIds, queued.event.userId, true);
+        appendElement(actions, queued.event.action, false);
+        appendElement(entityTypes, queued.event.entityType, false);
+        appendElement(entityIds, queued.event.entityId, false);
+        appendElement(details, Json::writeString(writer, queued.event.details), false);
+        std::snprintf(seconds, sizeof(seconds), "%.6f", queued.createdAt);
+        appendElement(createdAt, seconds, false);
+    }
+    for (auto* literal : {&ids, &projectIds, &userIds, &actions, &entityTypes, &entityIds, &details, &createdAt}) {
+        *literal += '}';
+    }
+
+    Database::execute(
+        Statements::INSERT_ACTIVITY_BATCH,
+        [events, offset, end](const drogon::orm::Result&) {
+            written.fetch_add(end - offset, std::memory_order_relaxed);
+            batches.fetch_add(1, std::memory_order_relaxed);
+            int64_t lagUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                Clock::now() - (*events)[offset].recordedAt).count();
+            if (lagUs > maxLagUs.load(std::memory_order_relaxed)) {
+                maxLagUs.store(lagUs, std::memory_order_relaxed);   // batches complete one at a time
+            }
+            settle(events, offset, end, true);
+        },
+        [events, offset, end](const drogon::orm::DrogonDbException& e) {
+            LOG_ERROR << "Failed to write " << (end - offset) << " activity log entries: " << e.base().what();
+            settle(events, offset, end, false);
+        },
+        ids, projectIds, userIds, actions, entityTypes, entityIds, details, createdAt
+    );
+}
+
+// Main loop only (timer or scheduleFlush)
+void flush() {
+    if (flushing.exchange(true, std::memory_order_acquire)) {
+        return;  // the running flush reschedules if a full batch is waiting
+    }
+
+    auto events = std::make_shared<std::vector<Queued>>();
+    {
+        std::lock_guard lock(queueMutex);
+        events->swap(queue);
+        inFlight.fetch_add(events->size(), std::memory_order_relaxed);
+    }
+    if (events->empty()) {
+        flushing.store(false, std::memory_order_release);
+        return;
+    }
+    writeBatch(events, 0);
+}
+
+void scheduleFlush() {
+    if (flushScheduled.exchange(true, std::memory_order_relaxed)) {
+        return;
+    }
+    drogon::app().getLoop()->queueInLoop([] {
+        flushScheduled.store(false, std::memory_order_relaxed);
+        flush();
+    });
+}
+
+// Flush until nothing is queued or being written, or the deadline passes
+void drain(Clock::time_point deadline, std::function<void()> done) {
+    size_t pending;
+    {
+        std::lock_guard lock(queueMutex);
+        pending = queue.size() + inFlight.load(std::memory_order_relaxed);
+    }
+    if (pending == 0) {
+        LOG_INFO << "Activity log drained";
+        done();
+        return;
+    }
+    if (Clock::now() >= deadline) {
+        LOG_WARN << "Activity log: " << pending << " events not written at shutdown";
+        done();
+        return;
+    }
+    flush();
+    drogon::app().getLoop()->runAfter(0.05, [deadline, done = std::move(done)]() mutable {
+        drain(deadline, std::move(done));
+    });
+}
+
+} // namespace
+
+void ActivityLog::configure(const Options& newOptions) {
+    options = newOptions;
+    options.maxBatch = std::max<size_t>(1, options.maxBatch);
+    options.maxAttempts = std::max<size_t>(1, options.maxAttempts);
+}
+
+void ActivityLog::start() {
+    drogon::app().getLoop()->runEvery(
+        std::chrono::duration<double>(options.flushInterval).count(),
+        [] { flush(); }
+    );
+    LOG_INFO << "Activity log: batches of up to " << options.maxBatch << " every "
+             << options.flushInterval.count() << " ms"
+             << (options.durability == Durability::FlushBeforeAck ? ", flushed before ack" : ", async");
+}
+
+void ActivityLog::record(Event event, std::function<void(bool written)> done) {
+    bool holdAck = options.durability == Durability::FlushBeforeAck;
+    std::string id = newEventId();
+    size_t waiting;
+    {
+        std::lock_guard lock(queueMutex);
+        if (queue.size() >= options.capacity) {
+            waiting = 0;
+        } else {
+            auto now = std::chrono::system_clock::now();
+            queue.push_back(Queued{
+                std::move(event),
+                holdAck ? std::move(done) : nullptr,
+                Clock::now(),
+                std::chrono::duration<double>(now.time_since_epoch()).count(),
+                std::move(id)
+            });
+            waiting = queue.size();
+        }
+    }
+
+    if (waiting == 0) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        recorded.fetch_add(1, std::memory_order_relaxed);
+        if (waiting >= options.maxBatch) {
+            scheduleFlush();
+        }
+        if (holdAck) {
+            return;
+        }
+    }
+    // Async promises nothing about storage; FlushBeforeAck lost this one
+    if (done) {
+        done(!holdAck);
+    }
+}
+
+void ActivityLog::stop(std::function<void()> done) {
+    if (stopping.exchange(true)) {
+        done();  // a second signal does not wait again
+        return;
+    }
+    drogon::app().getLoop()->queueInLoop([done = std::move(done)]() mutable {
+        drain(Clock::now() + options.drainTimeout, std::move(done));
+    });
+}
+
+ActivityLog::Stats ActivityLog::stats() {
+    Stats result;
+    result.recorded = recorded.load(std::memory_order_relaxed);
+    result.written = written.load(std::memory_order_relaxed);
+    result.dropped = dropped.load(std::memory_order_relaxed);
+    result.failed = failed.load(std::memory_order_relaxed);
+    result.retried = retried.load(std::memory_order_relaxed);
+    result.batches = batches.load(std::memory_order_relaxed);
+    result.maxLagMs = static_cast<double>(maxLagUs.load(std::memory_order_relaxed)) / 1000.0;
+
+    auto now = Clock::now();
+    int64_t oldest = inFlightSince.load(std::memory_order_relaxed);
+    {
+        std::lock_guard lock(queueMutex);
+        result.pending = queue.size() + inFlight.load(std::memory_order_relaxed);
+        if (oldest == 0 && !queue.empty()) {
+            oldest = ticks(queue.front().recordedAt);
+        }
+    }
+    if (oldest != 0) {
+        result.lagMs = std::chrono::duration<double, std::milli>(
+            now - Clock::time_point(Clock::duration(oldest))).count();
+    }
+    return result;
+}
+
+} // namespace utils
+} // namespace kanba
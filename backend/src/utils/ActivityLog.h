@@ -0,0 +1,86 @@
+#pragma once
+
+#include <json/json.h>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace kanba {
+namespace utils {
+
+// Write-behind activity log for task changes. The task functions no longer
+// insert into activity_log inside the request's transaction; the handler
+// records the event here and a timer on the main loop appends everything
+// queued with one multi-row INSERT per batch, every flushInterval or as soon
+// as maxBatch events are waiting. The queue is bounded: past capacity,
+// events are dropped and counted rather than held or waited for.
+//
+// A batch the database rejects is retried on later flushes, up to
+// maxAttempts tries per event; each event carries its own activity_log.id,
+// so a batch that timed out but did commit is not inserted twice.
+//
+// Durability is chosen per deployment. Async acknowledges the request at
+// once, so events still queued are lost if the process dies. FlushBeforeAck
+// holds each response until the batch carrying its event was written, which
+// adds up to flushInterval of latency but still keeps the insert out of the
+// task write and shares it between requests; an event that was dropped or
+// whose retries ran out is acknowledged as not written.
+class ActivityLog {
+public:
+    enum class Durability {
+        Async,
+        FlushBeforeAck
+    };
+
+    struct Options {
+        Durability durability = Durability::Async;
+        std::chrono::milliseconds flushInterval{250};
+        size_t maxBatch = 500;      // events per INSERT
+        size_t capacity = 20000;    // queued events beyond this are dropped
+        size_t maxAttempts = 3;     // tries per event before it counts as failed
+        std::chrono::milliseconds drainTimeout{5000};   // longest stop() waits
+    };
+
+    struct Event {
+        std::string projectId;
+        std::string userId;         // empty when there is none
+        std::string action;         // created, updated, moved, deleted
+        std::string entityType;     // task
+        std::string entityId;
+        Json::Value details;        // stored as activity_log.details
+    };
+
+    struct Stats {
+        uint64_t recorded = 0;
+        uint64_t written = 0;
+        uint64_t dropped = 0;       // queue full
+        uint64_t failed = 0;        // gave up after maxAttempts
+        uint64_t retried = 0;       // requeued after a rejected batch
+        uint64_t batches = 0;
+        uint64_t pending = 0;       // queued or being written
+        double lagMs = 0;           // age of the oldest event not yet written
+        double maxLagMs = 0;        // longest time from record to written
+    };
+
+    // Set the policy (call once at startup, before serving requests)
+    static void configure(const Options& options);
+
+    // Schedule the flush timer; must run on a started app
+    static void start();
+
+    // Queue an event. done runs when the caller may respond: right away for
+    // Async (written is then always true), once the event was written or
+    // given up on for FlushBeforeAck
+    static void record(Event event, std::function<void(bool written)> done);
+
+    // Write out everything queued, then run done on the main loop; call it
+    // before quitting the app, so a clean shutdown loses no events. Gives
+    // up after drainTimeout and logs how many events were not written
+    static void stop(std::function<void()> done);
+
+    static Stats stats();
+};
+
+} // namespace utils
+} // namespace kanba
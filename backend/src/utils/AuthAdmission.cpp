@@ -0,0 +1,173 @@
+#include "AuthAdmission.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <mutex>
+#include <unordered_map>
+
+namespace kanba {
+namespace utils {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t SHARD_COUNT = 16;
+
+struct Bucket {
+    double tokens = 0;
+    double ratePerMinute = 0;
+    double burst = 0;
+    Clock::time_point refilledAt;
+};
+
+struct alignas(64) Shard {
+    std::mutex mutex;
+    std::unordered_map<std::string, Bucket> buckets;
+};
+
+std::array<Shard, SHARD_COUNT> shards;
+
+// Written once by configure(), read-only afterwards
+AuthAdmission::Options options;
+
+std::atomic<size_t> inFlight{0};
+
+std::atomic<uint64_t> admitted{0};
+std::atomic<uint64_t> rejectedIp{0};
+std::atomic<uint64_t> rejectedEmail{0};
+std::atomic<uint64_t> rejectedOverload{0};
+
+Shard& shardFor(const std::string& key) {
+    return shards[std::hash<std::string>{}(key) % SHARD_COUNT];
+}
+
+void refill(Bucket& bucket, Clock::time_point now) {
+    double elapsedMinutes = std::chrono::duration<double, std::ratio<60>>(now - bucket.refilledAt).count();
+    bucket.tokens = std::min(bucket.burst, bucket.tokens + elapsedMinutes * bucket.ratePerMinute);
+    bucket.refilledAt = now;
+}
+
+// Make room for a new key. Buckets that have refilled completely behave like
+// absent ones and go first; if none have, drop an arbitrary one.
+void makeRoom(Shard& shard, Clock::time_point now) {
+    for (auto it = shard.buckets.begin(); it != shard.buckets.end();) {
+        refill(it->second, now);
+        if (it->second.tokens >= it->second.burst) {
+            it = shard.buckets.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    if (shard.buckets.size() >= options.maxTrackedKeys / SHARD_COUNT) {
+        shard.buckets.erase(shard.buckets.begin());
+    }
+}
+
+bool take(const std::string& key, double ratePerMinute, double burst) {
+    auto now = Clock::now();
+    auto& shard = shardFor(key);
+    std::lock_guard lock(shard.mutex);
+
+    auto it = shard.buckets.find(key);
+    if (it == shard.buckets.end()) {
+        if (shard.buckets.size() >= options.maxTrackedKeys / SHARD_COUNT) {
+            makeRoom(shard, now);
+        }
+        it = shard.buckets.emplace(key, Bucket{burst, ratePerMinute, burst, now}).first;
+    } else {
+        refill(it->second, now);
+    }
+
+    if (it->second.tokens < 1.0) {
+        return false;
+    }
+    it->second.tokens -= 1.0;
+    return true;
+}
+
+std::string normalizeEmail(const std::string& email) {
+    std::string normalized = email;
+    std::transform(normalized.begin(), normalized.end(), normalized.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return normalized;
+}
+
+} // namespace
+
+void AuthAdmission::configure(const Options& opts) {
+    options = opts;
+    options.ipBurst = std::max(1.0, options.ipBurst);
+    options.emailBurst = std::max(1.0, options.emailBurst);
+    options.maxInFlight = std::max<size_t>(1, options.maxInFlight);
+    options.maxTrackedKeys = std::max(SHARD_COUNT, options.maxTrackedKeys);
+}
+
+AuthAdmission::Result AuthAdmission::admit(const std::string& ip, const std::string& email) {
+    Result result;
+    if (!options.enabled) {
+        return result;
+    }
+
+    // Cheapest and most global check first
+    if (inFlight.fetch_add(1, std::memory_order_acq_rel) >= options.maxInFlight) {
+        inFlight.fetch_sub(1, std::memory_order_acq_rel);
+        rejectedOverload.fetch_add(1, std::memory_order_relaxed);
+        result.decision = Decision::Overloaded;
+        return result;
+    }
+    Permit permit(nullptr, [](void*) { inFlight.fetch_sub(1, std::memory_order_acq_rel); });
+
+    if (!take("ip:" + ip, options.ipRatePerMinute, options.ipBurst)) {
+        rejectedIp.fetch_add(1, std::memory_order_relaxed);
+        result.decision = Decision::IpRateLimited;
+        return result;
+    }
+
+    if (!take("email:" + normalizeEmail(email), options.emailRatePerMinute, options.emailBurst)) {
+        rejectedEmail.fetch_add(1, std::memory_order_relaxed);
+        result.decision = Decision::EmailRateLimited;
+        return result;
+    }
+
+    admitted.fetch_add(1, std::memory_order_relaxed);
+    result.permit = std::move(permit);
+    return result;
+}
+
+int AuthAdmission::retryAfterSeconds(Decision decision) {
+    double ratePerMinute = 0;
+    switch (decision) {
+        case Decision::IpRateLimited:
+            ratePerMinute = options.ipRatePerMinute;
+            break;
+        case Decision::EmailRateLimited:
+            ratePerMinute = options.emailRatePerMinute;
+            break;
+        default:
+            return 1;
+    }
+    if (ratePerMinute <= 0) {
+        return 60;
+    }
+    return std::max(1, static_cast<int>(std::ceil(60.0 / ratePerMinute)));
+}
+
+AuthAdmission::Stats AuthAdmission::stats() {
+    Stats result;
+    result.admitted = admitted.load(std::memory_order_relaxed);
+    result.rejectedIp = rejectedIp.load(std::memory_order_relaxed);
+    result.rejectedEmail = rejectedEmail.load(std::memory_order_relaxed);
+    result.rejectedOverload = rejectedOverload.load(std::memory_order_relaxed);
+    result.inFlight = inFlight.load(std::memory_order_relaxed);
+    for (auto& shard : shards) {
+        std::lock_guard lock(shard.mutex);
+        result.trackedKeys += shard.buckets.size();
+    }
+    return result;
+}
+
+} // namespace utils
+} // namespace kanba
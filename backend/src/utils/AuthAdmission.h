@@ -0,0 +1,65 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace kanba {
+namespace utils {
+
+// Admission control for login and registration, checked before any DB query
+// or password hash. An attempt must get a token from both the client IP's and
+// the email's token bucket, and a slot under the global cap on in-flight
+// attempts (each of which ends in an Argon2 hash). Buckets live in a sharded
+// in-memory table, so limits are per backend instance.
+class AuthAdmission {
+public:
+    struct Options {
+        bool enabled = true;
+        double ipRatePerMinute = 30;
+        double ipBurst = 10;
+        double emailRatePerMinute = 10;
+        double emailBurst = 5;
+        size_t maxInFlight = 64;
+        size_t maxTrackedKeys = 100000;
+    };
+
+    enum class Decision {
+        Admitted,
+        IpRateLimited,
+        EmailRateLimited,
+        Overloaded
+    };
+
+    // Holds an in-flight slot until the last copy is destroyed
+    using Permit = std::shared_ptr<void>;
+
+    struct Result {
+        Decision decision = Decision::Admitted;
+        Permit permit;
+    };
+
+    struct Stats {
+        uint64_t admitted = 0;
+        uint64_t rejectedIp = 0;
+        uint64_t rejectedEmail = 0;
+        uint64_t rejectedOverload = 0;
+        uint64_t inFlight = 0;
+        uint64_t trackedKeys = 0;
+    };
+
+    // Set limits (call once at startup, before serving requests)
+    static void configure(const Options& options);
+
+    // Take tokens for this attempt; keep result.permit alive until it finishes
+    static Result admit(const std::string& ip, const std::string& email);
+
+    // Seconds until the limiting bucket has a token again (for Retry-After)
+    static int retryAfterSeconds(Decision decision);
+
+    static Stats stats();
+};
+
+} // namespace utils
+} // namespace kanba
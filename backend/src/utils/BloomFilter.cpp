@@ -0,0 +1,65 @@
+#include "BloomFilter.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+namespace kanba {
+namespace utils {
+
+namespace {
+
+// FNV-1a, used as the second independent hash for double hashing
+uint64_t fnv1a(std::string_view key) {
+    uint64_t hash = 1469598103934665603ULL;
+    for (unsigned char c : key) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+} // namespace
+
+BloomFilter::BloomFilter(size_t expectedEntries, double falsePositiveRate) {
+    expectedEntries = std::max<size_t>(expectedEntries, 1);
+    falsePositiveRate = std::clamp(falsePositiveRate, 1e-6, 0.5);
+
+    // Standard sizing: m = -n ln(p) / (ln 2)^2, k = (m / n) ln 2
+    double ln2 = std::log(2.0);
+    double bits = -static_cast<double>(expectedEntries) * std::log(falsePositiveRate) / (ln2 * ln2);
+    numBits_ = std::max<size_t>(64, static_cast<size_t>(std::ceil(bits / 64.0)) * 64);
+    numHashes_ = std::clamp<size_t>(
+        static_cast<size_t>(std::round(bits / static_cast<double>(expectedEntries) * ln2)), 1, 16
+    );
+
+    size_t words = numBits_ / 64;
+    words_ = std::make_unique<std::atomic<uint64_t>[]>(words);
+    for (size_t i = 0; i < words; ++i) {
+        words_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void BloomFilter::add(std::string_view key) {
+    uint64_t h1 = std::hash<std::string_view>{}(key);
+    uint64_t h2 = fnv1a(key) | 1;
+    for (size_t i = 0; i < numHashes_; ++i) {
+        uint64_t bit = (h1 + i * h2) % numBits_;
+        words_[bit / 64].fetch_or(uint64_t{1} << (bit % 64), std::memory_order_relaxed);
+    }
+    entries_.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool BloomFilter::mightContain(std::string_view key) const {
+    uint64_t h1 = std::hash<std::string_view>{}(key);
+    uint64_t h2 = fnv1a(key) | 1;
+    for (size_t i = 0; i < numHashes_; ++i) {
+        uint64_t bit = (h1 + i * h2) % numBits_;
+        if ((words_[bit / 64].load(std::memory_order_relaxed) & (uint64_t{1} << (bit % 64))) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace utils
+} // namespace kanba
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+namespace kanba {
+namespace utils {
+
+// Fixed-size Bloom filter with lock-free add and lookup, so the IO loops can
+// query it while another thread inserts. Sized once at construction for an
+// expected number of entries and a target false-positive rate.
+class BloomFilter {
+public:
+    BloomFilter(size_t expectedEntries, double falsePositiveRate);
+
+    void add(std::string_view key);
+
+    // False means the key was definitely never added
+    bool mightContain(std::string_view key) const;
+
+    size_t bitCount() const { return numBits_; }
+    size_t hashCount() const { return numHashes_; }
+    size_t entryCount() const { return entries_.load(std::memory_order_relaxed); }
+
+private:
+    size_t numBits_;
+    size_t numHashes_;
+    std::unique_ptr<std::atomic<uint64_t>[]> words_;
+    std::atomic<size_t> entries_{0};
+};
+
+} // namespace utils
+} // namespace kanba
@@ -0,0 +1,56 @@
+#include "Config.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <drogon/drogon.h>
+
+namespace kanba {
+namespace utils {
+
+std::string Config::getString(const char* name, const std::string& defaultValue) {
+    const char* value = std::getenv(name);
+    return value ? std::string(value) : defaultValue;
+}
+
+long long Config::getInt(const char* name, long long defaultValue) {
+    const char* value = std::getenv(name);
+    if (!value || *value == '\0') {
+        return defaultValue;
+    }
+
+    try {
+        return std::stoll(value);
+    } catch (const std::exception&) {
+        LOG_WARN << "Ignoring invalid integer value for " << name << ": " << value;
+        return defaultValue;
+    }
+}
+
+double Config::getDouble(const char* name, double defaultValue) {
+    const char* value = std::getenv(name);
+    if (!value || *value == '\0') {
+        return defaultValue;
+    }
+
+    try {
+        return std::stod(value);
+    } catch (const std::exception&) {
+        LOG_WARN << "Ignoring invalid numeric value for " << name << ": " << value;
+        return defaultValue;
+    }
+}
+
+bool Config::getBool(const char* name, bool defaultValue) {
+    const char* value = std::getenv(name);
+    if (!value || *value == '\0') {
+        return defaultValue;
+    }
+
+    std::string normalized(value);
+    std::transform(normalized.begin(), normalized.end(), normalized.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return normalized == "1" || normalized == "true" || normalized == "yes" || normalized == "on";
+}
+
+} // namespace utils
+} // namespace kanba
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+
+namespace kanba {
+namespace utils {
+
+class Config {
+public:
+    // Read a string setting from the environment, falling back to a default
+    static std::string getString(const char* name, const std::string& defaultValue);
+
+    // Read an integer setting from the environment, falling back to a default
+    // when the variable is unset or not a valid number
+    static long long getInt(const char* name, long long defaultValue);
+
+    // Read a floating point setting from the environment
+    static double getDouble(const char* name, double defaultValue);
+
+    // Read a boolean setting ("1", "true", "yes", "on" are true)
+    static bool getBool(const char* name, bool defaultValue);
+};
+
+} // namespace utils
+} // namespace kanba
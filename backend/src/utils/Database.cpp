@@ -1,52 +1,616 @@
 #include "Database.h"
+#include "DbCircuitBreaker.h"
+#include "QueryMetrics.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <unordered_map>
 
 namespace kanba {
 namespace utils {
 
+namespace {
+
+// Name of the per-IO-loop clients; "default" stays the shared pool
+constexpr const char* FAST_CLIENT_NAME = "default_fast";
+
+Database::Options currentOptions;
+
+// Set on each IO loop thread once the app runs in fast mode. Other threads
+// (hash workers, the main loop's timers, shared-pool callbacks) never see a
+// loop client, since a lock-free client must only be used on its own loop.
+thread_local drogon::orm::DbClientPtr loopClient;
+std::atomic<bool> clientsCreated{false};
+
+constexpr const char* REPLICA_CLIENT_NAME = "replica";
+constexpr const char* UNBATCHED_CLIENT_NAME = "unbatched";
+
+struct PoolCounters {
+    std::atomic<uint64_t> queries{0};
+    std::atomic<uint64_t> inFlight{0};
+    std::atomic<uint64_t> errors{0};
+};
+
+PoolCounters primaryCounters;
+PoolCounters replicaCounters;
+
+PoolCounters& countersFor(Database::Target target) {
+    return target == Database::Target::Replica ? replicaCounters : primaryCounters;
+}
+
+Database::PoolStats poolStats(const PoolCounters& counters, size_t connections) {
+    Database::PoolStats stats;
+    stats.connections = connections;
+    stats.queries = counters.queries.load(std::memory_order_relaxed);
+    stats.inFlight = counters.inFlight.load(std::memory_order_relaxed);
+    stats.errors = counters.errors.load(std::memory_order_relaxed);
+    return stats;
+}
+
+// ---- Replica replay tracking ----
+//
+// Every poll samples the primary's WAL position, then the replica's replayed
+// position. A primary sample taken at time t that the replica has replayed
+// means every transaction committed before t is visible there, so
+// caughtUpAt is the sample time of the newest replayed sample. A user whose
+// last write is older than caughtUpAt can read from the replica.
+
+using Clock = std::chrono::steady_clock;
+
+int64_t nowTicks() {
+    return Clock::now().time_since_epoch().count();
+}
+
+int64_t msToTicks(int ms) {
+    return std::chrono::duration_cast<Clock::duration>(std::chrono::milliseconds(ms)).count();
+}
+
+struct LsnSample {
+    uint64_t lsn;
+    int64_t sampledAt;
+};
+
+// Bounds the samples kept while the replica is far behind; older samples
+// are dropped, which only delays caughtUpAt
+constexpr size_t MAX_SAMPLES = 10000;
+
+std::mutex replicaMutex;
+std::deque<LsnSample> primarySamples;                  // oldest first
+std::unordered_map<std::string, int64_t> lastWrites;   // user id -> commit time
+
+std::atomic<int64_t> caughtUpAt{0};     // 0 until the first replayed sample
+std::atomic<int64_t> pinAllBefore{0};   // set when lastWrites is full
+std::atomic<bool> sampling{false};
+
+std::atomic<uint64_t> replicaReads{0};
+std::atomic<uint64_t> pinnedReads{0};
+std::atomic<uint64_t> fallbackReads{0};
+
+// Parse a pg_lsn ("16/B374D848")
+bool parseLsn(const std::string& text, uint64_t& lsn) {
+    size_t slash = text.find('/');
+    if (slash == std::string::npos) {
+        return false;
+    }
+    char* end = nullptr;
+    uint64_t high = std::strtoull(text.c_str(), &end, 16);
+    if (end != text.c_str() + slash) {
+        return false;
+    }
+    uint64_t low = std::strtoull(text.c_str() + slash + 1, &end, 16);
+    if (*end != '\0') {
+        return false;
+    }
+    lsn = (high << 32) | low;
+    return true;
+}
+
+void replayedUpTo(uint64_t replayed) {
+    std::lock_guard<std::mutex> lock(replicaMutex);
+    size_t newest = primarySamples.size();
+    for (size_t i = primarySamples.size(); i-- > 0;) {
+        if (primarySamples[i].lsn <= replayed) {
+            newest = i;
+            break;
+        }
+    }
+    if (newest == primarySamples.size()) {
+        return;
+    }
+
+    int64_t caught = primarySamples[newest].sampledAt;
+    primarySamples.erase(primarySamples.begin(), primarySamples.begin() + newest);
+    if (caught <= caughtUpAt.load(std::memory_order_relaxed)) {
+        return;
+    }
+    caughtUpAt.store(caught, std::memory_order_relaxed);
+
+    for (auto it = lastWrites.begin(); it != lastWrites.end();) {
+        if (it->second < caught) {
+            it = lastWrites.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void sampleReplica() {
+    if (sampling.exchange(true)) {
+        return;  // previous poll still running
+    }
+
+    auto primary = drogon::app().getDbClient("default");
+    auto replica = drogon::app().getDbClient(REPLICA_CLIENT_NAME);
+    if (!primary || !replica) {
+        sampling = false;
+        return;
+    }
+
+    // Taken before the query, so every commit before this time is at or
+    // below the position it returns
+    int64_t sampledAt = nowTicks();
+    primary->execSqlAsync(
+        "SELECT pg_current_wal_lsn()::text AS lsn",
+        [replica, sampledAt](const drogon::orm::Result& result) {
+            uint64_t lsn = 0;
+            if (result.empty() || !parseLsn(result[0]["lsn"].as<std::string>(), lsn)) {
+                sampling = false;
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(replicaMutex);
+                primarySamples.push_back({lsn, sampledAt});
+                if (primarySamples.size() > MAX_SAMPLES) {
+                    primarySamples.pop_front();
+                }
+            }
+
+            replica->execSqlAsync(
+                "SELECT pg_last_wal_replay_lsn()::text AS lsn",
+                [](const drogon::orm::Result& result) {
+                    // NULL: the "replica" is not in recovery, i.e. it is the
+                    // primary itself (a single local database)
+                    uint64_t replayed = std::numeric_limits<uint64_t>::max();
+                    if (!result.empty() && !result[0]["lsn"].isNull() &&
+                        !parseLsn(result[0]["lsn"].as<std::string>(), replayed)) {
+                        sampling = false;
+                        return;
+                    }
+                    replayedUpTo(replayed);
+                    sampling = false;
+                },
+                [](const drogon::orm::DrogonDbException& e) {
+                    // caughtUpAt stops advancing, so reads fall back to the
+                    // primary once it is older than the lag limit
+                    LOG_WARN << "Replica replay position unavailable: " << e.base().what();
+                    sampling = false;
+                }
+            );
+        },
+        [](const drogon::orm::DrogonDbException& e) {
+            LOG_WARN << "Primary WAL position unavailable: " << e.base().what();
+            sampling = false;
+        }
+    );
+}
+
+// Why a JSON value cannot be bound as the given type (empty if it can)
+std::string paramError(Statement::Param type, const Json::Value& value) {
+    if (value.isNull()) {
+        return "";
+    }
+    switch (type) {
+        case Statement::Param::Text:
+            return value.isString() || value.isNumeric() || value.isBool() ? "" : "expected a scalar";
+        case Statement::Param::Integer:
+            return value.isInt() ? "" : "expected a 32-bit integer";
+        case Statement::Param::BigInt:
+            return value.isInt64() ? "" : "expected a 64-bit integer";
+        case Statement::Param::Boolean:
+            return value.isBool() ? "" : "expected a boolean";
+        case Statement::Param::Json:
+            return "";
+    }
+    return "unsupported parameter type";
+}
+
+// Bind a value already checked by paramError
+void bindParam(drogon::orm::internal::SqlBinder& binder, Statement::Param type, const Json::Value& value) {
+    if (value.isNull()) {
+        binder << nullptr;
+        return;
+    }
+    switch (type) {
+        case Statement::Param::Text:
+            binder << value.asString();
+            break;
+        case Statement::Param::Integer:
+            // Sent in binary, so the width has to match the int4 placeholder
+            binder << static_cast<int32_t>(value.asInt());
+            break;
+        case Statement::Param::BigInt:
+            binder << static_cast<int64_t>(value.asInt64());
+            break;
+        case Statement::Param::Boolean:
+            binder << value.asBool();
+            break;
+        case Statement::Param::Json:
+            if (value.isString()) {
+                binder << value.asString();
+            } else {
+                Json::StreamWriterBuilder writer;
+                writer["indentation"] = "";
+                binder << Json::writeString(writer, value);
+            }
+            break;
+    }
+}
+
+} // namespace
+
+void Database::createClients(const Options& options) {
+    currentOptions = options;
+    clientsCreated.store(true, std::memory_order_release);
+    double timeout = options.timeoutSeconds > 0 ? options.timeoutSeconds : -1.0;
+
+    drogon::app().createDbClient(
+        "postgresql",
+        options.host,
+        options.port,
+        options.name,
+        options.user,
+        options.password,
+        options.fastClients ? options.fallbackConnections : options.connections,
+        "",                     // filename (for sqlite)
+        "default",
+        false,                  // is_fast
+        "",                     // characterSet
+        timeout,
+        options.autoBatch
+    );
+
+    if (!options.replicaHost.empty()) {
+        drogon::app().createDbClient(
+            "postgresql",
+            options.replicaHost,
+            options.replicaPort,
+            options.name,
+            options.user,
+            options.password,
+            options.replicaConnections,
+            "",
+            REPLICA_CLIENT_NAME,
+            false,
+            "",
+            timeout,
+            options.autoBatch
+        );
+    }
+
+    if (options.autoBatch) {
+        // One connection for the few statements a pipeline rejects
+        drogon::app().createDbClient(
+            "postgresql",
+            options.host,
+            options.port,
+            options.name,
+            options.user,
+            options.password,
+            1,
+            "",
+            UNBATCHED_CLIENT_NAME,
+            false,
+            "",
+            timeout,
+            false               // autoBatch
+        );
+    }
+
+    if (!options.fastClients) {
+        return;
+    }
+
+    // Fast clients live on the IO loops and skip the shared pool's
+    // cross-thread hand-off; connections are per loop
+    drogon::app().createDbClient(
+        "postgresql",
+        options.host,
+        options.port,
+        options.name,
+        options.user,
+        options.password,
+        options.connections,
+        "",
+        FAST_CLIENT_NAME,
+        true,                   // is_fast
+        "",
+        timeout,
+        options.autoBatch
+    );
+
+    drogon::app().registerBeginningAdvice([] {
+        for (size_t i = 0; i < drogon::app().getThreadNum(); ++i) {
+            drogon::app().getIOLoop(i)->runInLoop([] {
+                loopClient = drogon::app().getFastDbClient(FAST_CLIENT_NAME);
+            });
+        }
+    });
+}
+
+const Database::Options& Database::options() {
+    return currentOptions;
+}
+
 drogon::orm::DbClientPtr Database::getClient() {
+    if (loopClient) {
+        return loopClient;
+    }
+    if (!clientsCreated.load(std::memory_order_acquire)) {
+        return nullptr;  // e.g. utilities used outside the server
+    }
     return drogon::app().getDbClient("default");
 }
 
+drogon::orm::DbClientPtr Database::getUnbatchedClient() {
+    if (!clientsCreated.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+    if (!currentOptions.autoBatch) {
+        return getClient();
+    }
+    return drogon::app().getDbClient(UNBATCHED_CLIENT_NAME);
+}
+
+drogon::orm::DbClientPtr Database::getReplicaClient() {
+    if (currentOptions.replicaHost.empty()) {
+        return nullptr;
+    }
+    return drogon::app().getDbClient(REPLICA_CLIENT_NAME);
+}
+
+void Database::startReplicaMonitor() {
+    if (currentOptions.replicaHost.empty()) {
+        return;
+    }
+    double interval = std::max(currentOptions.replicaPollMs, 10) / 1000.0;
+    drogon::app().getLoop()->runEvery(interval, [] { sampleReplica(); });
+    LOG_INFO << "Read replica " << currentOptions.replicaHost << ":" << currentOptions.replicaPort
+             << " (max lag " << currentOptions.replicaMaxLagMs << " ms)";
+}
+
+Database::Target Database::readTarget(const std::string& userId) {
+    if (currentOptions.replicaHost.empty()) {
+        return Target::Primary;
+    }
+
+    int64_t caught = caughtUpAt.load(std::memory_order_relaxed);
+    if (caught == 0 || nowTicks() - caught > msToTicks(currentOptions.replicaMaxLagMs)) {
+        fallbackReads.fetch_add(1, std::memory_order_relaxed);
+        return Target::Primary;
+    }
+
+    bool pinned = pinAllBefore.load(std::memory_order_relaxed) >= caught;
+    if (!pinned) {
+        std::lock_guard<std::mutex> lock(replicaMutex);
+        auto it = lastWrites.find(userId);
+        pinned = it != lastWrites.end() && it->second >= caught;
+    }
+    if (pinned) {
+        pinnedReads.fetch_add(1, std::memory_order_relaxed);
+        return Target::Primary;
+    }
+
+    replicaReads.fetch_add(1, std::memory_order_relaxed);
+    return Target::Replica;
+}
+
+void Database::markWrite(const std::string& userId) {
+    if (currentOptions.replicaHost.empty() || userId.empty()) {
+        return;
+    }
+
+    int64_t now = nowTicks();
+    std::lock_guard<std::mutex> lock(replicaMutex);
+    auto it = lastWrites.find(userId);
+    if (it != lastWrites.end()) {
+        it->second = now;
+        return;
+    }
+    if (lastWrites.size() >= currentOptions.maxPinnedUsers) {
+        // No room for another marker: pin everyone past this write instead
+        pinAllBefore.store(now, std::memory_order_relaxed);
+        return;
+    }
+    lastWrites.emplace(userId, now);
+}
+
+Database::Stats Database::stats() {
+    Stats stats;
+    stats.primary = poolStats(primaryCounters, currentOptions.fastClients
+        ? currentOptions.connections * drogon::app().getThreadNum() + currentOptions.fallbackConnections
+        : currentOptions.connections);
+    stats.replicaConfigured = !currentOptions.replicaHost.empty();
+    stats.replica = poolStats(replicaCounters, stats.replicaConfigured ? currentOptions.replicaConnections : 0);
+
+    int64_t caught = caughtUpAt.load(std::memory_order_relaxed);
+    if (stats.replicaConfigured && caught != 0) {
+        stats.replicaLagMs = std::chrono::duration<double, std::milli>(
+            Clock::duration(nowTicks() - caught)).count();
+        stats.replicaHealthy = stats.replicaLagMs <= currentOptions.replicaMaxLagMs;
+    }
+    stats.replicaReads = replicaReads.load(std::memory_order_relaxed);
+    stats.pinnedReads = pinnedReads.load(std::memory_order_relaxed);
+    stats.fallbackReads = fallbackReads.load(std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(replicaMutex);
+        stats.pinnedUsers = lastWrites.size();
+    }
+    return stats;
+}
+
+Database::QueryTicket Database::queryStarted(Target target, const Statement* statement) {
+    PoolCounters& counters = countersFor(target);
+    counters.queries.fetch_add(1, std::memory_order_relaxed);
+    counters.inFlight.fetch_add(1, std::memory_order_relaxed);
+    DbCircuitBreaker::queryStarted();
+    return QueryTicket{target, statement, nowTicks(), DbCircuitBreaker::currentProbe(), nullptr};
+}
+
+void Database::queryFinished(
+    const QueryTicket& ticket,
+    const drogon::orm::DrogonDbException* error,
+    size_t rows,
+    bool late
+) {
+    auto latency = Clock::duration(nowTicks() - ticket.startedAt);
+    QueryMetrics::record(ticket.statement, latency, rows, error != nullptr);
+    SlowQueryLog::observe(ticket.statement, latency, rows, error != nullptr, ticket.params,
+                          ticket.target == Target::Replica);
+
+    PoolCounters& counters = countersFor(ticket.target);
+    counters.inFlight.fetch_sub(1, std::memory_order_relaxed);
+    if (error) {
+        counters.errors.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (late) {
+        DbCircuitBreaker::lateQueryFinished();  // counted when its deadline expired
+        return;
+    }
+    // Only a missing or overloaded database trips the breaker; SQL errors
+    // (constraint violations, bad input) are answers
+    const std::exception* cause = error ? &error->base() : nullptr;
+    bool unavailable = cause && (dynamic_cast<const drogon::orm::BrokenConnection*>(cause) ||
+                                 dynamic_cast<const drogon::orm::TimeoutError*>(cause));
+    DbCircuitBreaker::queryFinished(latency, unavailable, ticket.probe);
+}
+
+void Database::queryFinished(const QueryTicket& ticket, const std::exception_ptr& error, bool late) {
+    if (!error) {
+        queryFinished(ticket, nullptr, 0, late);
+        return;
+    }
+    try {
+        std::rethrow_exception(error);
+    } catch (const drogon::orm::DrogonDbException& e) {
+        queryFinished(ticket, &e, 0, late);
+    } catch (...) {
+        drogon::orm::Failure failure("Unknown database error");
+        queryFinished(ticket, &failure, 0, late);
+    }
+}
+
+void Database::armDeadline(
+    const std::shared_ptr<QuerySettlement>& settlement,
+    const Statement& statement,
+    uint64_t probe,
+    std::function<void()> onExpired
+) {
+    int deadlineMs = statement.deadlineMs > 0 ? statement.deadlineMs : currentOptions.queryDeadlineMs;
+    if (deadlineMs <= 0) {
+        return;
+    }
+    // Drogon's own timeout already fails the query first
+    if (currentOptions.timeoutSeconds > 0 && deadlineMs >= currentOptions.timeoutSeconds * 1000) {
+        return;
+    }
+
+    trantor::EventLoop* loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+    if (!loop) {
+        loop = drogon::app().getLoop();
+    }
+    settlement->loop = loop;
+    settlement->timer = loop->runAfter(
+        deadlineMs / 1000.0,
+        [settlement, onExpired = std::move(onExpired), name = statement.name, deadlineMs, probe] {
+            if (!settlement->settle()) {
+                return;
+            }
+            // The query keeps its connection until Postgres answers; its
+            // result is dropped when it does
+            LOG_WARN << "Query deadline exceeded: " << name << " (" << deadlineMs << " ms)";
+            DbCircuitBreaker::queryTimedOut(probe);
+            DbCircuitBreaker::ProbeScope scope(probe);
+            onExpired();
+        }
+    );
+}
+
 void Database::callFunction(
     const std::string& functionName,
     const Json::Value& params,
     std::function<void(const drogon::orm::Result&)> callback,
     std::function<void(const drogon::orm::DrogonDbException&)> errorCallback
 ) {
+    // Only registered statements can be called: the SQL text never comes
+    // from the caller, and each one keeps a single prepared statement
+    const Statement* statement = Statements::find(functionName);
+    if (!statement) {
+        LOG_ERROR << "Unknown statement: " << functionName;
+        errorCallback(drogon::orm::Failure("Unknown statement: " + functionName));
+        return;
+    }
+
+    if (!params.isNull() && !params.isArray()) {
+        errorCallback(drogon::orm::Failure("Parameters for " + functionName + " must be an array"));
+        return;
+    }
+
+    size_t paramCount = params.isArray() ? params.size() : 0;
+    if (paramCount != statement->params.size()) {
+        errorCallback(drogon::orm::Failure(
+            functionName + " takes " + std::to_string(statement->params.size()) +
+            " parameters, got " + std::to_string(paramCount)
+        ));
+        return;
+    }
+
     auto client = getClient();
     if (!client) {
         LOG_ERROR << "Database client not available";
+        errorCallback(drogon::orm::BrokenConnection("Database client not available"));
         return;
     }
 
-    // Build the SQL call for the function
-    std::string sql = "SELECT * FROM " + functionName + "(";
-    std::vector<std::string> paramPlaceholders;
+    LOG_DEBUG << "Calling statement: " << statement->name;
 
-    int paramIndex = 1;
-    for (size_t i = 0; i < params.getMemberNames().size(); ++i) {
-        paramPlaceholders.push_back("$" + std::to_string(paramIndex++));
+    // The binder sends the query when it goes out of scope, so every value
+    // is checked before it is created
+    for (Json::ArrayIndex i = 0; i < paramCount; ++i) {
+        std::string error = paramError(statement->params[i], params[i]);
+        if (!error.empty()) {
+            errorCallback(drogon::orm::Failure(
+                "Parameter " + std::to_string(i + 1) + " of " + functionName + ": " + error
+            ));
+            return;
+        }
     }
 
-    for (size_t i = 0; i < paramPlaceholders.size(); ++i) {
-        if (i > 0) sql += ", ";
-        sql += paramPlaceholders[i];
+    auto binder = *client << statement->sql;
+    for (Json::ArrayIndex i = 0; i < paramCount; ++i) {
+        bindParam(binder, statement->params[i], params[i]);
     }
-    sql += ")";
 
-    LOG_DEBUG << "Calling function: " << sql;
-
-    // Execute with parameters
-    client->execSqlAsync(
-        sql,
-        [callback](const drogon::orm::Result& result) {
-            callback(result);
-        },
-        [errorCallback](const drogon::orm::DrogonDbException& e) {
+    auto ticket = queryStarted(Target::Primary, statement);
+    std::function<void(const drogon::orm::Result&)> onResult = [ticket, callback](const drogon::orm::Result& result) {
+        queryFinished(ticket, nullptr, result.size());
+        DbCircuitBreaker::ProbeScope probe(ticket.probe);
+        callback(result);
+    };
+    std::function<void(const drogon::orm::DrogonDbException&)> onError =
+        [ticket, errorCallback](const drogon::orm::DrogonDbException& e) {
+            queryFinished(ticket, &e);
             LOG_ERROR << "Database error: " << e.base().what();
+            DbCircuitBreaker::ProbeScope probe(ticket.probe);
             errorCallback(e);
-        }
-    );
+        };
+    binder >> onResult;
+    binder >> onError;
+    binder.exec();
 }
 
 } // namespace utils
@@ -1,18 +1,197 @@
 #pragma once
 
+#include "DbCircuitBreaker.h"
+#include "SlowQueryLog.h"
+#include "Statements.h"
 #include <drogon/drogon.h>
 #include <drogon/orm/DbClient.h>
-#include <string>
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace kanba {
 namespace utils {
 
+// Settles a query exactly once: by its result, its error or its deadline,
+// whichever comes first. The deadline timer is cancelled on settlement.
+struct QuerySettlement {
+    std::atomic<bool> settled{false};
+    trantor::EventLoop* loop = nullptr;
+    trantor::TimerId timer = 0;
+
+    bool settle() {
+        if (settled.exchange(true)) {
+            return false;
+        }
+        if (loop && timer) {
+            loop->invalidateTimer(timer);
+        }
+        return true;
+    }
+};
+
+// A statement already sent to the database, awaited from a coroutine.
+//
+// Unlike DbClient::execSqlCoro, which sends its query only when awaited, the
+// query is in flight as soon as the future exists, so a handler can start
+// several independent queries and then await them one by one. The state is
+// shared with the query callbacks: a future dropped before its result
+// arrives is simply never resumed.
+class QueryFuture {
+public:
+    struct State : QuerySettlement {
+        std::mutex mutex;
+        bool done = false;
+        std::optional<drogon::orm::Result> result;
+        std::exception_ptr error;
+        std::coroutine_handle<> waiter;
+
+        void complete(const drogon::orm::Result& value) {
+            std::coroutine_handle<> resume;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                result.emplace(value);
+                done = true;
+                resume = std::exchange(waiter, nullptr);
+            }
+            if (resume) {
+                resume.resume();
+            }
+        }
+
+        void fail(std::exception_ptr exception) {
+            std::coroutine_handle<> resume;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                error = std::move(exception);
+                done = true;
+                resume = std::exchange(waiter, nullptr);
+            }
+            if (resume) {
+                resume.resume();
+            }
+        }
+    };
+
+    explicit QueryFuture(std::shared_ptr<State> state) : state_(std::move(state)) {}
+
+    bool await_ready() const {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        return state_->done;
+    }
+
+    // Resumes on the thread that delivers the result, or not at all if it
+    // arrived in the meantime
+    bool await_suspend(std::coroutine_handle<> handle) {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        if (state_->done) {
+            return false;
+        }
+        state_->waiter = handle;
+        return true;
+    }
+
+    // Throws the query's DrogonDbException on failure
+    drogon::orm::Result await_resume() {
+        if (state_->error) {
+            std::rethrow_exception(state_->error);
+        }
+        return std::move(*state_->result);
+    }
+
+private:
+    std::shared_ptr<State> state_;
+};
+
 class Database {
 public:
-    // Get the default database client
+    // Connection topology, read from the environment at startup
+    struct Options {
+        std::string host = "localhost";
+        unsigned short port = 5432;
+        std::string name = "kanba";
+        std::string user = "postgres";
+        std::string password = "postgres";
+        size_t connections = 10;         // shared pool size, or per IO loop with fastClients
+        bool fastClients = false;        // one lock-free client per IO loop
+        size_t fallbackConnections = 2;  // shared pool for threads without a loop client
+        bool autoBatch = false;          // Postgres pipeline mode (PostgreSQL 14+)
+        double timeoutSeconds = 30.0;    // per-query timeout, 0 disables
+        int queryDeadlineMs = 10000;     // registered statements without their own deadline, 0 disables
+
+        // Streaming replica for read-only handlers (empty host: none). It
+        // shares the primary's database name and credentials.
+        std::string replicaHost;
+        unsigned short replicaPort = 5432;
+        size_t replicaConnections = 10;
+        int replicaPollMs = 100;          // how often replay progress is sampled
+        int replicaMaxLagMs = 2000;       // all reads go to the primary beyond this
+        size_t maxPinnedUsers = 100000;   // read-your-writes markers kept
+    };
+
+    // Where a query runs
+    enum class Target : uint8_t {
+        Primary,
+        Replica
+    };
+
+    struct PoolStats {
+        size_t connections = 0;
+        uint64_t queries = 0;
+        uint64_t inFlight = 0;
+        uint64_t errors = 0;
+    };
+
+    struct Stats {
+        PoolStats primary;
+        PoolStats replica;
+        bool replicaConfigured = false;
+        bool replicaHealthy = false;
+        double replicaLagMs = 0;        // age of the newest primary position replayed
+        uint64_t replicaReads = 0;      // read handlers served by the replica
+        uint64_t pinnedReads = 0;       // sent to the primary by a read-your-writes marker
+        uint64_t fallbackReads = 0;     // sent to the primary because the replica lagged
+        size_t pinnedUsers = 0;
+    };
+
+    // Register the clients with Drogon; call once before app().run()
+    static void createClients(const Options& options);
+
+    // Options in effect
+    static const Options& options();
+
+    // Sample replica replay progress every replicaPollMs; call from a
+    // beginning advice (no-op without a replica)
+    static void startReplicaMonitor();
+
+    // Where a read-only handler for this user should read from. A user who
+    // wrote recently reads from the primary until the replica has replayed
+    // past that write; everyone reads from the primary while the replica is
+    // missing, unreachable or more than replicaMaxLagMs behind. Decide once
+    // per request so a multi-query response comes from one server.
+    static Target readTarget(const std::string& userId);
+
+    // Record that a user's write has committed on the primary
+    static void markWrite(const std::string& userId);
+
+    static Stats stats();
+
+    // Get the database client for the calling thread: the IO loop's own
+    // client in fast mode, otherwise the shared pool
     static drogon::orm::DbClientPtr getClient();
 
+    // Primary client for statements that must not share a pipeline, such as
+    // DETACH PARTITION ... CONCURRENTLY; the shared pool unless autoBatch is on
+    static drogon::orm::DbClientPtr getUnbatchedClient();
+
     // Execute a query and return results
     template<typename... Args>
     static void query(
@@ -24,28 +203,208 @@ public:
         auto client = getClient();
         if (!client) {
             LOG_ERROR << "Database client not available";
+            errorCallback(drogon::orm::BrokenConnection("Database client not available"));
             return;
         }
+        auto ticket = queryStarted(Target::Primary, nullptr);
         client->execSqlAsync(
             sql,
-            std::forward<Args>(args)...,
-            [callback](const drogon::orm::Result& result) {
+            [ticket, callback](const drogon::orm::Result& result) {
+                queryFinished(ticket, nullptr, result.size());
+                DbCircuitBreaker::ProbeScope probe(ticket.probe);
                 callback(result);
             },
-            [errorCallback](const drogon::orm::DrogonDbException& e) {
+            [ticket, errorCallback](const drogon::orm::DrogonDbException& e) {
+                queryFinished(ticket, &e);
                 LOG_ERROR << "Database error: " << e.base().what();
+                DbCircuitBreaker::ProbeScope probe(ticket.probe);
                 errorCallback(e);
-            }
+            },
+            std::forward<Args>(args)...
         );
     }
 
-    // Execute a stored function
+    // Execute a registered statement on the primary. Arguments are bound in
+    // placeholder order, exactly as with DbClient::execSqlAsync
+    template<typename ResultCallback, typename ErrorCallback, typename... Args>
+    static void execute(
+        const Statement& statement,
+        ResultCallback&& callback,
+        ErrorCallback&& errorCallback,
+        Args&&... args
+    ) {
+        executeOn(
+            Target::Primary,
+            statement,
+            std::forward<ResultCallback>(callback),
+            std::forward<ErrorCallback>(errorCallback),
+            std::forward<Args>(args)...
+        );
+    }
+
+    // Execute a read-only statement on a target chosen by readTarget().
+    // A statement that outlives its deadline (Statement::deadlineMs, else
+    // Options::queryDeadlineMs) fails with TimeoutError; its late result is
+    // dropped.
+    template<typename ResultCallback, typename ErrorCallback, typename... Args>
+    static void executeOn(
+        Target target,
+        const Statement& statement,
+        ResultCallback&& callback,
+        ErrorCallback&& errorCallback,
+        Args&&... args
+    ) {
+        auto client = clientFor(target);
+        if (!client) {
+            LOG_ERROR << "Database client not available";
+            errorCallback(drogon::orm::BrokenConnection("Database client not available"));
+            return;
+        }
+        auto pending = std::make_shared<Pending<std::decay_t<ResultCallback>, std::decay_t<ErrorCallback>>>(
+            std::forward<ResultCallback>(callback),
+            std::forward<ErrorCallback>(errorCallback)
+        );
+        auto ticket = queryStarted(target, &statement);
+        captureParams(ticket, args...);
+        armDeadline(pending, statement, ticket.probe, [pending] {
+            pending->errorCallback(drogon::orm::TimeoutError("Query deadline exceeded"));
+        });
+        client->execSqlAsync(
+            statement.sql,
+            [ticket, pending](const drogon::orm::Result& result) {
+                bool settled = pending->settle();
+                queryFinished(ticket, nullptr, result.size(), !settled);
+                if (settled) {
+                    DbCircuitBreaker::ProbeScope probe(ticket.probe);
+                    pending->callback(result);
+                }
+            },
+            [ticket, pending](const drogon::orm::DrogonDbException& e) {
+                bool settled = pending->settle();
+                queryFinished(ticket, &e, 0, !settled);
+                if (settled) {
+                    DbCircuitBreaker::ProbeScope probe(ticket.probe);
+                    pending->errorCallback(e);
+                }
+            },
+            std::forward<Args>(args)...
+        );
+    }
+
+    // Send a registered statement now and await its result later (see
+    // QueryFuture)
+    template<typename... Args>
+    static QueryFuture executeCoro(Target target, const Statement& statement, Args&&... args) {
+        auto state = std::make_shared<QueryFuture::State>();
+        auto client = clientFor(target);
+        if (!client) {
+            LOG_ERROR << "Database client not available";
+            state->fail(std::make_exception_ptr(drogon::orm::BrokenConnection("Database client not available")));
+            return QueryFuture(state);
+        }
+        auto ticket = queryStarted(target, &statement);
+        captureParams(ticket, args...);
+        armDeadline(state, statement, ticket.probe, [state] {
+            state->fail(std::make_exception_ptr(drogon::orm::TimeoutError("Query deadline exceeded")));
+        });
+        client->execSqlAsync(
+            statement.sql,
+            [ticket, state](const drogon::orm::Result& result) {
+                bool settled = state->settle();
+                queryFinished(ticket, nullptr, result.size(), !settled);
+                if (settled) {
+                    DbCircuitBreaker::ProbeScope probe(ticket.probe);
+                    state->complete(result);
+                }
+            },
+            [ticket, state](const std::exception_ptr& error) {
+                bool settled = state->settle();
+                queryFinished(ticket, error, !settled);
+                if (settled) {
+                    DbCircuitBreaker::ProbeScope probe(ticket.probe);
+                    state->fail(error);
+                }
+            },
+            std::forward<Args>(args)...
+        );
+        return QueryFuture(state);
+    }
+
+    // Execute a registered statement by name. params is a JSON array in
+    // placeholder order; each value is bound according to the statement's
+    // declared parameter type and JSON null binds SQL NULL. Unknown names,
+    // a wrong parameter count or a value of the wrong type fail through
+    // errorCallback without reaching the database.
     static void callFunction(
         const std::string& functionName,
         const Json::Value& params,
         std::function<void(const drogon::orm::Result&)> callback,
         std::function<void(const drogon::orm::DrogonDbException&)> errorCallback
     );
+
+private:
+    static drogon::orm::DbClientPtr getReplicaClient();
+
+    // Client for a target; a replica target without a replica client is
+    // switched to the primary
+    static drogon::orm::DbClientPtr clientFor(Target& target) {
+        if (target == Target::Replica) {
+            if (auto replica = getReplicaClient()) {
+                return replica;
+            }
+            target = Target::Primary;
+        }
+        return getClient();
+    }
+
+    template<typename ResultCallback, typename ErrorCallback>
+    struct Pending : QuerySettlement {
+        template<typename OnResult, typename OnError>
+        Pending(OnResult&& onResult, OnError&& onError)
+            : callback(std::forward<OnResult>(onResult)), errorCallback(std::forward<OnError>(onError)) {}
+
+        ResultCallback callback;
+        ErrorCallback errorCallback;
+    };
+
+    // One query between send and completion
+    struct QueryTicket {
+        Target target;
+        const Statement* statement;  // nullptr for raw SQL
+        int64_t startedAt;           // steady_clock ticks
+        uint64_t probe;              // DbCircuitBreaker probe that issued it, 0 if none
+        SlowQueryLog::Params params; // read-only statements, only while the slow query log explains
+    };
+
+    // Values of statements that write or take a credential are never kept
+    template<typename... Args>
+    static void captureParams(QueryTicket& ticket, const Args&... args) {
+        if (ticket.statement && ticket.statement->readOnly && SlowQueryLog::capturingParams()) {
+            ticket.params = std::make_shared<const std::vector<std::string>>(
+                std::vector<std::string>{SlowQueryLog::paramText(args)...}
+            );
+        }
+    }
+
+    // Per-target counters behind stats(), per-statement QueryMetrics, the
+    // slow query log and the circuit breaker's view of every query. A query
+    // answered after its deadline already reported to the breaker (late).
+    static QueryTicket queryStarted(Target target, const Statement* statement);
+    static void queryFinished(
+        const QueryTicket& ticket,
+        const drogon::orm::DrogonDbException* error,
+        size_t rows = 0,
+        bool late = false
+    );
+    static void queryFinished(const QueryTicket& ticket, const std::exception_ptr& error, bool late = false);
+
+    // Run onExpired if the query is not settled within its deadline
+    static void armDeadline(
+        const std::shared_ptr<QuerySettlement>& settlement,
+        const Statement& statement,
+        uint64_t probe,
+        std::function<void()> onExpired
+    );
 };
 
 } // namespace utils
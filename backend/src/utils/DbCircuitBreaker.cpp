@@ -0,0 +1,225 @@
+#include "DbCircuitBreaker.h"
+#include <drogon/drogon.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <mutex>
+
+namespace kanba {
+namespace utils {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using State = DbCircuitBreaker::State;
+
+// Weight of the newest query in the moving averages
+constexpr double LATENCY_WEIGHT = 0.1;
+constexpr double FAILURE_WEIGHT = 0.05;
+
+// Written once by configure(), read-only afterwards
+DbCircuitBreaker::Options options;
+
+// Read without the lock on every request; written under it
+std::atomic<State> state{State::Closed};
+std::atomic<int64_t> inFlight{0};
+
+std::atomic<uint64_t> opened{0};
+std::atomic<uint64_t> rejected{0};
+std::atomic<uint64_t> probes{0};
+
+// Probe mark of the request or query callback running on this thread
+thread_local uint64_t threadProbe = 0;
+
+std::mutex mutex;
+uint64_t probeRound = 0;       // bumped each time the breaker goes half open
+double latencyMs = 0;
+double failureRatio = 0;
+size_t samples = 0;
+Clock::time_point changedAt;   // when the breaker opened or the probe round began
+size_t probesLeft = 0;
+size_t probeSuccesses = 0;
+
+void openLocked(const char* reason) {
+    state.store(State::Open, std::memory_order_relaxed);
+    changedAt = Clock::now();
+    opened.fetch_add(1, std::memory_order_relaxed);
+    LOG_WARN << "Database circuit opened (" << reason << "): in flight " << inFlight.load()
+             << ", latency " << latencyMs << " ms, failures " << failureRatio;
+}
+
+void closeLocked() {
+    state.store(State::Closed, std::memory_order_relaxed);
+    latencyMs = 0;
+    failureRatio = 0;
+    samples = 0;
+    LOG_INFO << "Database circuit closed";
+}
+
+// latency < 0: no latency sample (deadline expiry)
+void record(double sampleMs, bool unavailable, uint64_t probe) {
+    if (!options.enabled) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    State current = state.load(std::memory_order_relaxed);
+    if (current == State::Open) {
+        return;  // stragglers sent before the breaker opened
+    }
+    if (current == State::HalfOpen) {
+        if (probe != probeRound) {
+            return;  // stragglers and background jobs say nothing about the probes
+        }
+        if (unavailable || sampleMs > options.latencyThresholdMs) {
+            openLocked("probe failed");
+        } else if (++probeSuccesses >= options.halfOpenProbes) {
+            closeLocked();
+        }
+        return;
+    }
+
+    if (sampleMs >= 0) {
+        latencyMs += LATENCY_WEIGHT * (sampleMs - latencyMs);
+    }
+    failureRatio += FAILURE_WEIGHT * ((unavailable ? 1.0 : 0.0) - failureRatio);
+    if (++samples < options.minSamples) {
+        return;
+    }
+    if (latencyMs > options.latencyThresholdMs) {
+        openLocked("latency");
+    } else if (failureRatio > options.failureRatio) {
+        openLocked("failures");
+    }
+}
+
+} // namespace
+
+DbCircuitBreaker::ProbeScope::ProbeScope(uint64_t probe) : previous_(threadProbe) {
+    threadProbe = probe;
+}
+
+DbCircuitBreaker::ProbeScope::~ProbeScope() {
+    threadProbe = previous_;
+}
+
+void DbCircuitBreaker::configure(const Options& newOptions) {
+    options = newOptions;
+    options.halfOpenProbes = std::max<size_t>(1, options.halfOpenProbes);
+    options.openSeconds = std::max(1, options.openSeconds);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    state.store(State::Closed, std::memory_order_relaxed);
+    latencyMs = 0;
+    failureRatio = 0;
+    samples = 0;
+}
+
+bool DbCircuitBreaker::allowRequest(uint64_t& probe) {
+    probe = 0;
+    if (!options.enabled || state.load(std::memory_order_relaxed) == State::Closed) {
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto now = Clock::now();
+    auto period = std::chrono::seconds(options.openSeconds);
+    State current = state.load(std::memory_order_relaxed);
+
+    if (current == State::Open) {
+        if (now - changedAt < period) {
+            rejected.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        state.store(State::HalfOpen, std::memory_order_relaxed);
+        current = State::HalfOpen;
+        changedAt = now;
+        probesLeft = options.halfOpenProbes;
+        probeSuccesses = 0;
+        ++probeRound;
+        LOG_INFO << "Database circuit half open, probing";
+    }
+
+    if (current == State::HalfOpen) {
+        // Probes that never reached the database (cached answers) report
+        // nothing, so start another round rather than wait forever
+        if (probesLeft == 0 && now - changedAt >= period) {
+            changedAt = now;
+            probesLeft = options.halfOpenProbes;
+        }
+        if (probesLeft == 0) {
+            rejected.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        --probesLeft;
+        probes.fetch_add(1, std::memory_order_relaxed);
+        probe = probeRound;
+    }
+    return true;
+}
+
+uint64_t DbCircuitBreaker::currentProbe() {
+    return threadProbe;
+}
+
+void DbCircuitBreaker::queryStarted() {
+    int64_t outstanding = inFlight.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (!options.enabled || outstanding <= static_cast<int64_t>(options.maxInFlight) ||
+        state.load(std::memory_order_relaxed) != State::Closed) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (state.load(std::memory_order_relaxed) == State::Closed) {
+        openLocked("queue depth");
+    }
+}
+
+void DbCircuitBreaker::queryFinished(std::chrono::nanoseconds latency, bool unavailable, uint64_t probe) {
+    inFlight.fetch_sub(1, std::memory_order_relaxed);
+    record(std::chrono::duration<double, std::milli>(latency).count(), unavailable, probe);
+}
+
+void DbCircuitBreaker::queryTimedOut(uint64_t probe) {
+    record(-1, true, probe);
+}
+
+void DbCircuitBreaker::lateQueryFinished() {
+    inFlight.fetch_sub(1, std::memory_order_relaxed);
+}
+
+int DbCircuitBreaker::retryAfterSeconds() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (state.load(std::memory_order_relaxed) != State::Open) {
+        return 1;
+    }
+    double remaining = options.openSeconds -
+        std::chrono::duration<double>(Clock::now() - changedAt).count();
+    return std::max(1, static_cast<int>(std::ceil(remaining)));
+}
+
+const char* DbCircuitBreaker::stateName(State value) {
+    switch (value) {
+        case State::Closed:
+            return "closed";
+        case State::Open:
+            return "open";
+        case State::HalfOpen:
+            return "half_open";
+    }
+    return "unknown";
+}
+
+DbCircuitBreaker::Stats DbCircuitBreaker::stats() {
+    Stats stats;
+    stats.state = state.load(std::memory_order_relaxed);
+    stats.opened = opened.load(std::memory_order_relaxed);
+    stats.rejected = rejected.load(std::memory_order_relaxed);
+    stats.probes = probes.load(std::memory_order_relaxed);
+    stats.inFlight = static_cast<uint64_t>(std::max<int64_t>(0, inFlight.load(std::memory_order_relaxed)));
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.latencyMs = latencyMs;
+    stats.failureRatio = failureRatio;
+    return stats;
+}
+
+} // namespace utils
+} // namespace kanba
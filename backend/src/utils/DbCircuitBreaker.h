@@ -0,0 +1,93 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace kanba {
+namespace utils {
+
+// Circuit breaker in front of the database pools.
+//
+// Every query reports to it through utils::Database. The breaker opens when
+// too many queries are outstanding (they queue inside Drogon's clients), when
+// recent query latency climbs past a threshold, or when too many recent
+// queries fail for lack of a database (broken connections, timeouts, missed
+// deadlines; SQL errors do not count). While open, API requests are rejected
+// with 503 before they reach a handler. After openSeconds the breaker lets a
+// few probe requests through (half open): enough fast successes close it
+// again, one more unavailability opens it for another period. Only queries
+// issued on behalf of a probe request are judged while half open; stragglers
+// sent before the breaker opened and background jobs are ignored.
+class DbCircuitBreaker {
+public:
+    struct Options {
+        bool enabled = true;
+        size_t maxInFlight = 200;           // outstanding queries across all pools
+        double latencyThresholdMs = 2000;   // moving average of recent query latency
+        double failureRatio = 0.5;          // moving share of unavailable-database errors
+        size_t minSamples = 20;             // queries seen before latency/failures count
+        int openSeconds = 5;                // fast-fail period before probing
+        size_t halfOpenProbes = 5;          // requests let through per probe round
+    };
+
+    enum class State : uint8_t {
+        Closed,
+        Open,
+        HalfOpen
+    };
+
+    struct Stats {
+        State state = State::Closed;
+        uint64_t opened = 0;       // times the breaker opened
+        uint64_t rejected = 0;     // requests shed while open
+        uint64_t probes = 0;       // requests let through while half open
+        uint64_t inFlight = 0;
+        double latencyMs = 0;
+        double failureRatio = 0;
+    };
+
+    // Set thresholds and start closed (call once at startup, before serving
+    // requests)
+    static void configure(const Options& options);
+
+    // Marks the queries started on this thread as issued by a probe request
+    // (probe 0: none) while it lives. utils::Database carries the mark into
+    // its result callbacks, so the queries a probe chains count as well.
+    class ProbeScope {
+    public:
+        explicit ProbeScope(uint64_t probe);
+        ~ProbeScope();
+        ProbeScope(const ProbeScope&) = delete;
+        ProbeScope& operator=(const ProbeScope&) = delete;
+
+    private:
+        uint64_t previous_;
+    };
+
+    // Admission for one API request; false means reject it with 503. A
+    // request let through as a probe gets a non-zero probe to run under.
+    static bool allowRequest(uint64_t& probe);
+
+    // Probe of the calling thread's ProbeScope, 0 outside one
+    static uint64_t currentProbe();
+
+    // Query accounting, called by utils::Database with the query's probe
+    static void queryStarted();
+    static void queryFinished(std::chrono::nanoseconds latency, bool unavailable, uint64_t probe);
+
+    // A query outlived its deadline and counts as unavailable. When the
+    // database eventually answers it reports lateQueryFinished() instead of
+    // queryFinished(), which only releases its in-flight slot.
+    static void queryTimedOut(uint64_t probe);
+    static void lateQueryFinished();
+
+    // Seconds until the breaker probes again (for Retry-After)
+    static int retryAfterSeconds();
+
+    static const char* stateName(State state);
+
+    static Stats stats();
+};
+
+} // namespace utils
+} // namespace kanba
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <drogon/drogon.h>
+#include <charconv>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace kanba {
+namespace utils {
+
+// Typed reads from result fields, straight from the text the server sent.
+//
+// Field::as<std::string>() copies every value into a new string and the
+// numeric as<>() overloads parse from that copy. These read the result
+// buffer in place, so hot loops over large results (membership loads,
+// revocation syncs) do no allocation per field.
+class FieldDecode {
+public:
+    // The field's text; valid while the result is alive
+    static std::string_view text(const drogon::orm::Field& field) {
+        return std::string_view(field.c_str(), field.length());
+    }
+
+    // int2/int4/int8 (or any integer-valued text); nullopt for NULL or junk
+    template<typename T = int64_t>
+    static std::optional<T> integer(const drogon::orm::Field& field) {
+        if (field.isNull()) {
+            return std::nullopt;
+        }
+        std::string_view value = text(field);
+        T number = 0;
+        auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), number);
+        if (error != std::errc() || end != value.data() + value.size()) {
+            return std::nullopt;
+        }
+        return number;
+    }
+
+    // Canonical uuid text (8-4-4-4-12 hex digits) into its 16 bytes
+    static bool uuid(std::string_view value, uint8_t (&bytes)[16]) {
+        if (value.size() != 36) {
+            return false;
+        }
+        size_t out = 0;
+        for (size_t i = 0; i < 36;) {
+            if (i == 8 || i == 13 || i == 18 || i == 23) {
+                if (value[i] != '-') {
+                    return false;
+                }
+                ++i;
+                continue;
+            }
+            int high = hexDigit(value[i]);
+            int low = hexDigit(value[i + 1]);
+            if (high < 0 || low < 0) {
+                return false;
+            }
+            bytes[out++] = static_cast<uint8_t>((high << 4) | low);
+            i += 2;
+        }
+        return true;
+    }
+
+private:
+    static int hexDigit(char c) {
+        if (c >= '0' && c <= '9') {
+            return c - '0';
+        }
+        if (c >= 'a' && c <= 'f') {
+            return c - 'a' + 10;
+        }
+        if (c >= 'A' && c <= 'F') {
+            return c - 'A' + 10;
+        }
+        return -1;
+    }
+};
+
+} // namespace utils
+} // namespace kanba
@@ -0,0 +1,146 @@
+#include "HashExecutor.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <drogon/drogon.h>
+
+namespace kanba {
+namespace utils {
+
+namespace {
+
+using SteadyClock = std::chrono::steady_clock;
+
+struct Job {
+    std::function<void()> fn;
+    SteadyClock::time_point enqueuedAt;
+};
+
+std::mutex queueMutex;
+std::condition_variable queueCv;
+std::deque<Job> queue;
+std::vector<std::thread> workers;
+size_t queueCapacity = 0;
+bool stopping = false;
+
+std::atomic<uint64_t> active{0};
+std::atomic<uint64_t> completed{0};
+std::atomic<uint64_t> rejected{0};
+std::atomic<uint64_t> totalQueueWaitUs{0};
+std::atomic<uint64_t> totalHashUs{0};
+std::atomic<uint64_t> maxHashUs{0};
+
+uint64_t elapsedUs(SteadyClock::time_point from, SteadyClock::time_point to) {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(to - from).count()
+    );
+}
+
+void workerLoop() {
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock lock(queueMutex);
+            queueCv.wait(lock, [] { return stopping || !queue.empty(); });
+            if (queue.empty()) {
+                return;
+            }
+            job = std::move(queue.front());
+            queue.pop_front();
+        }
+
+        auto startedAt = SteadyClock::now();
+        totalQueueWaitUs.fetch_add(elapsedUs(job.enqueuedAt, startedAt), std::memory_order_relaxed);
+        active.fetch_add(1, std::memory_order_relaxed);
+
+        try {
+            job.fn();
+        } catch (const std::exception& e) {
+            LOG_ERROR << "Password hashing job failed: " << e.what();
+        }
+
+        uint64_t hashUs = elapsedUs(startedAt, SteadyClock::now());
+        active.fetch_sub(1, std::memory_order_relaxed);
+        completed.fetch_add(1, std::memory_order_relaxed);
+        totalHashUs.fetch_add(hashUs, std::memory_order_relaxed);
+
+        uint64_t prevMax = maxHashUs.load(std::memory_order_relaxed);
+        while (hashUs > prevMax &&
+               !maxHashUs.compare_exchange_weak(prevMax, hashUs, std::memory_order_relaxed)) {
+        }
+    }
+}
+
+} // namespace
+
+void HashExecutor::start(size_t workerCount, size_t capacity) {
+    std::lock_guard lock(queueMutex);
+    if (!workers.empty()) {
+        return;
+    }
+
+    stopping = false;
+    queueCapacity = capacity > 0 ? capacity : 1;
+    workerCount = workerCount > 0 ? workerCount : 1;
+    workers.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; ++i) {
+        workers.emplace_back(workerLoop);
+    }
+
+    LOG_INFO << "Password hash executor started with " << workerCount
+             << " workers, queue capacity " << queueCapacity;
+}
+
+void HashExecutor::stop() {
+    {
+        std::lock_guard lock(queueMutex);
+        stopping = true;
+    }
+    queueCv.notify_all();
+
+    for (auto& worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+
+    std::lock_guard lock(queueMutex);
+    workers.clear();
+}
+
+bool HashExecutor::submit(std::function<void()> job) {
+    {
+        std::lock_guard lock(queueMutex);
+        if (workers.empty() || stopping || queue.size() >= queueCapacity) {
+            rejected.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        queue.push_back(Job{std::move(job), SteadyClock::now()});
+    }
+    queueCv.notify_one();
+    return true;
+}
+
+HashExecutor::Stats HashExecutor::stats() {
+    Stats result;
+    {
+        std::lock_guard lock(queueMutex);
+        result.workers = workers.size();
+        result.queueCapacity = queueCapacity;
+        result.queueDepth = queue.size();
+    }
+    result.active = active.load(std::memory_order_relaxed);
+    result.completed = completed.load(std::memory_order_relaxed);
+    result.rejected = rejected.load(std::memory_order_relaxed);
+    result.totalQueueWaitUs = totalQueueWaitUs.load(std::memory_order_relaxed);
+    result.totalHashUs = totalHashUs.load(std::memory_order_relaxed);
+    result.maxHashUs = maxHashUs.load(std::memory_order_relaxed);
+    return result;
+}
+
+} // namespace utils
+} // namespace kanba
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+namespace kanba {
+namespace utils {
+
+// Fixed-size worker pool for CPU and memory heavy password hashing, kept off
+// the Drogon IO loops. The queue is bounded: submit() refuses work instead of
+// letting a login burst grow memory without limit.
+class HashExecutor {
+public:
+    struct Stats {
+        uint64_t workers = 0;
+        uint64_t queueCapacity = 0;
+        uint64_t queueDepth = 0;
+        uint64_t active = 0;
+        uint64_t completed = 0;
+        uint64_t rejected = 0;
+        uint64_t totalQueueWaitUs = 0;
+        uint64_t totalHashUs = 0;
+        uint64_t maxHashUs = 0;
+    };
+
+    // Start the worker threads (call once at startup)
+    static void start(size_t workers, size_t queueCapacity);
+
+    // Drain and join the worker threads (call after app().run() returns)
+    static void stop();
+
+    // Queue a job; returns false without running it if the queue is full
+    static bool submit(std::function<void()> job);
+
+    // Queue depth, throughput and latency counters
+    static Stats stats();
+};
+
+} // namespace utils
+} // namespace kanba
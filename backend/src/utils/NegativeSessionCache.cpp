@@ -0,0 +1,366 @@
+#include "NegativeSessionCache.h"
+#include "BloomFilter.h"
+#include "Database.h"
+#include "FieldDecode.h"
+#include <array>
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace kanba {
+namespace utils {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t SHARD_COUNT = 16;
+constexpr double BLOOM_FALSE_POSITIVE_RATE = 0.01;
+
+// LRU of session IDs the database recently reported as missing
+struct alignas(64) BadShard {
+    std::mutex mutex;
+    std::list<std::pair<std::string, Clock::time_point>> order;  // front = most recent
+    std::unordered_map<std::string, std::list<std::pair<std::string, Clock::time_point>>::iterator> index;
+};
+
+std::array<BadShard, SHARD_COUNT> badShards;
+std::atomic<size_t> maxBadPerShard{50000 / SHARD_COUNT};
+std::atomic<int64_t> badTtlSeconds{30};
+
+std::atomic<uint64_t> rejectedMalformed{0};
+std::atomic<uint64_t> rejectedKnownBad{0};
+std::atomic<uint64_t> rejectedBloom{0};
+std::atomic<uint64_t> bloomMissChecks{0};
+
+// Bloom filter of live session IDs. Null until the first full load finishes,
+// and while null it is never used to reject anything.
+std::atomic<std::shared_ptr<BloomFilter>> bloom;
+std::atomic<bool> bloomEnabled{true};
+std::atomic<size_t> bloomCapacity{1000000};
+
+std::atomic<int64_t> overlapMs{30000};
+
+// A filter miss may be a session another node created since the last sync,
+// so misses are looked up in the database at up to missChecksPerSecond (the
+// answer lands in the LRU or the filter); beyond that they are rejected.
+// Forged cookies then cost at most that many queries a second, and a login
+// on another node is only turned away under such a flood, until the next sync.
+struct MissBudget {
+    std::mutex mutex;
+    double tokens = 0;
+    double ratePerSecond = 20;
+    Clock::time_point refilledAt;
+};
+MissBudget missBudget;
+
+// Rebuild bookkeeping, guarded by syncMutex. Sessions created locally while a
+// rebuild query is in flight are replayed into the new filter before it is
+// swapped in, so they can never be rejected.
+std::mutex syncMutex;
+bool rebuildInFlight = false;
+bool incrementalInFlight = false;
+std::vector<std::string> createdDuringRebuild;
+int64_t createdWatermarkUs = 0;
+
+BadShard& badShardFor(const std::string& sessionId) {
+    return badShards[std::hash<std::string>{}(sessionId) % SHARD_COUNT];
+}
+
+// Session IDs are lowercase UUIDs (see Session::generateSessionId)
+bool isWellFormed(const std::string& sessionId) {
+    if (sessionId.size() != 36) {
+        return false;
+    }
+    for (size_t i = 0; i < sessionId.size(); ++i) {
+        char c = sessionId[i];
+        if (i == 8 || i == 13 || i == 18 || i == 23) {
+            if (c != '-') {
+                return false;
+            }
+        } else if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool takeMissCheck() {
+    std::lock_guard lock(missBudget.mutex);
+    auto now = Clock::now();
+    double elapsed = std::chrono::duration<double>(now - missBudget.refilledAt).count();
+    // One second's worth of burst
+    missBudget.tokens = std::min(missBudget.ratePerSecond, missBudget.tokens + elapsed * missBudget.ratePerSecond);
+    missBudget.refilledAt = now;
+    if (missBudget.tokens < 1.0) {
+        return false;
+    }
+    missBudget.tokens -= 1.0;
+    return true;
+}
+
+bool isRecentlyBad(const std::string& sessionId) {
+    auto& shard = badShardFor(sessionId);
+    std::lock_guard lock(shard.mutex);
+    auto it = shard.index.find(sessionId);
+    if (it == shard.index.end()) {
+        return false;
+    }
+    if (it->second->second <= Clock::now()) {
+        shard.order.erase(it->second);
+        shard.index.erase(it);
+        return false;
+    }
+    shard.order.splice(shard.order.begin(), shard.order, it->second);
+    return true;
+}
+
+void forgetBad(const std::string& sessionId) {
+    auto& shard = badShardFor(sessionId);
+    std::lock_guard lock(shard.mutex);
+    auto it = shard.index.find(sessionId);
+    if (it != shard.index.end()) {
+        shard.order.erase(it->second);
+        shard.index.erase(it);
+    }
+}
+
+void rebuildBloom();
+
+void syncNewSessions() {
+    int64_t watermark;
+    {
+        std::lock_guard lock(syncMutex);
+        if (rebuildInFlight || incrementalInFlight || !bloom.load()) {
+            return;
+        }
+        incrementalInFlight = true;
+        watermark = createdWatermarkUs;
+    }
+
+    auto db = Database::getClient();
+    if (!db) {
+        std::lock_guard lock(syncMutex);
+        incrementalInFlight = false;
+        return;
+    }
+
+    // Pick up sessions created on other nodes since the last sync. created_at
+    // is the inserting transaction's start, so a row can commit after a later
+    // one was already read: the window reaches overlapMs behind the watermark
+    db->execSqlAsync(
+        "SELECT id, (EXTRACT(EPOCH FROM created_at) * 1000000)::bigint AS created_us "
+        "FROM sessions WHERE created_at >= to_timestamp(($1::bigint - $2::bigint * 1000) / 1000000.0) "
+        "AND expires_at > NOW()",
+        [](const drogon::orm::Result& result) {
+            bool needsRebuild = false;
+            {
+                std::lock_guard lock(syncMutex);
+                incrementalInFlight = false;
+                auto filter = bloom.load();
+                if (!filter) {
+                    return;
+                }
+                for (const auto& row : result) {
+                    // Re-read rows are already in; adding them again would
+                    // only inflate the count that triggers a rebuild
+                    auto sessionId = FieldDecode::text(row["id"]);
+                    if (!filter->mightContain(sessionId)) {
+                        filter->add(sessionId);
+                    }
+                    createdWatermarkUs = std::max(createdWatermarkUs, FieldDecode::integer(row["created_us"]).value_or(0));
+                }
+                needsRebuild = filter->entryCount() > bloomCapacity.load(std::memory_order_relaxed);
+            }
+            if (needsRebuild) {
+                rebuildBloom();
+            }
+        },
+        [](const drogon::orm::DrogonDbException& e) {
+            LOG_ERROR << "Failed to sync session filter: " << e.base().what();
+            std::lock_guard lock(syncMutex);
+            incrementalInFlight = false;
+        },
+        watermark,
+        overlapMs.load(std::memory_order_relaxed)
+    );
+}
+
+void rebuildBloom() {
+    {
+        std::lock_guard lock(syncMutex);
+        if (rebuildInFlight) {
+            return;
+        }
+        rebuildInFlight = true;
+        createdDuringRebuild.clear();
+    }
+
+    auto db = Database::getClient();
+    if (!db) {
+        std::lock_guard lock(syncMutex);
+        rebuildInFlight = false;
+        return;
+    }
+
+    db->execSqlAsync(
+        "SELECT id, (EXTRACT(EPOCH FROM created_at) * 1000000)::bigint AS created_us "
+        "FROM sessions WHERE expires_at > NOW()",
+        [](const drogon::orm::Result& result) {
+            // Leave headroom so new sessions don't degrade the filter before the next rebuild
+            size_t capacity = std::max(bloomCapacity.load(std::memory_order_relaxed), result.size() * 2);
+            bloomCapacity.store(capacity, std::memory_order_relaxed);
+            auto filter = std::make_shared<BloomFilter>(capacity, BLOOM_FALSE_POSITIVE_RATE);
+
+            int64_t watermark = 0;
+            // Every live session: read ids and timestamps in place
+            for (const auto& row : result) {
+                filter->add(FieldDecode::text(row["id"]));
+                watermark = std::max(watermark, FieldDecode::integer(row["created_us"]).value_or(0));
+            }
+
+            std::lock_guard lock(syncMutex);
+            for (const auto& sessionId : createdDuringRebuild) {
+                filter->add(sessionId);
+            }
+            createdDuringRebuild.clear();
+            createdWatermarkUs = std::max(createdWatermarkUs, watermark);
+            bloom.store(std::move(filter));
+            rebuildInFlight = false;
+        },
+        [](const drogon::orm::DrogonDbException& e) {
+            LOG_ERROR << "Failed to rebuild session filter: " << e.base().what();
+            std::lock_guard lock(syncMutex);
+            createdDuringRebuild.clear();
+            rebuildInFlight = false;
+        }
+    );
+}
+
+} // namespace
+
+void NegativeSessionCache::configure(
+    size_t maxBadEntries,
+    std::chrono::seconds badTtl,
+    size_t capacity,
+    bool enabled,
+    double missChecksPerSecond
+) {
+    size_t perShard = maxBadEntries / SHARD_COUNT;
+    maxBadPerShard.store(perShard > 0 ? perShard : 1, std::memory_order_relaxed);
+    badTtlSeconds.store(badTtl.count(), std::memory_order_relaxed);
+    bloomCapacity.store(std::max<size_t>(capacity, 1024), std::memory_order_relaxed);
+    bloomEnabled.store(enabled, std::memory_order_relaxed);
+
+    std::lock_guard lock(missBudget.mutex);
+    missBudget.ratePerSecond = std::max(0.0, missChecksPerSecond);
+    missBudget.tokens = missBudget.ratePerSecond;
+    missBudget.refilledAt = Clock::now();
+}
+
+void NegativeSessionCache::startSync(
+    std::chrono::seconds rebuildInterval,
+    std::chrono::seconds syncInterval
+) {
+    if (!bloomEnabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    // Several sync intervals, so one slow or failed sync loses nothing
+    overlapMs.store(std::max<int64_t>(30, 3 * syncInterval.count()) * 1000, std::memory_order_relaxed);
+
+    rebuildBloom();
+    auto* loop = drogon::app().getLoop();
+    loop->runEvery(static_cast<double>(rebuildInterval.count()), [] { rebuildBloom(); });
+    loop->runEvery(static_cast<double>(syncInterval.count()), [] { syncNewSessions(); });
+}
+
+bool NegativeSessionCache::isKnownInvalid(const std::string& sessionId) {
+    if (!isWellFormed(sessionId)) {
+        rejectedMalformed.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    if (badTtlSeconds.load(std::memory_order_relaxed) > 0 && isRecentlyBad(sessionId)) {
+        rejectedKnownBad.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    if (bloomEnabled.load(std::memory_order_relaxed)) {
+        auto filter = bloom.load();
+        if (filter && !filter->mightContain(sessionId)) {
+            if (takeMissCheck()) {
+                bloomMissChecks.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            rejectedBloom.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void NegativeSessionCache::markInvalid(const std::string& sessionId) {
+    int64_t ttl = badTtlSeconds.load(std::memory_order_relaxed);
+    if (ttl <= 0) {
+        return;
+    }
+
+    auto& shard = badShardFor(sessionId);
+    auto expiresAt = Clock::now() + std::chrono::seconds(ttl);
+    std::lock_guard lock(shard.mutex);
+
+    auto it = shard.index.find(sessionId);
+    if (it != shard.index.end()) {
+        it->second->second = expiresAt;
+        shard.order.splice(shard.order.begin(), shard.order, it->second);
+        return;
+    }
+
+    if (shard.index.size() >= maxBadPerShard.load(std::memory_order_relaxed) && !shard.order.empty()) {
+        shard.index.erase(shard.order.back().first);
+        shard.order.pop_back();
+    }
+    shard.order.emplace_front(sessionId, expiresAt);
+    shard.index[sessionId] = shard.order.begin();
+}
+
+void NegativeSessionCache::markValid(const std::string& sessionId) {
+    forgetBad(sessionId);
+
+    // Under syncMutex so a concurrent rebuild either sees this ID in
+    // createdDuringRebuild or has already swapped in the filter we add to
+    std::lock_guard lock(syncMutex);
+    auto filter = bloom.load();
+    if (filter && !filter->mightContain(sessionId)) {
+        filter->add(sessionId);
+    }
+    if (rebuildInFlight) {
+        createdDuringRebuild.push_back(sessionId);
+    }
+}
+
+NegativeSessionCache::Stats NegativeSessionCache::stats() {
+    Stats result;
+    result.rejectedMalformed = rejectedMalformed.load(std::memory_order_relaxed);
+    result.rejectedKnownBad = rejectedKnownBad.load(std::memory_order_relaxed);
+    result.rejectedBloom = rejectedBloom.load(std::memory_order_relaxed);
+    result.bloomMissChecks = bloomMissChecks.load(std::memory_order_relaxed);
+    for (auto& shard : badShards) {
+        std::lock_guard lock(shard.mutex);
+        result.knownBadSize += shard.index.size();
+    }
+    if (auto filter = bloom.load()) {
+        result.bloomReady = true;
+        result.bloomEntries = filter->entryCount();
+        result.bloomBits = filter->bitCount();
+    }
+    return result;
+}
+
+} // namespace utils
+} // namespace kanba
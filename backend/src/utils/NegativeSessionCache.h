@@ -0,0 +1,64 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace kanba {
+namespace utils {
+
+// Rejects obviously invalid session cookies without a database lookup.
+// Three checks, cheapest first:
+//   1. the cookie is not shaped like a session ID we issue;
+//   2. it was recently looked up and not found (short-TTL LRU of bad IDs);
+//   3. it is absent from a Bloom filter of all live session IDs, which is
+//      rebuilt periodically from the sessions table and topped up with new
+//      sessions (local ones immediately, other nodes' on every sync).
+// Each sync re-reads an overlap window behind its watermark, so a session
+// whose insert committed late is still picked up. A session created on
+// another node is missing from the filter until the next sync, so a miss is
+// checked against the database at a bounded rate; the answer is kept (in the
+// LRU, or added to the filter) and past the rate misses are rejected.
+class NegativeSessionCache {
+public:
+    struct Stats {
+        uint64_t rejectedMalformed = 0;
+        uint64_t rejectedKnownBad = 0;
+        uint64_t rejectedBloom = 0;
+        uint64_t bloomMissChecks = 0;   // misses passed on to the database
+        uint64_t knownBadSize = 0;
+        uint64_t bloomEntries = 0;
+        uint64_t bloomBits = 0;
+        bool bloomReady = false;
+    };
+
+    // Set limits (call once at startup, before serving requests)
+    static void configure(
+        size_t maxBadEntries,
+        std::chrono::seconds badTtl,
+        size_t bloomCapacity,
+        bool bloomEnabled,
+        double missChecksPerSecond
+    );
+
+    // Load the Bloom filter and schedule its refresh timers; must run on a
+    // started app (e.g. from a beginning advice) so the DB client exists
+    static void startSync(
+        std::chrono::seconds rebuildInterval,
+        std::chrono::seconds syncInterval
+    );
+
+    // True if the session can be rejected without asking the database
+    static bool isKnownInvalid(const std::string& sessionId);
+
+    // Record a session the database did not find (or that was deleted)
+    static void markInvalid(const std::string& sessionId);
+
+    // Record a newly created session, or one the database found
+    static void markValid(const std::string& sessionId);
+
+    static Stats stats();
+};
+
+} // namespace utils
+} // namespace kanba
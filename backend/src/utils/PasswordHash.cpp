@@ -1,11 +1,70 @@
 #include "PasswordHash.h"
+#include "HashExecutor.h"
+#include <drogon/drogon.h>
 #include <sodium.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
 #include <cstring>
 #include <stdexcept>
 
 namespace kanba {
 namespace utils {
 
+namespace {
+
+// Calibrated below 16 MiB Argon2 loses most of its memory hardness
+constexpr size_t MIN_CALIBRATED_MEMORY = 16 * 1024 * 1024;
+constexpr unsigned long long MAX_CALIBRATED_OPS = 16;
+
+std::atomic<unsigned long long> currentOpsLimit{crypto_pwhash_OPSLIMIT_INTERACTIVE};
+std::atomic<size_t> currentMemLimit{crypto_pwhash_MEMLIMIT_INTERACTIVE};
+
+// Wall time of one hash with the given parameters
+std::chrono::microseconds timeHash(unsigned long long ops, size_t mem) {
+    char hashed[crypto_pwhash_STRBYTES];
+    const char sample[] = "calibration-password";
+    auto start = std::chrono::steady_clock::now();
+    if (crypto_pwhash_str(hashed, sample, sizeof(sample) - 1, ops, mem) != 0) {
+        throw std::runtime_error("Password hashing failed (out of memory)");
+    }
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start
+    );
+}
+
+// True when an encoded hash is weaker than the current parameters: another
+// algorithm, fewer passes or less memory. Calibration differs slightly from
+// node to node and restart to restart, so a hash made with higher costs is
+// kept; replacing it in either direction would rehash on every login.
+bool weakerThanCurrent(const std::string& storedHash) {
+    unsigned long long memKiB = 0;
+    unsigned long long passes = 0;
+    unsigned parallelism = 0;
+    if (std::sscanf(storedHash.c_str(), "$argon2id$v=19$m=%llu,t=%llu,p=%u$",
+                    &memKiB, &passes, &parallelism) != 3) {
+        return crypto_pwhash_str_needs_rehash(
+            storedHash.c_str(),
+            currentOpsLimit.load(std::memory_order_relaxed),
+            currentMemLimit.load(std::memory_order_relaxed)
+        ) != 0;
+    }
+    return passes < currentOpsLimit.load(std::memory_order_relaxed) ||
+           memKiB < currentMemLimit.load(std::memory_order_relaxed) / 1024;
+}
+
+// Deliver a result on the event loop that started the operation, or inline
+// when the caller was not running on a loop (e.g. at startup)
+void completeOn(trantor::EventLoop* loop, std::function<void()> fn) {
+    if (loop) {
+        loop->queueInLoop(std::move(fn));
+    } else {
+        fn();
+    }
+}
+
+} // namespace
+
 bool PasswordHash::initialize() {
     if (sodium_init() < 0) {
         return false;
@@ -20,8 +79,8 @@ std::string PasswordHash::hash(const std::string& password) {
         hashed,
         password.c_str(),
         password.length(),
-        crypto_pwhash_OPSLIMIT_INTERACTIVE,
-        crypto_pwhash_MEMLIMIT_INTERACTIVE
+        currentOpsLimit.load(std::memory_order_relaxed),
+        currentMemLimit.load(std::memory_order_relaxed)
     ) != 0) {
         throw std::runtime_error("Password hashing failed (out of memory)");
     }
@@ -50,6 +109,83 @@ bool PasswordHash::verify(const std::string& password, const std::string& stored
     ) == 0;
 }
 
+bool PasswordHash::verify(const std::string& password, const std::string& storedHash, bool& needsRehash) {
+    needsRehash = false;
+    if (!verify(password, storedHash)) {
+        return false;
+    }
+    needsRehash = weakerThanCurrent(storedHash);
+    return true;
+}
+
+bool PasswordHash::hashAsync(
+    const std::string& password,
+    std::function<void(std::optional<std::string> hash)> callback
+) {
+    auto* loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+    return HashExecutor::submit([password, callback = std::move(callback), loop]() mutable {
+        std::optional<std::string> result;
+        try {
+            result = hash(password);
+        } catch (const std::exception& e) {
+            LOG_ERROR << e.what();
+        }
+        completeOn(loop, [callback = std::move(callback), result = std::move(result)]() mutable {
+            callback(std::move(result));
+        });
+    });
+}
+
+bool PasswordHash::verifyAsync(
+    const std::string& password,
+    const std::string& storedHash,
+    std::function<void(bool valid, bool needsRehash)> callback
+) {
+    auto* loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+    return HashExecutor::submit([password, storedHash, callback = std::move(callback), loop]() mutable {
+        bool needsRehash = false;
+        bool valid = verify(password, storedHash, needsRehash);
+        completeOn(loop, [callback = std::move(callback), valid, needsRehash]() {
+            callback(valid, needsRehash);
+        });
+    });
+}
+
+void PasswordHash::calibrate(std::chrono::milliseconds timeBudget, size_t maxMemory) {
+    auto budget = std::chrono::duration_cast<std::chrono::microseconds>(timeBudget);
+    size_t mem = std::max(maxMemory, MIN_CALIBRATED_MEMORY);
+
+    // One pass at the memory ceiling; halve memory while even that is too slow
+    timeHash(crypto_pwhash_OPSLIMIT_MIN, mem);  // warm up page faults
+    auto onePass = timeHash(crypto_pwhash_OPSLIMIT_MIN, mem);
+    while (onePass > budget && mem / 2 >= MIN_CALIBRATED_MEMORY) {
+        mem /= 2;
+        onePass = timeHash(crypto_pwhash_OPSLIMIT_MIN, mem);
+    }
+
+    // Argon2 time grows linearly with passes; spend the rest of the budget on them
+    unsigned long long ops = crypto_pwhash_OPSLIMIT_MIN;
+    if (onePass.count() > 0) {
+        ops = static_cast<unsigned long long>(budget.count() / onePass.count());
+    }
+    ops = std::clamp<unsigned long long>(ops, crypto_pwhash_OPSLIMIT_MIN, MAX_CALIBRATED_OPS);
+
+    currentOpsLimit.store(ops, std::memory_order_relaxed);
+    currentMemLimit.store(mem, std::memory_order_relaxed);
+
+    LOG_INFO << "Argon2id calibrated: opslimit=" << ops << " memlimit=" << (mem / (1024 * 1024))
+             << "MiB, ~" << (onePass.count() * static_cast<long long>(ops) / 1000)
+             << "ms per hash (budget " << timeBudget.count() << "ms)";
+}
+
+unsigned long long PasswordHash::opsLimit() {
+    return currentOpsLimit.load(std::memory_order_relaxed);
+}
+
+size_t PasswordHash::memoryPerHash() {
+    return currentMemLimit.load(std::memory_order_relaxed);
+}
+
 bool PasswordHash::isBcryptHash(const std::string& hash) {
     return hash.length() >= 4 && (
         hash.substr(0, 4) == "$2a$" ||
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <optional>
 #include <string>
 
 namespace kanba {
@@ -14,6 +18,38 @@ public:
     // Supports both Argon2id (new) and bcrypt (legacy) hashes
     static bool verify(const std::string& password, const std::string& hash);
 
+    // Same, and report whether a valid hash was made with lower cost
+    // parameters than the current ones (or another algorithm) and should be
+    // replaced; a stronger hash is kept
+    static bool verify(const std::string& password, const std::string& hash, bool& needsRehash);
+
+    // Hash on the HashExecutor; the callback runs on the caller's event loop
+    // with std::nullopt on failure. Returns false (callback never invoked)
+    // when the executor queue is full.
+    static bool hashAsync(
+        const std::string& password,
+        std::function<void(std::optional<std::string> hash)> callback
+    );
+
+    // Verify on the HashExecutor; same completion and back-pressure rules
+    static bool verifyAsync(
+        const std::string& password,
+        const std::string& hash,
+        std::function<void(bool valid, bool needsRehash)> callback
+    );
+
+    // Pick Argon2id ops/mem limits so one hash takes about timeBudget on this
+    // machine, using at most maxMemory bytes (call once at startup, before
+    // the HashExecutor starts). Without it the libsodium "interactive"
+    // limits are used.
+    static void calibrate(std::chrono::milliseconds timeBudget, size_t maxMemory);
+
+    // Current Argon2id cost parameters
+    static unsigned long long opsLimit();
+
+    // Memory used by a single hash or verify (Argon2 memlimit), in bytes
+    static size_t memoryPerHash();
+
     // Check if a hash is bcrypt format (for migration)
     static bool isBcryptHash(const std::string& hash);
 
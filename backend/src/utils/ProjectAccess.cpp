@@ -0,0 +1,389 @@
+#include "ProjectAccess.h"
+#include "Database.h"
+#include "FieldDecode.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace kanba {
+namespace utils {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using Role = ProjectAccess::Role;
+using Access = ProjectAccess::Access;
+
+constexpr size_t SHARD_COUNT = 16;
+
+// A cached set that lacks the project is reloaded once it is this old, so a
+// project created or joined on another node shows up without waiting for the TTL
+constexpr auto MISS_RELOAD_AFTER = std::chrono::seconds(1);
+
+struct Uuid {
+    uint64_t hi = 0;
+    uint64_t lo = 0;
+    bool operator==(const Uuid& other) const { return hi == other.hi && lo == other.lo; }
+};
+
+struct UuidHash {
+    size_t operator()(const Uuid& id) const { return id.hi ^ (id.lo * 0x9e3779b97f4a7c15ULL); }
+};
+
+std::optional<Uuid> parseUuid(std::string_view text) {
+    uint8_t raw[16];
+    if (!FieldDecode::uuid(text, raw)) {
+        return std::nullopt;
+    }
+    Uuid id;
+    std::memcpy(&id.hi, raw, 8);
+    std::memcpy(&id.lo, raw + 8, 8);
+    return id;
+}
+
+// All projects of one user; immutable once published
+struct Memberships {
+    std::unordered_map<Uuid, Role, UuidHash> roles;
+    Clock::time_point loadedAt;
+};
+using MembershipsPtr = std::shared_ptr<const Memberships>;
+
+struct alignas(64) UserShard {
+    std::shared_mutex mutex;
+    std::unordered_map<Uuid, MembershipsPtr, UuidHash> users;
+    // Bumped by every invalidation so that a load that started before it
+    // does not publish stale memberships
+    uint64_t generation = 0;
+};
+
+// Column or task -> project. Never changes for the lifetime of the row, so
+// entries are only dropped to bound memory.
+struct alignas(64) ResolverShard {
+    std::shared_mutex mutex;
+    std::unordered_map<Uuid, Uuid, UuidHash> projects;
+};
+
+std::array<UserShard, SHARD_COUNT> userShards;
+std::array<ResolverShard, SHARD_COUNT> columnShards;
+std::array<ResolverShard, SHARD_COUNT> taskShards;
+
+std::atomic<size_t> maxUsersPerShard{100000 / SHARD_COUNT};
+std::atomic<size_t> maxResolvedPerShard{1000000 / SHARD_COUNT};
+std::atomic<int64_t> ttlSeconds{30};
+
+std::atomic<uint64_t> hits{0};
+std::atomic<uint64_t> loads{0};
+std::atomic<uint64_t> resolverHits{0};
+std::atomic<uint64_t> resolverLoads{0};
+std::atomic<uint64_t> denied{0};
+
+template <typename Shard>
+Shard& shardFor(std::array<Shard, SHARD_COUNT>& shards, const Uuid& id) {
+    return shards[UuidHash{}(id) % SHARD_COUNT];
+}
+
+Access decide(const Memberships& memberships, const Uuid& projectId, Role required) {
+    auto it = memberships.roles.find(projectId);
+    if (it == memberships.roles.end()) {
+        return Access::NotFound;
+    }
+    if (it->second < required) {
+        denied.fetch_add(1, std::memory_order_relaxed);
+        return Access::Denied;
+    }
+    return Access::Allowed;
+}
+
+MembershipsPtr cachedMemberships(const Uuid& userId) {
+    auto& shard = shardFor(userShards, userId);
+    std::shared_lock lock(shard.mutex);
+    auto it = shard.users.find(userId);
+    if (it == shard.users.end()) {
+        return nullptr;
+    }
+    if (Clock::now() - it->second->loadedAt >= std::chrono::seconds(ttlSeconds.load(std::memory_order_relaxed))) {
+        return nullptr;
+    }
+    return it->second;
+}
+
+void loadMemberships(const Uuid& userId, const std::string& userIdText, std::function<void(MembershipsPtr)> done) {
+    uint64_t generation;
+    {
+        auto& shard = shardFor(userShards, userId);
+        std::shared_lock lock(shard.mutex);
+        generation = shard.generation;
+    }
+    loads.fetch_add(1, std::memory_order_relaxed);
+
+    Database::execute(
+        Statements::GET_USER_MEMBERSHIPS,
+        [userId, generation, done](const drogon::orm::Result& result) {
+            auto memberships = std::make_shared<Memberships>();
+            memberships->loadedAt = Clock::now();
+            for (const auto& row : result) {
+                if (auto projectId = parseUuid(FieldDecode::text(row["project_id"]))) {
+                    memberships->roles[*projectId] = ProjectAccess::parseRole(FieldDecode::text(row["role"]));
+                }
+            }
+
+            MembershipsPtr published = std::move(memberships);
+            {
+                auto& shard = shardFor(userShards, userId);
+                std::unique_lock lock(shard.mutex);
+                if (shard.generation == generation) {
+                    if (shard.users.size() >= maxUsersPerShard.load(std::memory_order_relaxed) &&
+                        shard.users.find(userId) == shard.users.end() && !shard.users.empty()) {
+                        shard.users.erase(shard.users.begin());
+                    }
+                    shard.users[userId] = published;
+                }
+            }
+            done(std::move(published));
+        },
+        [done](const drogon::orm::DrogonDbException& e) {
+            LOG_ERROR << "Failed to load project memberships: " << e.base().what();
+            done(nullptr);
+        },
+        userIdText
+    );
+}
+
+void checkMembership(const std::string& userIdText, const Uuid& projectId, Role required, ProjectAccess::Callback callback) {
+    auto userId = parseUuid(userIdText);
+    if (!userId) {
+        callback(Access::NotFound);
+        return;
+    }
+
+    if (auto memberships = cachedMemberships(*userId)) {
+        hits.fetch_add(1, std::memory_order_relaxed);
+        Access access = decide(*memberships, projectId, required);
+        if (access != Access::NotFound || Clock::now() - memberships->loadedAt < MISS_RELOAD_AFTER) {
+            callback(access);
+            return;
+        }
+    }
+
+    loadMemberships(*userId, userIdText, [projectId, required, callback](MembershipsPtr memberships) {
+        if (!memberships) {
+            callback(Access::Error);
+            return;
+        }
+        callback(decide(*memberships, projectId, required));
+    });
+}
+
+std::optional<Uuid> cachedProjectOf(std::array<ResolverShard, SHARD_COUNT>& shards, const Uuid& id) {
+    auto& shard = shardFor(shards, id);
+    std::shared_lock lock(shard.mutex);
+    auto it = shard.projects.find(id);
+    if (it == shard.projects.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+void remember(std::array<ResolverShard, SHARD_COUNT>& shards, const Uuid& id, const Uuid& projectId) {
+    auto& shard = shardFor(shards, id);
+    std::unique_lock lock(shard.mutex);
+    if (shard.projects.size() >= maxResolvedPerShard.load(std::memory_order_relaxed) &&
+        shard.projects.find(id) == shard.projects.end() && !shard.projects.empty()) {
+        shard.projects.erase(shard.projects.begin());
+    }
+    shard.projects[id] = projectId;
+}
+
+// Resolve a column or task to its project, then check membership
+void checkChild(
+    std::array<ResolverShard, SHARD_COUNT>& shards,
+    const Statement& statement,
+    const std::string& userId,
+    const std::string& childIdText,
+    Role required,
+    ProjectAccess::Callback callback
+) {
+    auto childId = parseUuid(childIdText);
+    if (!childId) {
+        callback(Access::NotFound);
+        return;
+    }
+
+    if (auto projectId = cachedProjectOf(shards, *childId)) {
+        resolverHits.fetch_add(1, std::memory_order_relaxed);
+        checkMembership(userId, *projectId, required, std::move(callback));
+        return;
+    }
+
+    resolverLoads.fetch_add(1, std::memory_order_relaxed);
+    Database::execute(
+        statement,
+        [&shards, childId = *childId, userId, required, callback](const drogon::orm::Result& result) {
+            if (result.empty()) {
+                callback(Access::NotFound);
+                return;
+            }
+            auto projectId = parseUuid(FieldDecode::text(result[0]["project_id"]));
+            if (!projectId) {
+                callback(Access::NotFound);
+                return;
+            }
+            remember(shards, childId, *projectId);
+            checkMembership(userId, *projectId, required, callback);
+        },
+        [callback](const drogon::orm::DrogonDbException& e) {
+            LOG_ERROR << "Failed to resolve project: " << e.base().what();
+            callback(Access::Error);
+        },
+        childIdText
+    );
+}
+
+} // namespace
+
+void ProjectAccess::configure(size_t maxUsers, size_t maxResolvedIds, std::chrono::seconds ttl) {
+    maxUsersPerShard.store(std::max<size_t>(1, maxUsers / SHARD_COUNT), std::memory_order_relaxed);
+    maxResolvedPerShard.store(std::max<size_t>(1, maxResolvedIds / SHARD_COUNT), std::memory_order_relaxed);
+    ttlSeconds.store(ttl.count(), std::memory_order_relaxed);
+}
+
+void ProjectAccess::checkProject(const std::string& userId, const std::string& projectId, Role required, Callback callback) {
+    auto project = parseUuid(projectId);
+    if (!project) {
+        callback(Access::NotFound);
+        return;
+    }
+    checkMembership(userId, *project, required, std::move(callback));
+}
+
+void ProjectAccess::checkColumn(const std::string& userId, const std::string& columnId, Role required, Callback callback) {
+    checkChild(columnShards, Statements::GET_COLUMN_PROJECT,
+               userId, columnId, required, std::move(callback));
+}
+
+void ProjectAccess::checkTask(const std::string& userId, const std::string& taskId, Role required, Callback callback) {
+    checkChild(taskShards, Statements::GET_TASK_PROJECT,
+               userId, taskId, required, std::move(callback));
+}
+
+void ProjectAccess::rememberColumn(const std::string& columnId, const std::string& projectId) {
+    auto column = parseUuid(columnId);
+    auto project = parseUuid(projectId);
+    if (column && project) {
+        remember(columnShards, *column, *project);
+    }
+}
+
+void ProjectAccess::rememberTask(const std::string& taskId, const std::string& projectId) {
+    auto task = parseUuid(taskId);
+    auto project = parseUuid(projectId);
+    if (task && project) {
+        remember(taskShards, *task, *project);
+    }
+}
+
+void ProjectAccess::rememberTaskInColumn(const std::string& taskId, const std::string& columnId) {
+    auto task = parseUuid(taskId);
+    auto column = parseUuid(columnId);
+    if (!task || !column) {
+        return;
+    }
+    if (auto project = cachedProjectOf(columnShards, *column)) {
+        remember(taskShards, *task, *project);
+    }
+}
+
+void ProjectAccess::invalidateUser(const std::string& userId) {
+    auto user = parseUuid(userId);
+    if (!user) {
+        return;
+    }
+    auto& shard = shardFor(userShards, *user);
+    std::unique_lock lock(shard.mutex);
+    shard.users.erase(*user);
+    ++shard.generation;
+}
+
+void ProjectAccess::invalidateProject(const std::string& projectId) {
+    auto project = parseUuid(projectId);
+    if (!project) {
+        return;
+    }
+
+    // Rare (project deletion): rewrite every cached membership set that has it
+    for (auto& shard : userShards) {
+        std::unique_lock lock(shard.mutex);
+        for (auto& [userId, memberships] : shard.users) {
+            if (memberships->roles.count(*project)) {
+                auto updated = std::make_shared<Memberships>(*memberships);
+                updated->roles.erase(*project);
+                memberships = std::move(updated);
+            }
+        }
+        ++shard.generation;
+    }
+}
+
+ProjectAccess::Role ProjectAccess::parseRole(std::string_view role) {
+    if (role == "owner") {
+        return Role::Owner;
+    }
+    if (role == "admin") {
+        return Role::Admin;
+    }
+    return Role::Member;
+}
+
+drogon::HttpResponsePtr ProjectAccess::errorResponse(
+    Access access,
+    const std::string& notFoundMessage,
+    const std::string& deniedMessage
+) {
+    Json::Value error;
+    auto status = drogon::k500InternalServerError;
+    switch (access) {
+        case Access::NotFound:
+            error["error"] = notFoundMessage;
+            status = drogon::k404NotFound;
+            break;
+        case Access::Denied:
+            error["error"] = deniedMessage;
+            status = drogon::k403Forbidden;
+            break;
+        default:
+            error["error"] = "Database error";
+            break;
+    }
+    auto resp = drogon::HttpResponse::newHttpJsonResponse(error);
+    resp->setStatusCode(status);
+    return resp;
+}
+
+ProjectAccess::Stats ProjectAccess::stats() {
+    Stats result;
+    result.hits = hits.load(std::memory_order_relaxed);
+    result.loads = loads.load(std::memory_order_relaxed);
+    result.resolverHits = resolverHits.load(std::memory_order_relaxed);
+    result.resolverLoads = resolverLoads.load(std::memory_order_relaxed);
+    result.denied = denied.load(std::memory_order_relaxed);
+    for (auto& shard : userShards) {
+        std::shared_lock lock(shard.mutex);
+        result.cachedUsers += shard.users.size();
+    }
+    for (auto* shards : {&columnShards, &taskShards}) {
+        for (auto& shard : *shards) {
+            std::shared_lock lock(shard.mutex);
+            result.resolvedIds += shard.projects.size();
+        }
+    }
+    return result;
+}
+
+} // namespace utils
+} // namespace kanba
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <drogon/drogon.h>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace kanba {
+namespace utils {
+
+// Project-level authorization for project, column and task routes.
+//
+// Each user's memberships are loaded once (project -> role, keyed by the
+// 128-bit project UUID) and kept in a sharded in-process cache, so a check is
+// a couple of hash lookups. Columns and tasks are mapped to their project by
+// a resolver that is filled when they are created and otherwise on first use,
+// with one primary-key probe (get_column_project / get_task_project) per ID.
+// Board loads do not feed it: the board document goes out unparsed. A row's
+// project never changes, so entries are only evicted for size.
+//
+// Membership changes made through this node invalidate the cache at once; the
+// TTL bounds how long changes made on other nodes take to show up.
+class ProjectAccess {
+public:
+    enum class Role : uint8_t {
+        None = 0,
+        Member = 1,
+        Admin = 2,
+        Owner = 3
+    };
+
+    enum class Access {
+        Allowed,
+        Denied,    // member, but the role is too low
+        NotFound,  // no such project/column/task, or not a member of its project
+        Error
+    };
+
+    using Callback = std::function<void(Access access)>;
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t loads = 0;
+        uint64_t resolverHits = 0;
+        uint64_t resolverLoads = 0;
+        uint64_t denied = 0;
+        uint64_t cachedUsers = 0;
+        uint64_t resolvedIds = 0;
+    };
+
+    // Set limits (call once at startup, before serving requests)
+    static void configure(size_t maxUsers, size_t maxResolvedIds, std::chrono::seconds ttl);
+
+    // The callback runs inline when everything needed is cached
+    static void checkProject(const std::string& userId, const std::string& projectId, Role required, Callback callback);
+    static void checkColumn(const std::string& userId, const std::string& columnId, Role required, Callback callback);
+    static void checkTask(const std::string& userId, const std::string& taskId, Role required, Callback callback);
+
+    // Feed the column/task -> project resolver
+    static void rememberColumn(const std::string& columnId, const std::string& projectId);
+    static void rememberTask(const std::string& taskId, const std::string& projectId);
+    static void rememberTaskInColumn(const std::string& taskId, const std::string& columnId);
+
+    // Drop cached memberships after they change
+    static void invalidateUser(const std::string& userId);
+    static void invalidateProject(const std::string& projectId);
+
+    static Role parseRole(std::string_view role);
+
+    // 404 / 403 / 500 response for a failed check
+    static drogon::HttpResponsePtr errorResponse(
+        Access access,
+        const std::string& notFoundMessage,
+        const std::string& deniedMessage = "Insufficient project role"
+    );
+
+    static Stats stats();
+};
+
+} // namespace utils
+} // namespace kanba
@@ -0,0 +1,152 @@
+#include "QueryMetrics.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <memory>
+#include <mutex>
+
+namespace kanba {
+namespace utils {
+
+namespace {
+
+// Log-linear buckets over microseconds: values below 8 get one bucket each,
+// then every power of two is split into SUB_BUCKETS equal buckets
+constexpr int SUB_BUCKET_BITS = 3;
+constexpr uint64_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+constexpr size_t MAGNITUDES = 28;
+constexpr size_t BUCKETS = SUB_BUCKETS * MAGNITUDES;
+
+size_t bucketIndex(uint64_t micros) {
+    if (micros < SUB_BUCKETS) {
+        return static_cast<size_t>(micros);
+    }
+    int shift = std::bit_width(micros) - 1 - SUB_BUCKET_BITS;
+    size_t index = static_cast<size_t>(shift + 1) * SUB_BUCKETS + ((micros >> shift) & (SUB_BUCKETS - 1));
+    return std::min(index, BUCKETS - 1);
+}
+
+// Smallest value that lands in a bucket
+uint64_t bucketLowest(size_t index) {
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+    size_t shift = index / SUB_BUCKETS - 1;
+    return (SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+}
+
+// Written only by the shard's thread, read by snapshot()
+struct Slot {
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> errors{0};
+    std::atomic<uint64_t> rows{0};
+    std::atomic<uint64_t> totalMicros{0};
+    std::atomic<uint64_t> maxMicros{0};
+    std::atomic<uint64_t> buckets[BUCKETS] = {};
+};
+
+// Single-writer increment: a plain load and store, not a locked add
+void bump(std::atomic<uint64_t>& counter, uint64_t by = 1) {
+    counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+}
+
+// One slot per registered statement, plus one for raw SQL
+struct Shard {
+    Shard() : slots(new Slot[Statements::all().size() + 1]) {}
+
+    std::unique_ptr<Slot[]> slots;
+};
+
+// Shards outlive their threads so nothing recorded is lost
+std::mutex shardsMutex;
+std::vector<std::unique_ptr<Shard>> shards;
+
+Shard& localShard() {
+    thread_local Shard* shard = [] {
+        auto created = std::make_unique<Shard>();
+        Shard* raw = created.get();
+        std::lock_guard<std::mutex> lock(shardsMutex);
+        shards.push_back(std::move(created));
+        return raw;
+    }();
+    return *shard;
+}
+
+double percentileMs(const uint64_t (&buckets)[BUCKETS], uint64_t calls, double quantile, uint64_t maxMicros) {
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(quantile * static_cast<double>(calls) + 0.5));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            // Highest value the bucket can hold, but never above the maximum
+            uint64_t highest = i + 1 < BUCKETS ? bucketLowest(i + 1) - 1 : maxMicros;
+            return static_cast<double>(std::min(highest, maxMicros)) / 1000.0;
+        }
+    }
+    return static_cast<double>(maxMicros) / 1000.0;
+}
+
+} // namespace
+
+void QueryMetrics::record(const Statement* statement, std::chrono::nanoseconds latency, size_t rows, bool failed) {
+    uint64_t micros = static_cast<uint64_t>(
+        std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::microseconds>(latency).count())
+    );
+    Slot& slot = localShard().slots[Statements::indexOf(statement)];
+    bump(slot.calls);
+    if (failed) {
+        bump(slot.errors);
+    }
+    bump(slot.rows, rows);
+    bump(slot.totalMicros, micros);
+    if (micros > slot.maxMicros.load(std::memory_order_relaxed)) {
+        slot.maxMicros.store(micros, std::memory_order_relaxed);
+    }
+    bump(slot.buckets[bucketIndex(micros)]);
+}
+
+std::vector<QueryMetrics::StatementStats> QueryMetrics::snapshot() {
+    const auto& statements = Statements::all();
+    std::vector<StatementStats> result;
+
+    std::lock_guard<std::mutex> lock(shardsMutex);
+    for (size_t index = 0; index <= statements.size(); ++index) {
+        StatementStats stats;
+        uint64_t totalMicros = 0;
+        uint64_t maxMicros = 0;
+        uint64_t buckets[BUCKETS] = {};
+        for (const auto& shard : shards) {
+            const Slot& slot = shard->slots[index];
+            stats.calls += slot.calls.load(std::memory_order_relaxed);
+            stats.errors += slot.errors.load(std::memory_order_relaxed);
+            stats.rows += slot.rows.load(std::memory_order_relaxed);
+            totalMicros += slot.totalMicros.load(std::memory_order_relaxed);
+            maxMicros = std::max(maxMicros, slot.maxMicros.load(std::memory_order_relaxed));
+            for (size_t i = 0; i < BUCKETS; ++i) {
+                buckets[i] += slot.buckets[i].load(std::memory_order_relaxed);
+            }
+        }
+        // Shards are read while being written, so the bucket total can run
+        // slightly ahead of calls; percentiles rank against the buckets
+        uint64_t counted = 0;
+        for (uint64_t bucket : buckets) {
+            counted += bucket;
+        }
+        if (counted == 0) {
+            continue;
+        }
+
+        stats.name = index < statements.size() ? statements[index]->name : "raw_sql";
+        stats.totalMs = static_cast<double>(totalMicros) / 1000.0;
+        stats.p50Ms = percentileMs(buckets, counted, 0.50, maxMicros);
+        stats.p90Ms = percentileMs(buckets, counted, 0.90, maxMicros);
+        stats.p99Ms = percentileMs(buckets, counted, 0.99, maxMicros);
+        stats.p999Ms = percentileMs(buckets, counted, 0.999, maxMicros);
+        stats.maxMs = static_cast<double>(maxMicros) / 1000.0;
+        result.push_back(std::move(stats));
+    }
+    return result;
+}
+
+} // namespace utils
+} // namespace kanba
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Statements.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace kanba {
+namespace utils {
+
+// Per-statement latency histograms, row counts and error counts.
+//
+// utils::Database records every query here as it completes. Each thread
+// records into its own shard (relaxed loads and stores with a single writer:
+// no lock, no read-modify-write, no cache line shared with other threads);
+// snapshot() merges the shards when metrics are scraped. Latencies go into
+// log-linear buckets, eight per power of two from 1 us to about 18 minutes,
+// so percentiles are within 12.5% of the true value.
+class QueryMetrics {
+public:
+    struct StatementStats {
+        std::string name;
+        uint64_t calls = 0;
+        uint64_t errors = 0;
+        uint64_t rows = 0;
+        double totalMs = 0;
+        double p50Ms = 0;
+        double p90Ms = 0;
+        double p99Ms = 0;
+        double p999Ms = 0;
+        double maxMs = 0;
+    };
+
+    // statement is nullptr for raw SQL, which is reported as "raw_sql"
+    static void record(const Statement* statement, std::chrono::nanoseconds latency, size_t rows, bool failed);
+
+    // Merged counters of every statement called at least once
+    static std::vector<StatementStats> snapshot();
+};
+
+} // namespace utils
+} // namespace kanba
@@ -0,0 +1,84 @@
+#include "RankRebalancer.h"
+#include "Database.h"
+#include <atomic>
+
+namespace kanba {
+namespace utils {
+
+namespace {
+
+constexpr const char* REBALANCE_BATCH_SQL =
+    "SELECT rebalance_task_ranks($1) AS columns, rebalance_column_ranks($1) AS projects";
+
+// Written once by start(), read-only afterwards
+RankRebalancer::Options options;
+
+// Only one run at a time; a slow run makes the next timer tick a no-op
+std::atomic<bool> running{false};
+
+std::atomic<uint64_t> runs{0};
+std::atomic<uint64_t> columnsRebalanced{0};
+std::atomic<uint64_t> projectsRebalanced{0};
+
+// Renumber one batch of each queue; continue after a pause while either comes back full
+void runBatch() {
+    auto db = Database::getClient();
+    if (!db) {
+        running.store(false);
+        return;
+    }
+
+    db->execSqlAsync(
+        REBALANCE_BATCH_SQL,
+        [](const drogon::orm::Result& result) {
+            int columns = result.empty() ? 0 : result[0]["columns"].as<int>();
+            int projects = result.empty() ? 0 : result[0]["projects"].as<int>();
+            columnsRebalanced.fetch_add(static_cast<uint64_t>(columns), std::memory_order_relaxed);
+            projectsRebalanced.fetch_add(static_cast<uint64_t>(projects), std::memory_order_relaxed);
+
+            if (columns < options.batchSize && projects < options.batchSize) {
+                running.store(false);
+                return;
+            }
+
+            double pause = std::chrono::duration<double>(options.batchPause).count();
+            drogon::app().getLoop()->runAfter(pause, [] { runBatch(); });
+        },
+        [](const drogon::orm::DrogonDbException& e) {
+            LOG_ERROR << "Rank rebalance batch failed: " << e.base().what();
+            running.store(false);
+        },
+        options.batchSize
+    );
+}
+
+void runOnce() {
+    if (running.exchange(true)) {
+        return;
+    }
+    runs.fetch_add(1, std::memory_order_relaxed);
+    runBatch();
+}
+
+} // namespace
+
+void RankRebalancer::start(const Options& opts) {
+    options = opts;
+    if (options.batchSize < 1) {
+        options.batchSize = 1;
+    }
+
+    runOnce();
+    drogon::app().getLoop()->runEvery(static_cast<double>(options.interval.count()), [] { runOnce(); });
+}
+
+RankRebalancer::Stats RankRebalancer::stats() {
+    Stats result;
+    result.runs = runs.load(std::memory_order_relaxed);
+    result.columnsRebalanced = columnsRebalanced.load(std::memory_order_relaxed);
+    result.projectsRebalanced = projectsRebalanced.load(std::memory_order_relaxed);
+    return result;
+}
+
+} // namespace utils
+} // namespace kanba
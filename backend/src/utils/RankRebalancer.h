@@ -0,0 +1,36 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace kanba {
+namespace utils {
+
+// Background renumbering of task and column ranks, run from a timer on the
+// main event loop. Moves take a rank halfway between their neighbours (see
+// task_rank_at and column_rank_at in database/functions.sql); a column
+// whose task gaps, or a project whose column gaps, have been halved too
+// often is queued, and this renumbers the queue a batch at a time, off the
+// request path.
+class RankRebalancer {
+public:
+    struct Options {
+        std::chrono::seconds interval{30};
+        int batchSize = 20;                       // columns, and projects, per statement
+        std::chrono::milliseconds batchPause{100};
+    };
+
+    struct Stats {
+        uint64_t runs = 0;
+        uint64_t columnsRebalanced = 0;   // task ranks renumbered
+        uint64_t projectsRebalanced = 0;  // column ranks renumbered
+    };
+
+    // Run once now and then every interval; must run on a started app
+    static void start(const Options& options);
+
+    static Stats stats();
+};
+
+} // namespace utils
+} // namespace kanba
@@ -0,0 +1,180 @@
+#include "RevocationList.h"
+#include "Database.h"
+#include "FieldDecode.h"
+#include <sodium.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace kanba {
+namespace utils {
+
+namespace {
+
+// 128-bit token ID stored as two words: 16 bytes per entry plus the expiry
+struct TokenKey {
+    uint64_t hi = 0;
+    uint64_t lo = 0;
+    bool operator==(const TokenKey& other) const { return hi == other.hi && lo == other.lo; }
+};
+
+struct TokenKeyHash {
+    size_t operator()(const TokenKey& key) const { return key.hi ^ (key.lo * 0x9e3779b97f4a7c15ULL); }
+};
+
+std::shared_mutex mutex;
+std::unordered_map<TokenKey, int64_t, TokenKeyHash> revoked;  // token ID -> token expiry
+std::atomic<uint64_t> rejected{0};
+
+// revoked_at is the inserting transaction's start, so a revocation can
+// commit after a later one was already read: every sync re-reads this far
+// behind the watermark, and every FULL_SYNC_EVERY-th sync reads everything
+constexpr int64_t SYNC_OVERLAP_US = 60 * 1000000LL;
+constexpr uint64_t FULL_SYNC_EVERY = 60;
+
+// Sync bookkeeping, guarded by syncMutex
+std::mutex syncMutex;
+bool syncInFlight = false;
+int64_t revokedWatermarkUs = 0;
+uint64_t syncs = 0;
+
+TokenKey toKey(const SessionToken::TokenId& tokenId) {
+    TokenKey key;
+    std::memcpy(&key.hi, tokenId.data(), 8);
+    std::memcpy(&key.lo, tokenId.data() + 8, 8);
+    return key;
+}
+
+std::string toHex(const SessionToken::TokenId& tokenId) {
+    char hex[33];
+    sodium_bin2hex(hex, sizeof(hex), tokenId.data(), tokenId.size());
+    return std::string(hex);
+}
+
+bool fromHex(std::string_view hex, SessionToken::TokenId& tokenId) {
+    size_t len = 0;
+    return sodium_hex2bin(tokenId.data(), tokenId.size(), hex.data(), hex.size(),
+                          nullptr, &len, nullptr) == 0 && len == tokenId.size();
+}
+
+int64_t nowSeconds() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()
+    ).count();
+}
+
+void insertLocal(const SessionToken::TokenId& tokenId, int64_t expiresAt) {
+    std::unique_lock lock(mutex);
+    revoked[toKey(tokenId)] = expiresAt;
+}
+
+void pruneExpired() {
+    int64_t now = nowSeconds();
+    std::unique_lock lock(mutex);
+    for (auto it = revoked.begin(); it != revoked.end();) {
+        if (it->second <= now) {
+            it = revoked.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void sync() {
+    int64_t watermark;
+    {
+        std::lock_guard lock(syncMutex);
+        if (syncInFlight) {
+            return;
+        }
+        syncInFlight = true;
+        watermark = syncs++ % FULL_SYNC_EVERY == 0 ? 0 : revokedWatermarkUs - SYNC_OVERLAP_US;
+    }
+
+    auto db = Database::getClient();
+    if (!db) {
+        std::lock_guard lock(syncMutex);
+        syncInFlight = false;
+        return;
+    }
+
+    db->execSqlAsync(
+        "SELECT token_id, EXTRACT(EPOCH FROM expires_at)::bigint AS expires_epoch, "
+        "(EXTRACT(EPOCH FROM revoked_at) * 1000000)::bigint AS revoked_us "
+        "FROM revoked_sessions "
+        "WHERE revoked_at >= to_timestamp($1::bigint / 1000000.0) AND expires_at > NOW()",
+        [](const drogon::orm::Result& result) {
+            int64_t latest = 0;
+            for (const auto& row : result) {
+                SessionToken::TokenId tokenId;
+                if (fromHex(FieldDecode::text(row["token_id"]), tokenId)) {
+                    insertLocal(tokenId, FieldDecode::integer(row["expires_epoch"]).value_or(0));
+                }
+                latest = std::max(latest, FieldDecode::integer(row["revoked_us"]).value_or(0));
+            }
+            pruneExpired();
+
+            std::lock_guard lock(syncMutex);
+            revokedWatermarkUs = std::max(revokedWatermarkUs, latest);
+            syncInFlight = false;
+        },
+        [](const drogon::orm::DrogonDbException& e) {
+            LOG_ERROR << "Failed to sync session revocations: " << e.base().what();
+            std::lock_guard lock(syncMutex);
+            syncInFlight = false;
+        },
+        watermark
+    );
+}
+
+} // namespace
+
+void RevocationList::startSync(std::chrono::seconds syncInterval) {
+    sync();
+    drogon::app().getLoop()->runEvery(static_cast<double>(syncInterval.count()), [] { sync(); });
+}
+
+void RevocationList::revoke(const SessionToken::TokenId& tokenId, int64_t expiresAt) {
+    insertLocal(tokenId, expiresAt);
+
+    auto db = Database::getClient();
+    if (!db) {
+        return;
+    }
+
+    db->execSqlAsync(
+        "INSERT INTO revoked_sessions (token_id, expires_at) VALUES ($1, to_timestamp($2::bigint)) "
+        "ON CONFLICT (token_id) DO NOTHING",
+        [](const drogon::orm::Result&) {},
+        [](const drogon::orm::DrogonDbException& e) {
+            LOG_ERROR << "Failed to persist session revocation: " << e.base().what();
+        },
+        toHex(tokenId),
+        expiresAt
+    );
+}
+
+bool RevocationList::isRevoked(const SessionToken::TokenId& tokenId) {
+    std::shared_lock lock(mutex);
+    if (revoked.find(toKey(tokenId)) != revoked.end()) {
+        rejected.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+RevocationList::Stats RevocationList::stats() {
+    Stats result;
+    {
+        std::shared_lock lock(mutex);
+        result.size = revoked.size();
+    }
+    result.rejected = rejected.load(std::memory_order_relaxed);
+    return result;
+}
+
+} // namespace utils
+} // namespace kanba
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "SessionToken.h"
+#include <chrono>
+#include <cstdint>
+
+namespace kanba {
+namespace utils {
+
+// In-memory set of revoked signed-session token IDs, mirrored from the
+// revoked_sessions table so that a logout on one node is honoured by all of
+// them within one sync interval. Each sync re-reads a minute behind its
+// watermark and every 60th reads the whole table, so a revocation whose
+// insert committed late is still picked up. Entries are dropped once the
+// token they revoke has expired, which keeps the set proportional to recent
+// logouts.
+class RevocationList {
+public:
+    struct Stats {
+        uint64_t size = 0;
+        uint64_t rejected = 0;
+    };
+
+    // Load the table and schedule periodic syncs; must run on a started app
+    static void startSync(std::chrono::seconds syncInterval);
+
+    // Revoke locally right away and persist for the other nodes
+    static void revoke(const SessionToken::TokenId& tokenId, int64_t expiresAt);
+
+    static bool isRevoked(const SessionToken::TokenId& tokenId);
+
+    static Stats stats();
+};
+
+} // namespace utils
+} // namespace kanba
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <drogon/drogon.h>
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+namespace kanba {
+namespace utils {
+
+// How a result column is written into JSON
+enum class FieldKind : uint8_t {
+    String,   // text as-is (ids, timestamps, names)
+    Integer,  // integer or bigint
+    Json      // json/jsonb text, parsed into a JSON value
+};
+
+// One field of an entity: the result column it comes from, the JSON key it is
+// written to, and whether it may be NULL. NULL optional fields are omitted;
+// a NULL required field is written as JSON null.
+struct FieldSpec {
+    const char* column;
+    const char* key;
+    FieldKind kind;
+    bool optional;
+};
+
+// Maps result rows to JSON objects through a constexpr field table.
+//
+// Column positions are resolved once per result instead of once per field per
+// row (a name lookup in libpq lowercases and scans the column names every
+// time), values are read straight from the result buffer without a temporary
+// std::string, and keys are static strings jsoncpp does not copy. Fields the
+// result does not have are skipped, so one table serves every statement that
+// returns the entity.
+template<size_t N>
+class RowMapper {
+public:
+    constexpr explicit RowMapper(const std::array<FieldSpec, N>& fields) : fields_(fields) {}
+
+    // Field positions in one result (-1 if the result lacks the column)
+    class Columns {
+    public:
+        int operator[](size_t field) const { return positions_[field]; }
+
+    private:
+        friend class RowMapper;
+        std::array<int, N> positions_;
+    };
+
+    Columns resolve(const drogon::orm::Result& result) const {
+        Columns columns;
+        columns.positions_.fill(-1);
+        size_t count = result.columns();
+        for (size_t c = 0; c < count; ++c) {
+            const char* name = result.columnName(c);
+            for (size_t f = 0; f < N; ++f) {
+                if (columns.positions_[f] < 0 && std::strcmp(fields_[f].column, name) == 0) {
+                    columns.positions_[f] = static_cast<int>(c);
+                }
+            }
+        }
+        return columns;
+    }
+
+    // Write one row's fields into an existing object
+    void write(const drogon::orm::Row& row, const Columns& columns, Json::Value& out) const {
+        for (size_t f = 0; f < N; ++f) {
+            int position = columns[f];
+            if (position < 0) {
+                continue;
+            }
+            const FieldSpec& field = fields_[f];
+            auto value = row[static_cast<size_t>(position)];
+            if (value.isNull()) {
+                if (!field.optional) {
+                    out[Json::StaticString(field.key)] = Json::Value();
+                }
+                continue;
+            }
+
+            const char* begin = value.c_str();
+            const char* end = begin + value.length();
+            switch (field.kind) {
+                case FieldKind::String:
+                    out[Json::StaticString(field.key)] = Json::Value(begin, end);
+                    break;
+                case FieldKind::Integer: {
+                    Json::Int64 number = 0;
+                    std::from_chars(begin, end, number);
+                    out[Json::StaticString(field.key)] = number;
+                    break;
+                }
+                case FieldKind::Json: {
+                    // Unparseable JSON leaves the key out, as before
+                    Json::Value parsed;
+                    if (jsonReader().parse(begin, end, &parsed, nullptr)) {
+                        out[Json::StaticString(field.key)] = std::move(parsed);
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    // Map one row of a result
+    Json::Value object(const drogon::orm::Result& result, size_t row = 0) const {
+        Json::Value out(Json::objectValue);
+        write(result[row], resolve(result), out);
+        return out;
+    }
+
+    // Append every row of a result to a JSON array, mapping in place
+    void appendAll(const drogon::orm::Result& result, Json::Value& array) const {
+        Columns columns = resolve(result);
+        for (const auto& row : result) {
+            write(row, columns, array.append(Json::Value(Json::objectValue)));
+        }
+    }
+
+    Json::Value array(const drogon::orm::Result& result) const {
+        Json::Value out(Json::arrayValue);
+        appendAll(result, out);
+        return out;
+    }
+
+private:
+    static Json::CharReader& jsonReader() {
+        thread_local std::unique_ptr<Json::CharReader> reader(Json::CharReaderBuilder().newCharReader());
+        return *reader;
+    }
+
+    std::array<FieldSpec, N> fields_;
+};
+
+// Field tables for the entities the API returns
+
+inline constexpr RowMapper PROJECT_MAPPER{std::array{
+    FieldSpec{"id", "id", FieldKind::String, false},
+    FieldSpec{"name", "name", FieldKind::String, false},
+    FieldSpec{"description", "description", FieldKind::String, true},
+    FieldSpec{"icon", "icon", FieldKind::String, true},
+    FieldSpec{"owner_id", "owner_id", FieldKind::String, false},
+    FieldSpec{"task_count", "task_count", FieldKind::Integer, false},
+    FieldSpec{"member_count", "member_count", FieldKind::Integer, false},
+    FieldSpec{"created_at", "created_at", FieldKind::String, false}
+}};
+
+inline constexpr RowMapper COLUMN_MAPPER{std::array{
+    FieldSpec{"id", "id", FieldKind::String, false},
+    FieldSpec{"project_id", "project_id", FieldKind::String, false},
+    FieldSpec{"name", "name", FieldKind::String, false},
+    FieldSpec{"color", "color", FieldKind::String, true},
+    FieldSpec{"position", "position", FieldKind::Integer, false},
+    FieldSpec{"task_count", "task_count", FieldKind::Integer, false}
+}};
+
+inline constexpr RowMapper TASK_MAPPER{std::array{
+    FieldSpec{"id", "id", FieldKind::String, false},
+    FieldSpec{"column_id", "column_id", FieldKind::String, false},
+    FieldSpec{"title", "title", FieldKind::String, false},
+    FieldSpec{"description", "description", FieldKind::String, true},
+    FieldSpec{"priority", "priority", FieldKind::String, false},
+    FieldSpec{"position", "position", FieldKind::Integer, false},
+    FieldSpec{"assignee_id", "assignee_id", FieldKind::String, true},
+    FieldSpec{"assignee_name", "assignee_name", FieldKind::String, true},
+    FieldSpec{"due_date", "due_date", FieldKind::String, true},
+    FieldSpec{"tags", "tags", FieldKind::Json, true},
+    FieldSpec{"created_at", "created_at", FieldKind::String, false}
+}};
+
+inline constexpr RowMapper MEMBER_MAPPER{std::array{
+    FieldSpec{"id", "id", FieldKind::String, false},
+    FieldSpec{"user_id", "user_id", FieldKind::String, false},
+    FieldSpec{"name", "name", FieldKind::String, false},
+    FieldSpec{"email", "email", FieldKind::String, false},
+    FieldSpec{"role", "role", FieldKind::String, false},
+    FieldSpec{"avatar_url", "avatar_url", FieldKind::String, true}
+}};
+
+} // namespace utils
+} // namespace kanba
@@ -1,35 +1,155 @@
 #include "Session.h"
 #include "Database.h"
+#include "FieldDecode.h"
+#include "NegativeSessionCache.h"
+#include "RevocationList.h"
+#include "SessionCache.h"
+#include "SessionRenewal.h"
+#include "SessionToken.h"
 #include <uuid/uuid.h>
+#include <chrono>
+#include <cstdlib>
 
 namespace kanba {
 namespace utils {
 
-std::string Session::generateSessionId() {
+namespace {
+
+SessionUserPtr userFromRow(const drogon::orm::Row& row) {
+    auto user = std::make_shared<SessionUser>();
+    user->id = row["id"].as<std::string>();
+    user->name = row["name"].as<std::string>();
+    user->email = row["email"].as<std::string>();
+    if (!row["avatar_url"].isNull()) {
+        user->avatarUrl = row["avatar_url"].as<std::string>();
+    }
+    return user;
+}
+
+// Signed mode: the token carries the session, only the profile may need a query
+void getUserFromSignedSession(
+    const std::string& token,
+    std::function<void(SessionUserPtr user)> callback
+) {
+    auto claims = SessionToken::verify(token);
+    if (!claims || RevocationList::isRevoked(claims->tokenId)) {
+        SessionCache::erase(token);
+        callback(nullptr);
+        return;
+    }
+
+    if (auto cached = SessionCache::get(token)) {
+        callback(std::move(cached));
+        return;
+    }
+
+    int64_t expiresAt = claims->expiresAt;
+    Database::execute(
+        Statements::GET_USER_BY_ID,
+        [callback, token, expiresAt](const drogon::orm::Result& result) {
+            if (result.empty()) {
+                callback(nullptr);
+                return;
+            }
+
+            auto user = userFromRow(result[0]);
+            SessionCache::put(
+                token,
+                user,
+                SessionCache::Clock::time_point(std::chrono::seconds(expiresAt))
+            );
+            callback(std::move(user));
+        },
+        [callback](const drogon::orm::DrogonDbException& e) {
+            LOG_ERROR << "Failed to load session user: " << e.base().what();
+            callback(nullptr);
+        },
+        claims->userId
+    );
+}
+
+} // namespace
+
+std::string Session::generateSessionId(const std::string& userId) {
+    if (SessionToken::isEnabled()) {
+        return SessionToken::issue(userId, std::chrono::seconds(SESSION_TTL_SECONDS));
+    }
+
+    // The cookie is a bearer credential: 122 random bits, nothing else
     uuid_t uuid;
     char uuidStr[37];
 
-    uuid_generate(uuid);
+    uuid_generate_random(uuid);
     uuid_unparse_lower(uuid, uuidStr);
 
     return std::string(uuidStr);
 }
 
+std::optional<std::string> Session::verifySignedSession(const std::string& token) {
+    auto claims = SessionToken::verify(token);
+    if (!claims || RevocationList::isRevoked(claims->tokenId)) {
+        return std::nullopt;
+    }
+    return claims->userId;
+}
+
+drogon::Cookie Session::makeCookie(const std::string& sessionId, bool clear) {
+    drogon::Cookie cookie(COOKIE_NAME, sessionId);
+    cookie.setHttpOnly(true);
+    cookie.setPath("/");
+
+    const char* nodeEnv = std::getenv("NODE_ENV");
+    bool isProduction = nodeEnv && std::string(nodeEnv) == "production";
+
+    if (isProduction) {
+        cookie.setSecure(true);
+        cookie.setSameSite(drogon::Cookie::SameSite::kNone);
+    } else {
+        cookie.setSameSite(drogon::Cookie::SameSite::kLax);
+    }
+
+    if (clear) {
+        cookie.setMaxAge(0);
+    } else {
+        cookie.setMaxAge(SESSION_TTL_SECONDS);
+    }
+
+    return cookie;
+}
+
 void Session::createSession(
     const std::string& sessionId,
-    const std::string& userId,
+    const SessionUser& user,
     std::function<void(bool success)> callback
 ) {
-    auto db = Database::getClient();
-    if (!db) {
-        callback(false);
+    auto cachedUser = std::make_shared<const SessionUser>(user);
+
+    // Signed tokens are self-contained; nothing to persist
+    if (SessionToken::isEnabled()) {
+        auto claims = SessionToken::verify(sessionId);
+        if (!claims) {
+            callback(false);
+            return;
+        }
+        SessionCache::put(
+            sessionId,
+            cachedUser,
+            SessionCache::Clock::time_point(std::chrono::seconds(claims->expiresAt))
+        );
+        callback(true);
         return;
     }
 
-    db->execSqlAsync(
-        "INSERT INTO sessions (id, user_id, expires_at) VALUES ($1, $2, NOW() + INTERVAL '7 days') "
-        "ON CONFLICT (id) DO UPDATE SET user_id = $2, expires_at = NOW() + INTERVAL '7 days'",
-        [callback](const drogon::orm::Result& result) {
+    Database::execute(
+        Statements::CREATE_SESSION,
+        [callback, sessionId, cachedUser](const drogon::orm::Result& result) {
+            NegativeSessionCache::markValid(sessionId);
+            SessionRenewal::noteRenewed(sessionId);
+            SessionCache::put(
+                sessionId,
+                cachedUser,
+                SessionCache::Clock::now() + std::chrono::seconds(SESSION_TTL_SECONDS)
+            );
             callback(true);
         },
         [callback](const drogon::orm::DrogonDbException& e) {
@@ -37,49 +157,94 @@ void Session::createSession(
             callback(false);
         },
         sessionId,
-        userId
+        user.id
     );
 }
 
-void Session::getUserIdFromSession(
+void Session::getUserFromSession(
     const std::string& sessionId,
-    std::function<void(std::optional<std::string> userId)> callback
+    std::function<void(SessionUserPtr user)> callback
 ) {
-    auto db = Database::getClient();
-    if (!db) {
-        callback(std::nullopt);
+    if (SessionToken::isEnabled()) {
+        getUserFromSignedSession(sessionId, std::move(callback));
         return;
     }
 
-    db->execSqlAsync(
-        "SELECT user_id FROM sessions WHERE id = $1 AND expires_at > NOW()",
-        [callback](const drogon::orm::Result& result) {
+    if (auto cached = SessionCache::get(sessionId)) {
+        callback(std::move(cached));
+        return;
+    }
+
+    // Malformed, recently rejected, or not in the live-session filter
+    if (NegativeSessionCache::isKnownInvalid(sessionId)) {
+        callback(nullptr);
+        return;
+    }
+
+    // Session validity and the user profile in a single round-trip
+    Database::execute(
+        Statements::GET_SESSION_USER,
+        [callback, sessionId](const drogon::orm::Result& result) {
             if (result.empty()) {
-                callback(std::nullopt);
-            } else {
-                callback(result[0]["user_id"].as<std::string>());
+                NegativeSessionCache::markInvalid(sessionId);
+                callback(nullptr);
+                return;
             }
+
+            // A miss the filter let through (e.g. another node's new
+            // session) is answered from memory from now on
+            NegativeSessionCache::markValid(sessionId);
+
+            auto row = result[0];
+            SessionUserPtr sessionUser = userFromRow(row);
+            SessionCache::put(
+                sessionId,
+                sessionUser,
+                SessionCache::Clock::time_point(
+                    std::chrono::seconds(FieldDecode::integer(row["expires_epoch"]).value_or(0))
+                )
+            );
+            callback(std::move(sessionUser));
         },
         [callback](const drogon::orm::DrogonDbException& e) {
             LOG_ERROR << "Failed to get session: " << e.base().what();
-            callback(std::nullopt);
+            callback(nullptr);
         },
         sessionId
     );
 }
 
+void Session::getUserIdFromSession(
+    const std::string& sessionId,
+    std::function<void(std::optional<std::string> userId)> callback
+) {
+    getUserFromSession(sessionId, [callback](SessionUserPtr user) {
+        if (!user) {
+            callback(std::nullopt);
+        } else {
+            callback(user->id);
+        }
+    });
+}
+
 void Session::deleteSession(
     const std::string& sessionId,
     std::function<void(bool success)> callback
 ) {
-    auto db = Database::getClient();
-    if (!db) {
-        callback(false);
+    SessionCache::erase(sessionId);
+
+    if (SessionToken::isEnabled()) {
+        if (auto claims = SessionToken::verify(sessionId)) {
+            RevocationList::revoke(claims->tokenId, claims->expiresAt);
+        }
+        callback(true);
         return;
     }
 
-    db->execSqlAsync(
-        "DELETE FROM sessions WHERE id = $1",
+    NegativeSessionCache::markInvalid(sessionId);
+
+    Database::execute(
+        Statements::DELETE_SESSION,
         [callback](const drogon::orm::Result& result) {
             callback(true);
         },
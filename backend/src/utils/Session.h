@@ -1,5 +1,6 @@
 #pragma once
 
+#include "SessionCache.h"
 #include <drogon/drogon.h>
 #include <string>
 #include <optional>
@@ -9,16 +10,28 @@ namespace utils {
 
 class Session {
 public:
-    // Generate a new session ID (UUID)
-    static std::string generateSessionId();
+    // Generate a new session ID for the user: a signed token when
+    // SessionToken is enabled, otherwise a random UUID
+    static std::string generateSessionId(const std::string& userId);
 
-    // Create a new session in the database
+    // Verify a signed session token in memory (MAC, expiry, revocation).
+    // Only meaningful when SessionToken is enabled; never touches the DB.
+    static std::optional<std::string> verifySignedSession(const std::string& token);
+
+    // Create a new session in the database (signed mode only caches the profile)
     static void createSession(
         const std::string& sessionId,
-        const std::string& userId,
+        const SessionUser& user,
         std::function<void(bool success)> callback
     );
 
+    // Resolve a session to its user profile in one query (or from the cache);
+    // the callback receives nullptr for unknown or expired sessions
+    static void getUserFromSession(
+        const std::string& sessionId,
+        std::function<void(SessionUserPtr user)> callback
+    );
+
     // Get user ID from session
     static void getUserIdFromSession(
         const std::string& sessionId,
@@ -42,6 +55,9 @@ public:
         std::function<void(int deletedCount)> callback
     );
 
+    // Build the session cookie; Max-Age 0 when clearing it
+    static drogon::Cookie makeCookie(const std::string& sessionId, bool clear = false);
+
     // Session cookie configuration
     static constexpr const char* COOKIE_NAME = "session";
     static constexpr int SESSION_TTL_SECONDS = 7 * 24 * 60 * 60; // 7 days
@@ -0,0 +1,197 @@
+#include "SessionCache.h"
+#include <array>
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace kanba {
+namespace utils {
+
+namespace {
+
+constexpr size_t SHARD_COUNT = 16;
+
+// Entries the clock hand may pass over before it evicts regardless
+constexpr size_t CLOCK_SWEEP = 8;
+
+struct Entry {
+    SessionUserPtr user;
+    SessionCache::Clock::time_point expiresAt;
+    std::list<std::string>::iterator slot;      // position on the shard's clock
+    std::atomic<bool> referenced{false};        // hit since the hand last passed
+};
+
+// Each shard keeps its own counters on its own cache line so that hits on
+// different shards never write to shared memory.
+struct alignas(64) Shard {
+    mutable std::shared_mutex mutex;
+    std::unordered_map<std::string, Entry> entries;
+    std::list<std::string> clock;               // session IDs, the hand at the front
+    std::unordered_multimap<std::string, std::string> byUser;  // user ID -> session IDs
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> evictions{0};
+};
+
+std::array<Shard, SHARD_COUNT> shards;
+std::atomic<size_t> maxEntriesPerShard{100000 / SHARD_COUNT};
+std::atomic<int64_t> ttlSeconds{60};
+
+Shard& shardFor(const std::string& sessionId) {
+    return shards[std::hash<std::string>{}(sessionId) % SHARD_COUNT];
+}
+
+// Caller must hold the shard's unique lock
+void unindexUser(Shard& shard, const std::string& userId, const std::string& sessionId) {
+    auto [begin, end] = shard.byUser.equal_range(userId);
+    for (auto it = begin; it != end; ++it) {
+        if (it->second == sessionId) {
+            shard.byUser.erase(it);
+            return;
+        }
+    }
+}
+
+// Caller must hold the shard's unique lock
+void removeEntry(Shard& shard, std::unordered_map<std::string, Entry>::iterator it) {
+    unindexUser(shard, it->second.user->id, it->first);
+    shard.clock.erase(it->second.slot);
+    shard.entries.erase(it);
+}
+
+// Make room for one more entry with a bounded CLOCK sweep: an expired entry
+// under the hand goes, one hit since the hand last passed is moved to the
+// back with its bit cleared, and after CLOCK_SWEEP second chances the entry
+// under the hand is evicted anyway. Constant work per insert however full
+// the shard is. Caller must hold the shard's unique lock.
+void evictForInsert(Shard& shard, SessionCache::Clock::time_point now) {
+    size_t limit = maxEntriesPerShard.load(std::memory_order_relaxed);
+    if (shard.entries.size() < limit || shard.clock.empty()) {
+        return;
+    }
+
+    for (size_t step = 0; step < CLOCK_SWEEP; ++step) {
+        auto it = shard.entries.find(shard.clock.front());
+        if (it->second.expiresAt <= now ||
+            !it->second.referenced.exchange(false, std::memory_order_relaxed)) {
+            break;
+        }
+        shard.clock.splice(shard.clock.end(), shard.clock, it->second.slot);
+    }
+
+    // Nothing cold enough under the hand: it will be reloaded from the DB
+    removeEntry(shard, shard.entries.find(shard.clock.front()));
+    shard.evictions.fetch_add(1, std::memory_order_relaxed);
+}
+
+} // namespace
+
+void SessionCache::configure(size_t maxEntries, std::chrono::seconds ttl) {
+    size_t perShard = maxEntries / SHARD_COUNT;
+    maxEntriesPerShard.store(perShard > 0 ? perShard : 1, std::memory_order_relaxed);
+    ttlSeconds.store(ttl.count(), std::memory_order_relaxed);
+}
+
+SessionUserPtr SessionCache::get(const std::string& sessionId) {
+    auto& shard = shardFor(sessionId);
+    auto now = Clock::now();
+
+    {
+        std::shared_lock lock(shard.mutex);
+        auto it = shard.entries.find(sessionId);
+        if (it != shard.entries.end() && it->second.expiresAt > now) {
+            // Relaxed and only when clear, so hot entries do not keep
+            // writing the bit under the shared lock
+            if (!it->second.referenced.load(std::memory_order_relaxed)) {
+                it->second.referenced.store(true, std::memory_order_relaxed);
+            }
+            shard.hits.fetch_add(1, std::memory_order_relaxed);
+            return it->second.user;
+        }
+    }
+
+    shard.misses.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+}
+
+void SessionCache::put(
+    const std::string& sessionId,
+    SessionUserPtr user,
+    Clock::time_point expiresAt
+) {
+    int64_t ttl = ttlSeconds.load(std::memory_order_relaxed);
+    if (ttl <= 0) {
+        return;
+    }
+
+    auto now = Clock::now();
+    auto cacheExpiry = std::min(expiresAt, now + std::chrono::seconds(ttl));
+    if (!user || cacheExpiry <= now) {
+        return;
+    }
+
+    auto& shard = shardFor(sessionId);
+    std::unique_lock lock(shard.mutex);
+    auto it = shard.entries.find(sessionId);
+    if (it == shard.entries.end()) {
+        evictForInsert(shard, now);
+        it = shard.entries.try_emplace(sessionId).first;
+        it->second.slot = shard.clock.insert(shard.clock.end(), sessionId);
+        shard.byUser.emplace(user->id, sessionId);
+    } else if (it->second.user->id != user->id) {
+        unindexUser(shard, it->second.user->id, sessionId);
+        shard.byUser.emplace(user->id, sessionId);
+    }
+    it->second.user = std::move(user);
+    it->second.expiresAt = cacheExpiry;
+}
+
+void SessionCache::erase(const std::string& sessionId) {
+    auto& shard = shardFor(sessionId);
+    std::unique_lock lock(shard.mutex);
+    auto it = shard.entries.find(sessionId);
+    if (it != shard.entries.end()) {
+        removeEntry(shard, it);
+    }
+}
+
+void SessionCache::updateUser(const SessionUserPtr& user) {
+    if (!user) {
+        return;
+    }
+
+    // Only this user's sessions are visited, through the per-shard index;
+    // shards holding none of them are never locked exclusively
+    for (auto& shard : shards) {
+        {
+            std::shared_lock lock(shard.mutex);
+            if (shard.byUser.find(user->id) == shard.byUser.end()) {
+                continue;
+            }
+        }
+        std::unique_lock lock(shard.mutex);
+        auto [begin, end] = shard.byUser.equal_range(user->id);
+        for (auto it = begin; it != end; ++it) {
+            shard.entries.find(it->second)->second.user = user;
+        }
+    }
+}
+
+SessionCache::Stats SessionCache::stats() {
+    Stats result;
+    for (auto& shard : shards) {
+        result.hits += shard.hits.load(std::memory_order_relaxed);
+        result.misses += shard.misses.load(std::memory_order_relaxed);
+        result.evictions += shard.evictions.load(std::memory_order_relaxed);
+        std::shared_lock lock(shard.mutex);
+        result.size += shard.entries.size();
+    }
+    result.capacity = maxEntriesPerShard.load(std::memory_order_relaxed) * SHARD_COUNT;
+    result.ttlSeconds = ttlSeconds.load(std::memory_order_relaxed);
+    return result;
+}
+
+} // namespace utils
+} // namespace kanba
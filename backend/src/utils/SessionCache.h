@@ -0,0 +1,66 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace kanba {
+namespace utils {
+
+// Profile of the user owning a session, as attached to authenticated requests
+struct SessionUser {
+    std::string id;
+    std::string name;
+    std::string email;
+    std::optional<std::string> avatarUrl;
+};
+
+using SessionUserPtr = std::shared_ptr<const SessionUser>;
+
+// In-process cache of session ID -> user profile, sharded by session ID so that
+// concurrent lookups from different IO loops rarely contend on the same lock.
+// Entries expire at the earlier of the session's expires_at and the cache TTL,
+// which bounds how long a session revoked on another node stays usable here.
+// A full shard makes room with a bounded CLOCK sweep, so an insert costs
+// the same however full the cache is.
+class SessionCache {
+public:
+    using Clock = std::chrono::system_clock;
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        uint64_t size = 0;
+        uint64_t capacity = 0;
+        int64_t ttlSeconds = 0;
+    };
+
+    // Set capacity and TTL (call once at startup, before serving requests)
+    static void configure(size_t maxEntries, std::chrono::seconds ttl);
+
+    // Look up a session, returning its user if cached and not expired
+    static SessionUserPtr get(const std::string& sessionId);
+
+    // Insert or refresh a session
+    static void put(
+        const std::string& sessionId,
+        SessionUserPtr user,
+        Clock::time_point expiresAt
+    );
+
+    // Remove a session (on logout)
+    static void erase(const std::string& sessionId);
+
+    // Replace the cached profile in every session of this user (after a
+    // profile update), keeping each session's expiry
+    static void updateUser(const SessionUserPtr& user);
+
+    // Snapshot of hit/miss counters and occupancy
+    static Stats stats();
+};
+
+} // namespace utils
+} // namespace kanba
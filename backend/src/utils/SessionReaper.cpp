@@ -0,0 +1,181 @@
+#include "SessionReaper.h"
+#include "Database.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace kanba {
+namespace utils {
+
+namespace {
+
+constexpr const char* SESSIONS_BATCH_SQL = "SELECT cleanup_expired_sessions_batch($1) AS deleted";
+constexpr const char* REVOCATIONS_BATCH_SQL = "SELECT cleanup_revoked_sessions_batch($1) AS deleted";
+
+// Written once by start(), read-only afterwards
+SessionReaper::Options options;
+
+// Only one run at a time; a slow run makes the next timer tick a no-op
+std::atomic<bool> running{false};
+
+std::atomic<uint64_t> runs{0};
+std::atomic<uint64_t> batches{0};
+std::atomic<uint64_t> sessionsDeleted{0};
+std::atomic<uint64_t> revocationsDeleted{0};
+std::atomic<uint64_t> partitionsCreated{0};
+std::atomic<uint64_t> partitionsDropped{0};
+
+// Delete one batch; schedule the next after a pause while batches come back full
+void runBatches(const char* sql, std::atomic<uint64_t>* counter, std::function<void()> done) {
+    auto db = Database::getClient();
+    if (!db) {
+        done();
+        return;
+    }
+
+    db->execSqlAsync(
+        sql,
+        [sql, counter, done](const drogon::orm::Result& result) {
+            int deleted = result.empty() ? 0 : result[0]["deleted"].as<int>();
+            batches.fetch_add(1, std::memory_order_relaxed);
+            counter->fetch_add(static_cast<uint64_t>(deleted), std::memory_order_relaxed);
+
+            if (deleted < options.batchSize) {
+                done();
+                return;
+            }
+
+            double pause = std::chrono::duration<double>(options.batchPause).count();
+            drogon::app().getLoop()->runAfter(pause, [sql, counter, done] {
+                runBatches(sql, counter, done);
+            });
+        },
+        [done](const drogon::orm::DrogonDbException& e) {
+            LOG_ERROR << "Session reaper batch failed: " << e.base().what();
+            done();
+        },
+        options.batchSize
+    );
+}
+
+// Detach and drop expired partitions one at a time. DETACH ... CONCURRENTLY
+// only takes SHARE UPDATE EXCLUSIVE on sessions, so logins and lookups keep
+// running; it cannot share a transaction or pipeline, hence its own client.
+// A detach interrupted last run is finished with FINALIZE.
+void dropPartitions(std::shared_ptr<std::vector<std::pair<std::string, bool>>> expired,
+                    size_t index,
+                    std::function<void()> done) {
+    auto db = Database::getUnbatchedClient();
+    if (!db || index >= expired->size()) {
+        done();
+        return;
+    }
+
+    std::string name = (*expired)[index].first;
+    bool detachPending = (*expired)[index].second;
+    std::string quoted = "\"" + name + "\"";  // sessions_pYYYYMMDD, matched by expired_session_partitions()
+    std::string detach = "ALTER TABLE sessions DETACH PARTITION " + quoted +
+                         (detachPending ? " FINALIZE" : " CONCURRENTLY");
+
+    auto failed = [done, name](const drogon::orm::DrogonDbException& e) {
+        LOG_ERROR << "Dropping session partition " << name << " failed: " << e.base().what();
+        done();
+    };
+
+    db->execSqlAsync(
+        detach,
+        [db, expired, index, done, quoted, failed](const drogon::orm::Result&) {
+            db->execSqlAsync(
+                "DROP TABLE " + quoted,
+                [expired, index, done](const drogon::orm::Result&) {
+                    partitionsDropped.fetch_add(1, std::memory_order_relaxed);
+                    dropPartitions(expired, index + 1, done);
+                },
+                failed
+            );
+        },
+        failed
+    );
+}
+
+void maintainPartitions(std::function<void()> done) {
+    auto db = Database::getClient();
+    if (!db) {
+        done();
+        return;
+    }
+
+    db->execSqlAsync(
+        "SELECT ensure_session_partitions($1) AS created",
+        [db, done](const drogon::orm::Result& result) {
+            if (!result.empty()) {
+                partitionsCreated.fetch_add(result[0]["created"].as<uint64_t>(), std::memory_order_relaxed);
+            }
+            db->execSqlAsync(
+                "SELECT name, detach_pending FROM expired_session_partitions()",
+                [done](const drogon::orm::Result& result) {
+                    auto expired = std::make_shared<std::vector<std::pair<std::string, bool>>>();
+                    for (const auto& row : result) {
+                        expired->emplace_back(row["name"].as<std::string>(), row["detach_pending"].as<bool>());
+                    }
+                    dropPartitions(expired, 0, done);
+                },
+                [done](const drogon::orm::DrogonDbException& e) {
+                    LOG_ERROR << "Listing expired session partitions failed: " << e.base().what();
+                    done();
+                }
+            );
+        },
+        [done](const drogon::orm::DrogonDbException& e) {
+            LOG_ERROR << "Session partition maintenance failed: " << e.base().what();
+            done();
+        },
+        options.partitionDaysAhead
+    );
+}
+
+void runOnce() {
+    if (running.exchange(true)) {
+        return;
+    }
+    runs.fetch_add(1, std::memory_order_relaxed);
+
+    auto reapRevocations = [] {
+        runBatches(REVOCATIONS_BATCH_SQL, &revocationsDeleted, [] { running.store(false); });
+    };
+
+    if (options.partitioned) {
+        maintainPartitions(reapRevocations);
+    } else {
+        runBatches(SESSIONS_BATCH_SQL, &sessionsDeleted, reapRevocations);
+    }
+}
+
+} // namespace
+
+void SessionReaper::start(const Options& opts) {
+    options = opts;
+    if (options.batchSize < 1) {
+        options.batchSize = 1;
+    }
+
+    runOnce();
+    drogon::app().getLoop()->runEvery(static_cast<double>(options.interval.count()), [] { runOnce(); });
+}
+
+SessionReaper::Stats SessionReaper::stats() {
+    Stats result;
+    result.runs = runs.load(std::memory_order_relaxed);
+    result.batches = batches.load(std::memory_order_relaxed);
+    result.sessionsDeleted = sessionsDeleted.load(std::memory_order_relaxed);
+    result.revocationsDeleted = revocationsDeleted.load(std::memory_order_relaxed);
+    result.partitionsCreated = partitionsCreated.load(std::memory_order_relaxed);
+    result.partitionsDropped = partitionsDropped.load(std::memory_order_relaxed);
+    return result;
+}
+
+} // namespace utils
+} // namespace kanba
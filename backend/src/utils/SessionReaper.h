@@ -0,0 +1,43 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace kanba {
+namespace utils {
+
+// Background removal of expired sessions and revocations, run from a timer on
+// the main event loop. Rows are deleted in LIMIT-ed batches with a pause
+// between batches so the reaper never holds locks for long. With a
+// range-partitioned sessions table it instead keeps daily partitions created
+// ahead of time and detaches (CONCURRENTLY) and drops the ones that have
+// fully expired. Lookups by session id cannot prune on expires_at and probe
+// every partition's index, so only 7 expiring days + partitionDaysAhead
+// partitions are kept: the default keeps about 16.
+class SessionReaper {
+public:
+    struct Options {
+        std::chrono::seconds interval{300};
+        int batchSize = 1000;
+        std::chrono::milliseconds batchPause{100};
+        bool partitioned = false;
+        int partitionDaysAhead = 8;  // the 7-day session TTL plus one
+    };
+
+    struct Stats {
+        uint64_t runs = 0;
+        uint64_t batches = 0;
+        uint64_t sessionsDeleted = 0;
+        uint64_t revocationsDeleted = 0;
+        uint64_t partitionsCreated = 0;
+        uint64_t partitionsDropped = 0;
+    };
+
+    // Run once now and then every interval; must run on a started app
+    static void start(const Options& options);
+
+    static Stats stats();
+};
+
+} // namespace utils
+} // namespace kanba
@@ -0,0 +1,196 @@
+#include "SessionRenewal.h"
+#include "Database.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace kanba {
+namespace utils {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t SHARD_COUNT = 16;
+constexpr size_t MAX_IDS_PER_UPDATE = 1000;
+
+struct alignas(64) Shard {
+    std::mutex mutex;
+    std::unordered_map<std::string, Clock::time_point> lastRenewed;
+    std::vector<std::string> pending;
+};
+
+std::array<Shard, SHARD_COUNT> shards;
+
+std::atomic<bool> enabled{false};
+std::atomic<int64_t> minIntervalSeconds{3600};
+std::atomic<int64_t> ttlSeconds{7 * 24 * 60 * 60};
+
+std::atomic<uint64_t> queued{0};
+std::atomic<uint64_t> skipped{0};
+std::atomic<uint64_t> flushes{0};
+std::atomic<uint64_t> renewed{0};
+std::atomic<uint64_t> retried{0};
+
+Shard& shardFor(const std::string& sessionId) {
+    return shards[std::hash<std::string>{}(sessionId) % SHARD_COUNT];
+}
+
+// Postgres array literal; IDs are quoted so no element can break the literal
+std::string toArrayLiteral(std::vector<std::string>::const_iterator begin,
+                           std::vector<std::string>::const_iterator end) {
+    std::string literal = "{";
+    for (auto it = begin; it != end; ++it) {
+        if (it != begin) {
+            literal += ',';
+        }
+        literal += '"';
+        for (char c : *it) {
+            if (c == '"' || c == '\\') {
+                literal += '\\';
+            }
+            literal += c;
+        }
+        literal += '"';
+    }
+    literal += '}';
+    return literal;
+}
+
+// Put the IDs of a failed renewal back for the next flush. Their lastRenewed
+// entries still suppress touch(), so without this they would not be renewed
+// again until minInterval had passed.
+void requeue(const std::vector<std::string>& sessionIds) {
+    retried.fetch_add(sessionIds.size(), std::memory_order_relaxed);
+    for (const auto& sessionId : sessionIds) {
+        auto& shard = shardFor(sessionId);
+        std::lock_guard lock(shard.mutex);
+        shard.pending.push_back(sessionId);
+    }
+}
+
+void flush() {
+    std::vector<std::string> batch;
+    auto now = Clock::now();
+    auto minInterval = std::chrono::seconds(minIntervalSeconds.load(std::memory_order_relaxed));
+
+    for (auto& shard : shards) {
+        std::lock_guard lock(shard.mutex);
+        for (auto& sessionId : shard.pending) {
+            batch.push_back(std::move(sessionId));
+        }
+        shard.pending.clear();
+
+        // Forget sessions whose skip window has passed
+        for (auto it = shard.lastRenewed.begin(); it != shard.lastRenewed.end();) {
+            if (now - it->second >= minInterval) {
+                it = shard.lastRenewed.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    if (batch.empty()) {
+        return;
+    }
+
+    auto db = Database::getClient();
+    if (!db) {
+        requeue(batch);
+        return;
+    }
+
+    int64_t ttl = ttlSeconds.load(std::memory_order_relaxed);
+    for (size_t offset = 0; offset < batch.size(); offset += MAX_IDS_PER_UPDATE) {
+        auto chunk = std::make_shared<std::vector<std::string>>(
+            batch.begin() + static_cast<std::ptrdiff_t>(offset),
+            batch.begin() + static_cast<std::ptrdiff_t>(std::min(batch.size(), offset + MAX_IDS_PER_UPDATE)));
+        flushes.fetch_add(1, std::memory_order_relaxed);
+
+        // One statement renews the whole chunk; expired sessions stay expired
+        db->execSqlAsync(
+            "UPDATE sessions s SET expires_at = NOW() + make_interval(secs => $2::bigint) "
+            "FROM unnest($1::varchar[]) AS v(id) "
+            "WHERE s.id = v.id AND s.expires_at > NOW()",
+            [](const drogon::orm::Result& result) {
+                renewed.fetch_add(result.affectedRows(), std::memory_order_relaxed);
+            },
+            [chunk](const drogon::orm::DrogonDbException& e) {
+                LOG_ERROR << "Failed to renew " << chunk->size() << " sessions, retrying next flush: "
+                          << e.base().what();
+                requeue(*chunk);
+            },
+            toArrayLiteral(chunk->begin(), chunk->end()),
+            ttl
+        );
+    }
+}
+
+} // namespace
+
+void SessionRenewal::configure(bool isEnabled, std::chrono::seconds minInterval, std::chrono::seconds ttl) {
+    enabled.store(isEnabled, std::memory_order_relaxed);
+    minIntervalSeconds.store(minInterval.count(), std::memory_order_relaxed);
+    ttlSeconds.store(ttl.count(), std::memory_order_relaxed);
+}
+
+void SessionRenewal::startFlusher(std::chrono::seconds flushInterval) {
+    if (!enabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+    drogon::app().getLoop()->runEvery(static_cast<double>(flushInterval.count()), [] { flush(); });
+}
+
+bool SessionRenewal::touch(const std::string& sessionId) {
+    if (!enabled.load(std::memory_order_relaxed)) {
+        return false;
+    }
+
+    auto now = Clock::now();
+    auto minInterval = std::chrono::seconds(minIntervalSeconds.load(std::memory_order_relaxed));
+    auto& shard = shardFor(sessionId);
+    std::lock_guard lock(shard.mutex);
+
+    auto it = shard.lastRenewed.find(sessionId);
+    if (it != shard.lastRenewed.end() && now - it->second < minInterval) {
+        skipped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    shard.lastRenewed[sessionId] = now;
+    shard.pending.push_back(sessionId);
+    queued.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void SessionRenewal::noteRenewed(const std::string& sessionId) {
+    if (!enabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    auto& shard = shardFor(sessionId);
+    std::lock_guard lock(shard.mutex);
+    shard.lastRenewed[sessionId] = Clock::now();
+}
+
+SessionRenewal::Stats SessionRenewal::stats() {
+    Stats result;
+    result.queued = queued.load(std::memory_order_relaxed);
+    result.skipped = skipped.load(std::memory_order_relaxed);
+    result.flushes = flushes.load(std::memory_order_relaxed);
+    result.renewed = renewed.load(std::memory_order_relaxed);
+    result.retried = retried.load(std::memory_order_relaxed);
+    for (auto& shard : shards) {
+        std::lock_guard lock(shard.mutex);
+        result.pending += shard.pending.size();
+    }
+    return result;
+}
+
+} // namespace utils
+} // namespace kanba
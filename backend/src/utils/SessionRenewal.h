@@ -0,0 +1,44 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace kanba {
+namespace utils {
+
+// Sliding session expiry without a write per request. Authenticated requests
+// record their session ID here; a timer on the main loop extends all recorded
+// sessions with one multi-row UPDATE per flush. A session renewed within the
+// last minInterval is not recorded again, so writes scale with active users
+// rather than with request volume. IDs of a failed UPDATE are queued again
+// for the next flush.
+class SessionRenewal {
+public:
+    struct Stats {
+        uint64_t queued = 0;
+        uint64_t skipped = 0;
+        uint64_t flushes = 0;
+        uint64_t renewed = 0;
+        uint64_t retried = 0;       // IDs re-queued after a failed UPDATE
+        uint64_t pending = 0;
+    };
+
+    // Set the renewal policy (call once at startup, before serving requests)
+    static void configure(bool enabled, std::chrono::seconds minInterval, std::chrono::seconds ttl);
+
+    // Schedule the flush timer; must run on a started app
+    static void startFlusher(std::chrono::seconds flushInterval);
+
+    // Record a request on the session. Returns true when a renewal was queued,
+    // i.e. when the caller should also refresh the session cookie.
+    static bool touch(const std::string& sessionId);
+
+    // Note a session whose expiry was just set (e.g. on login)
+    static void noteRenewed(const std::string& sessionId);
+
+    static Stats stats();
+};
+
+} // namespace utils
+} // namespace kanba
@@ -0,0 +1,194 @@
+#include "SessionToken.h"
+#include <drogon/drogon.h>
+#include <sodium.h>
+#include <uuid/uuid.h>
+#include <cstring>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+namespace kanba {
+namespace utils {
+
+namespace {
+
+constexpr uint8_t TOKEN_VERSION = 1;
+constexpr size_t PAYLOAD_BYTES = 1 + 16 + 8 + 8 + 16;
+constexpr int B64_VARIANT = sodium_base64_VARIANT_URLSAFE_NO_PADDING;
+constexpr int64_t CLOCK_SKEW_SECONDS = 60;
+
+using Key = std::array<unsigned char, crypto_auth_KEYBYTES>;
+
+// Written once by configure() at startup, read-only afterwards
+std::map<std::string, Key> keys;
+std::string activeKey;
+bool enabled = false;
+
+void putInt64(unsigned char* out, int64_t value) {
+    auto v = static_cast<uint64_t>(value);
+    for (int i = 7; i >= 0; --i) {
+        out[i] = static_cast<unsigned char>(v & 0xff);
+        v >>= 8;
+    }
+}
+
+int64_t getInt64(const unsigned char* in) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) {
+        v = (v << 8) | in[i];
+    }
+    return static_cast<int64_t>(v);
+}
+
+std::string toBase64(const unsigned char* data, size_t len) {
+    std::string out(sodium_base64_ENCODED_LEN(len, B64_VARIANT), '\0');
+    sodium_bin2base64(out.data(), out.size(), data, len, B64_VARIANT);
+    out.resize(std::strlen(out.c_str()));
+    return out;
+}
+
+bool fromBase64(const std::string& in, unsigned char* out, size_t expectedLen) {
+    size_t written = 0;
+    if (sodium_base642bin(out, expectedLen, in.data(), in.size(),
+                          nullptr, &written, nullptr, B64_VARIANT) != 0) {
+        return false;
+    }
+    return written == expectedLen;
+}
+
+int64_t nowSeconds() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()
+    ).count();
+}
+
+} // namespace
+
+bool SessionToken::configure(const std::string& keySpec, const std::string& activeKeyId) {
+    std::map<std::string, Key> parsed;
+    std::stringstream stream(keySpec);
+    std::string item;
+
+    while (std::getline(stream, item, ',')) {
+        auto colon = item.find(':');
+        if (colon == std::string::npos || colon == 0) {
+            LOG_ERROR << "Invalid session signing key entry (expected kid:hex)";
+            return false;
+        }
+
+        std::string keyId = item.substr(0, colon);
+        std::string hex = item.substr(colon + 1);
+        if (keyId.find('.') != std::string::npos) {
+            LOG_ERROR << "Session signing key ID must not contain '.': " << keyId;
+            return false;
+        }
+
+        Key key;
+        size_t keyLen = 0;
+        if (sodium_hex2bin(key.data(), key.size(), hex.data(), hex.size(),
+                           nullptr, &keyLen, nullptr) != 0 || keyLen != key.size()) {
+            LOG_ERROR << "Session signing key " << keyId << " must be "
+                      << crypto_auth_KEYBYTES * 2 << " hex characters";
+            return false;
+        }
+        parsed[keyId] = key;
+    }
+
+    if (parsed.empty()) {
+        LOG_ERROR << "No session signing keys configured";
+        return false;
+    }
+
+    std::string active = activeKeyId.empty() ? parsed.begin()->first : activeKeyId;
+    if (parsed.find(active) == parsed.end()) {
+        LOG_ERROR << "Active session signing key " << active << " is not in the key list";
+        return false;
+    }
+
+    keys = std::move(parsed);
+    activeKey = active;
+    enabled = true;
+    return true;
+}
+
+bool SessionToken::isEnabled() {
+    return enabled;
+}
+
+std::string SessionToken::issue(const std::string& userId, std::chrono::seconds ttl) {
+    unsigned char payload[PAYLOAD_BYTES];
+    payload[0] = TOKEN_VERSION;
+
+    uuid_t uid;
+    if (uuid_parse(userId.c_str(), uid) != 0) {
+        throw std::invalid_argument("User ID is not a UUID: " + userId);
+    }
+    std::memcpy(payload + 1, uid, 16);
+
+    int64_t issuedAt = nowSeconds();
+    putInt64(payload + 17, issuedAt);
+    putInt64(payload + 25, issuedAt + ttl.count());
+    randombytes_buf(payload + 33, 16);
+
+    std::string signedPart = activeKey + "." + toBase64(payload, sizeof(payload));
+
+    unsigned char mac[crypto_auth_BYTES];
+    crypto_auth(mac,
+                reinterpret_cast<const unsigned char*>(signedPart.data()),
+                signedPart.size(),
+                keys.at(activeKey).data());
+
+    return signedPart + "." + toBase64(mac, sizeof(mac));
+}
+
+std::optional<SessionToken::Claims> SessionToken::verify(const std::string& token) {
+    if (!enabled) {
+        return std::nullopt;
+    }
+
+    auto firstDot = token.find('.');
+    auto lastDot = token.rfind('.');
+    if (firstDot == std::string::npos || firstDot == lastDot) {
+        return std::nullopt;
+    }
+
+    auto key = keys.find(token.substr(0, firstDot));
+    if (key == keys.end()) {
+        return std::nullopt;
+    }
+
+    unsigned char mac[crypto_auth_BYTES];
+    if (!fromBase64(token.substr(lastDot + 1), mac, sizeof(mac))) {
+        return std::nullopt;
+    }
+    if (crypto_auth_verify(mac,
+                           reinterpret_cast<const unsigned char*>(token.data()),
+                           lastDot,
+                           key->second.data()) != 0) {
+        return std::nullopt;
+    }
+
+    unsigned char payload[PAYLOAD_BYTES];
+    if (!fromBase64(token.substr(firstDot + 1, lastDot - firstDot - 1), payload, sizeof(payload)) ||
+        payload[0] != TOKEN_VERSION) {
+        return std::nullopt;
+    }
+
+    Claims claims;
+    char uidStr[37];
+    uuid_unparse_lower(payload + 1, uidStr);
+    claims.userId = uidStr;
+    claims.issuedAt = getInt64(payload + 17);
+    claims.expiresAt = getInt64(payload + 25);
+    std::memcpy(claims.tokenId.data(), payload + 33, claims.tokenId.size());
+
+    int64_t now = nowSeconds();
+    if (claims.expiresAt <= now || claims.issuedAt > now + CLOCK_SKEW_SECONDS) {
+        return std::nullopt;
+    }
+
+    return claims;
+}
+
+} // namespace utils
+} // namespace kanba
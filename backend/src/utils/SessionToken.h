@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace kanba {
+namespace utils {
+
+// Stateless, MAC-signed session tokens (libsodium crypto_auth, HMAC-SHA512-256).
+//
+// Token layout: <keyId>.<base64url(payload)>.<base64url(mac)>, where payload is
+// version | user UUID | issued-at | expires-at | random token ID, and the MAC
+// covers "<keyId>.<payload>". Several keys can be loaded at once; new tokens
+// are signed with the active key and old ones keep verifying until their key
+// is removed, which is how keys are rotated.
+class SessionToken {
+public:
+    using TokenId = std::array<uint8_t, 16>;
+
+    struct Claims {
+        std::string userId;
+        int64_t issuedAt = 0;   // unix seconds
+        int64_t expiresAt = 0;  // unix seconds
+        TokenId tokenId{};
+    };
+
+    // Parse "kid:hex32bytes,kid2:hex32bytes" and select the signing key.
+    // Returns false (and logs) if the key list is empty or malformed.
+    static bool configure(const std::string& keySpec, const std::string& activeKeyId);
+
+    // True once configure() succeeded; sessions are then stateless
+    static bool isEnabled();
+
+    // Issue a token for the user, valid for ttl
+    static std::string issue(const std::string& userId, std::chrono::seconds ttl);
+
+    // Verify MAC, key ID and expiry; revocation is checked separately
+    static std::optional<Claims> verify(const std::string& token);
+};
+
+} // namespace utils
+} // namespace kanba
@@ -0,0 +1,387 @@
+#include "SlowQueryLog.h"
+#include "Database.h"
+#include <drogon/drogon.h>
+#include <libpq-fe.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <ctime>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+namespace kanba {
+namespace utils {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Entry {
+    const Statement* statement;
+    double latencyMs;
+    size_t rows;
+    bool failed;
+    std::time_t at;
+    SlowQueryLog::Params params;  // set only when this entry is explained
+    bool onReplica;
+};
+
+SlowQueryLog::Options options;
+std::atomic<bool> enabled{false};
+std::atomic<bool> capturing{false};
+std::atomic<int64_t> thresholdNs{0};
+
+std::mutex queueMutex;
+std::condition_variable queueCv;
+std::deque<Entry> queue;
+std::thread writer;
+bool stopping = false;
+
+// Explain rate limiting, under queueMutex
+Clock::time_point lastExplain;
+bool explainedOnce = false;
+std::vector<Clock::time_point> lastStatementExplain;  // by Statements::indexOf
+
+std::atomic<uint64_t> slowQueries{0};
+std::atomic<uint64_t> dropped{0};
+std::atomic<uint64_t> explained{0};
+std::atomic<uint64_t> explainFailures{0};
+std::atomic<bool> nestedPlans{false};
+
+// ---- Rotating log file (writer thread only) ----
+
+std::ofstream file;
+size_t fileBytes = 0;
+
+bool openLog() {
+    std::filesystem::path path(options.path);
+    std::error_code error;
+    if (path.has_parent_path()) {
+        std::filesystem::create_directories(path.parent_path(), error);
+    }
+    file.open(options.path, std::ios::app);
+    if (!file.is_open()) {
+        return false;
+    }
+    auto size = std::filesystem::file_size(path, error);
+    fileBytes = error ? 0 : static_cast<size_t>(size);
+    return true;
+}
+
+// slow_queries.log -> .1 -> .2 ... the oldest beyond maxFiles is replaced
+void rotateLog() {
+    file.close();
+    for (size_t i = options.maxFiles; i >= 1; --i) {
+        std::string from = i == 1 ? options.path : options.path + "." + std::to_string(i - 1);
+        std::string to = options.path + "." + std::to_string(i);
+        std::rename(from.c_str(), to.c_str());
+    }
+    if (options.maxFiles == 0) {
+        std::remove(options.path.c_str());
+    }
+    openLog();
+}
+
+void appendToLog(const std::string& text) {
+    if (!file.is_open() && !openLog()) {
+        return;
+    }
+    if (fileBytes > 0 && fileBytes + text.size() > options.maxFileBytes) {
+        rotateLog();
+        if (!file.is_open()) {
+            return;
+        }
+    }
+    file << text;
+    file.flush();
+    fileBytes += text.size();
+}
+
+// ---- Explain connection (writer thread only) ----
+
+// One connection per server, so a plan comes from where the query ran
+PGconn* conns[2] = {nullptr, nullptr};   // primary, replica
+PGconn* conn = nullptr;                  // the one explain() is using
+std::vector<std::string> notices;
+
+void collectNotice(void*, const char* message) {
+    notices.emplace_back(message);
+}
+
+bool connectExplain(bool onReplica) {
+    PGconn*& slot = conns[onReplica ? 1 : 0];
+    conn = slot;
+    if (conn && PQstatus(conn) == CONNECTION_OK) {
+        return true;
+    }
+    if (conn) {
+        PQfinish(conn);
+        conn = slot = nullptr;
+    }
+
+    const auto& db = Database::options();
+    const std::string& host = onReplica ? db.replicaHost : db.host;
+    std::string port = std::to_string(onReplica ? db.replicaPort : db.port);
+    const char* keys[] = {"host", "port", "dbname", "user", "password", "application_name", nullptr};
+    const char* values[] = {host.c_str(), port.c_str(), db.name.c_str(), db.user.c_str(),
+                            db.password.c_str(), "kanba-slow-query-explain", nullptr};
+    conn = PQconnectdbParams(keys, values, 0);
+    if (PQstatus(conn) != CONNECTION_OK) {
+        LOG_WARN << "Slow query explain connection failed: " << PQerrorMessage(conn);
+        PQfinish(conn);
+        conn = nullptr;
+        return false;
+    }
+    slot = conn;
+    PQsetNoticeProcessor(conn, collectNotice, nullptr);
+
+    // auto_explain reports the plans nested inside the functions as notices
+    // on this connection only. Each setting is its own statement so one the
+    // server does not know (log_parameter_max_length is PostgreSQL 16+)
+    // cannot stop the rest; parameter values are kept out of the plans.
+    PGresult* load = PQexec(conn, "LOAD 'auto_explain'");
+    bool loaded = PQresultStatus(load) == PGRES_COMMAND_OK;
+    PQclear(load);
+    if (loaded) {
+        for (const char* setting : {
+                 "SET auto_explain.log_min_duration = 0",
+                 "SET auto_explain.log_analyze = on",
+                 "SET auto_explain.log_buffers = on",
+                 "SET auto_explain.log_nested_statements = on",
+                 "SET auto_explain.log_level = notice",
+                 "SET auto_explain.log_parameter_max_length = 0",
+                 "SET client_min_messages = notice"}) {
+            PQclear(PQexec(conn, setting));
+        }
+    }
+    nestedPlans.store(loaded, std::memory_order_relaxed);
+    LOG_INFO << "Slow query explain connected to the " << (onReplica ? "replica" : "primary")
+             << (loaded ? " with auto_explain" : " (top-level plans only)");
+    return true;
+}
+
+bool run(const std::string& sql, std::string& error) {
+    PGresult* result = PQexec(conn, sql.c_str());
+    ExecStatusType status = PQresultStatus(result);
+    bool ok = status == PGRES_COMMAND_OK || status == PGRES_TUPLES_OK;
+    if (!ok) {
+        error = PQresultErrorMessage(result);
+    }
+    PQclear(result);
+    return ok;
+}
+
+// The plan text, or why there is none
+std::string explain(const Entry& entry) {
+    if (!connectExplain(entry.onReplica)) {
+        explainFailures.fetch_add(1, std::memory_order_relaxed);
+        return "  explain skipped: no connection\n";
+    }
+
+    std::string error;
+    std::ostringstream out;
+    notices.clear();
+
+    // READ ONLY on top of Statement::readOnly: a mislabelled write fails
+    // instead of running again
+    if (!run("BEGIN READ ONLY", error) ||
+        !run("SET LOCAL statement_timeout = " + std::to_string(options.explainTimeoutMs), error)) {
+        run("ROLLBACK", error);
+        explainFailures.fetch_add(1, std::memory_order_relaxed);
+        return "  explain failed: " + error;
+    }
+
+    std::vector<const char*> values;
+    for (const auto& value : *entry.params) {
+        values.push_back(value.c_str());
+    }
+    std::string sql = std::string("EXPLAIN (ANALYZE, BUFFERS) ") + entry.statement->sql;
+    PGresult* result = PQexecParams(conn, sql.c_str(), static_cast<int>(values.size()), nullptr,
+                                    values.data(), nullptr, nullptr, 0);
+    bool ok = PQresultStatus(result) == PGRES_TUPLES_OK;
+    if (ok) {
+        out << "  plan on the " << (entry.onReplica ? "replica" : "primary")
+            << " (EXPLAIN ANALYZE, BUFFERS; rolled back):\n";
+        for (int row = 0; row < PQntuples(result); ++row) {
+            out << "    " << PQgetvalue(result, row, 0) << "\n";
+        }
+        if (!notices.empty()) {
+            out << "  nested plans (auto_explain):\n";
+            for (const auto& notice : notices) {
+                std::istringstream lines(notice);
+                for (std::string line; std::getline(lines, line);) {
+                    out << "    " << line << "\n";
+                }
+            }
+        }
+    } else {
+        out << "  explain failed: " << PQresultErrorMessage(result);
+    }
+    PQclear(result);
+
+    run("ROLLBACK", error);
+
+    if (ok) {
+        explained.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        explainFailures.fetch_add(1, std::memory_order_relaxed);
+    }
+    return out.str();
+}
+
+std::string formatEntry(const Entry& entry) {
+    char when[32];
+    std::tm tm;
+    gmtime_r(&entry.at, &tm);
+    std::strftime(when, sizeof(when), "%Y-%m-%dT%H:%M:%SZ", &tm);
+
+    std::ostringstream out;
+    out << when << " slow query "
+        << (entry.statement ? entry.statement->name : "raw_sql") << ": "
+        << entry.latencyMs << " ms, " << entry.rows << " rows"
+        << (entry.failed ? ", failed" : "");
+    if (entry.statement) {
+        out << ", " << entry.statement->params.size() << " params (redacted)";
+    }
+    out << "\n";
+    return out.str();
+}
+
+void writerLoop() {
+    for (;;) {
+        Entry entry;
+        {
+            std::unique_lock lock(queueMutex);
+            queueCv.wait(lock, [] { return stopping || !queue.empty(); });
+            if (queue.empty()) {
+                break;
+            }
+            entry = std::move(queue.front());
+            queue.pop_front();
+        }
+
+        std::string text = formatEntry(entry);
+        if (entry.params) {
+            text += explain(entry);
+        }
+        appendToLog(text);
+    }
+
+    for (auto*& connection : conns) {
+        if (connection) {
+            PQfinish(connection);
+            connection = nullptr;
+        }
+    }
+    conn = nullptr;
+    file.close();
+}
+
+// Under queueMutex
+bool explainDue(const Statement* statement, Clock::time_point now) {
+    if (!options.explain || !statement || !statement->readOnly) {
+        return false;
+    }
+    if (explainedOnce && now - lastExplain < std::chrono::seconds(options.explainIntervalSeconds)) {
+        return false;
+    }
+    size_t index = Statements::indexOf(statement);
+    if (index >= lastStatementExplain.size()) {
+        return false;
+    }
+    auto& last = lastStatementExplain[index];
+    if (last != Clock::time_point() && now - last < std::chrono::seconds(options.statementIntervalSeconds)) {
+        return false;
+    }
+    last = now;
+    lastExplain = now;
+    explainedOnce = true;
+    return true;
+}
+
+} // namespace
+
+void SlowQueryLog::start(const Options& newOptions) {
+    options = newOptions;
+    if (!options.enabled) {
+        return;
+    }
+    lastStatementExplain.assign(Statements::all().size(), Clock::time_point());
+    thresholdNs.store(
+        static_cast<int64_t>(options.thresholdMs * 1e6),
+        std::memory_order_relaxed
+    );
+    stopping = false;
+    writer = std::thread(writerLoop);
+    capturing.store(options.explain, std::memory_order_relaxed);
+    enabled.store(true, std::memory_order_release);
+    LOG_INFO << "Slow query log: over " << options.thresholdMs << " ms to " << options.path
+             << (options.explain ? ", with explain" : "");
+}
+
+void SlowQueryLog::stop() {
+    if (!enabled.exchange(false)) {
+        return;
+    }
+    capturing.store(false, std::memory_order_relaxed);
+    {
+        std::lock_guard lock(queueMutex);
+        stopping = true;
+    }
+    queueCv.notify_all();
+    if (writer.joinable()) {
+        writer.join();
+    }
+}
+
+bool SlowQueryLog::capturingParams() {
+    return capturing.load(std::memory_order_relaxed);
+}
+
+void SlowQueryLog::observe(
+    const Statement* statement,
+    std::chrono::nanoseconds latency,
+    size_t rows,
+    bool failed,
+    const Params& params,
+    bool onReplica
+) {
+    if (!enabled.load(std::memory_order_acquire) ||
+        latency.count() < thresholdNs.load(std::memory_order_relaxed)) {
+        return;
+    }
+    slowQueries.fetch_add(1, std::memory_order_relaxed);
+
+    double latencyMs = std::chrono::duration<double, std::milli>(latency).count();
+    LOG_WARN << "Slow query " << (statement ? statement->name : "raw_sql") << ": "
+             << latencyMs << " ms, " << rows << " rows";
+
+    {
+        std::lock_guard lock(queueMutex);
+        if (queue.size() >= options.maxPending) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        bool explainThis = params && explainDue(statement, Clock::now());
+        queue.push_back(Entry{statement, latencyMs, rows, failed, std::time(nullptr),
+                              explainThis ? params : nullptr, onReplica});
+    }
+    queueCv.notify_one();
+}
+
+SlowQueryLog::Stats SlowQueryLog::stats() {
+    Stats stats;
+    stats.slowQueries = slowQueries.load(std::memory_order_relaxed);
+    stats.dropped = dropped.load(std::memory_order_relaxed);
+    stats.explained = explained.load(std::memory_order_relaxed);
+    stats.explainFailures = explainFailures.load(std::memory_order_relaxed);
+    stats.nestedPlans = nestedPlans.load(std::memory_order_relaxed);
+    return stats;
+}
+
+} // namespace utils
+} // namespace kanba
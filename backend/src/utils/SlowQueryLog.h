@@ -0,0 +1,95 @@
+#pragma once
+
+#include "Statements.h"
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace kanba {
+namespace utils {
+
+// Slow-query recorder with plan capture.
+//
+// utils::Database reports every query that takes longer than thresholdMs.
+// Each one is logged by statement name, latency and row count. Parameter
+// values are never logged, only how many there were. A background thread
+// appends the same entries to a size-rotated log file.
+//
+// With explain on (off by default), some slow statements are re-run under
+// EXPLAIN (ANALYZE, BUFFERS) on the log's own connection to the server they
+// ran on, primary or replica, inside a READ ONLY transaction that is rolled
+// back. Only statements marked Statement::readOnly qualify: EXPLAIN ANALYZE
+// executes the statement, so a write would run twice and take its row locks
+// again. Their parameter values are copied for the re-run; those of other
+// statements (passwords, session IDs) never are. Explains are rate limited:
+// at most one per explainIntervalSeconds overall and one per
+// statementIntervalSeconds for each statement.
+//
+// The statements are PL/pgSQL functions, so the top-level plan is only a
+// Function Scan, with its timing and buffer totals. When the connection may
+// LOAD auto_explain (superuser, or the library installed under
+// $libdir/plugins), the plans of the statements nested inside the function
+// are captured too.
+class SlowQueryLog {
+public:
+    struct Options {
+        bool enabled = true;
+        double thresholdMs = 500;
+        bool explain = false;
+        int explainIntervalSeconds = 60;      // between any two explains
+        int statementIntervalSeconds = 600;   // between explains of one statement
+        int explainTimeoutMs = 10000;         // statement_timeout for the re-run
+        std::string path = "logs/slow_queries.log";
+        size_t maxFileBytes = 10 * 1024 * 1024;
+        size_t maxFiles = 5;                  // rotated files kept besides the live one
+        size_t maxPending = 256;              // entries waiting for the writer
+    };
+
+    struct Stats {
+        uint64_t slowQueries = 0;
+        uint64_t dropped = 0;         // writer queue full
+        uint64_t explained = 0;
+        uint64_t explainFailures = 0;
+        bool nestedPlans = false;     // auto_explain available on the explain connection
+    };
+
+    // Parameter values of one query, as text, kept only for a possible explain
+    using Params = std::shared_ptr<const std::vector<std::string>>;
+
+    // Start the writer thread (call once at startup, after
+    // Database::createClients)
+    static void start(const Options& options);
+
+    // Drain and join the writer thread (call after app().run() returns)
+    static void stop();
+
+    // Whether queries should keep their parameter values for an explain
+    static bool capturingParams();
+
+    // Called by utils::Database for every completed query; cheap unless the
+    // query was slow. statement is nullptr for raw SQL, which is logged but
+    // never explained; params are only set for read-only statements
+    static void observe(
+        const Statement* statement,
+        std::chrono::nanoseconds latency,
+        size_t rows,
+        bool failed,
+        const Params& params,
+        bool onReplica = false
+    );
+
+    static Stats stats();
+
+    // A bound argument as the text Postgres would parse
+    static std::string paramText(const std::string& value) { return value; }
+    static std::string paramText(const char* value) { return value ? value : ""; }
+    static std::string paramText(bool value) { return value ? "true" : "false"; }
+    template<typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+    static std::string paramText(T value) { return std::to_string(value); }
+};
+
+} // namespace utils
+} // namespace kanba
@@ -0,0 +1,304 @@
+#include "Statements.h"
+#include <unordered_map>
+
+namespace kanba {
+namespace utils {
+
+using P = Statement::Param;
+
+constexpr bool READ_ONLY = true;
+
+// ============================================
+// Users and sessions
+// ============================================
+
+const Statement Statements::GET_USER_BY_EMAIL{
+    "get_user_by_email",
+    "SELECT * FROM get_user_by_email($1)",
+    {P::Text},
+    READ_ONLY
+};
+
+const Statement Statements::GET_USER_BY_ID{
+    "get_user_by_id",
+    "SELECT id, email, name, avatar_url FROM get_user_by_id($1::uuid)",
+    {P::Text},
+    READ_ONLY
+};
+
+const Statement Statements::CREATE_USER{
+    "create_user",
+    "SELECT * FROM create_user($1, $2, $3)",
+    {P::Text, P::Text, P::Text}
+};
+
+const Statement Statements::UPDATE_USER_NAME{
+    "update_user_name",
+    "UPDATE users SET name = $1 WHERE id = $2 RETURNING id, email, name, avatar_url",
+    {P::Text, P::Text}
+};
+
+const Statement Statements::REHASH_PASSWORD{
+    "rehash_password",
+    "UPDATE users SET password_hash = $1 WHERE id = $2 AND password_hash = $3",
+    {P::Text, P::Text, P::Text}
+};
+
+const Statement Statements::GET_SESSION_USER{
+    "get_session_user",
+    "SELECT id, email, name, avatar_url, EXTRACT(EPOCH FROM expires_at)::bigint AS expires_epoch "
+    "FROM get_session_user($1)",
+    {P::Text},
+    false,  // a read, but its parameter is the session credential
+    // Every authenticated request waits on this: fail fast, not at the pool timeout
+    2000
+};
+
+// Plain INSERT (IDs are fresh UUIDs, and an upsert on id alone would not
+// work against the partitioned table, keyed on (id, expires_at)) that also
+// creates a missing partition rather than failing the login
+const Statement Statements::CREATE_SESSION{
+    "create_session",
+    "SELECT create_session($1, $2::uuid)",
+    {P::Text, P::Text}
+};
+
+const Statement Statements::DELETE_SESSION{
+    "delete_session",
+    "DELETE FROM sessions WHERE id = $1",
+    {P::Text}
+};
+
+// ============================================
+// Projects and members
+// ============================================
+
+const Statement Statements::GET_USER_PROJECTS{
+    "get_user_projects",
+    "SELECT * FROM get_user_projects($1)",
+    {P::Text},
+    READ_ONLY,
+    3000
+};
+
+const Statement Statements::CREATE_PROJECT{
+    "create_project",
+    "SELECT create_project($1, $2, $3, $4) AS id",
+    {P::Text, P::Text, P::Text, P::Text}
+};
+
+const Statement Statements::GET_PROJECT_DETAILS{
+    "get_project_details",
+    "SELECT * FROM get_project_details($1)",
+    {P::Text},
+    READ_ONLY
+};
+
+const Statement Statements::DELETE_PROJECT{
+    "delete_project",
+    "SELECT * FROM delete_project($1, $2)",
+    {P::Text, P::Text}
+};
+
+// The whole board as one JSON document (see get_project_board)
+const Statement Statements::GET_PROJECT_BOARD{
+    "get_project_board",
+    "SELECT get_project_board($1::uuid) AS board",
+    {P::Text},
+    READ_ONLY,
+    3000
+};
+
+const Statement Statements::GET_PROJECT_MEMBERS{
+    "get_project_members",
+    "SELECT * FROM get_project_members($1)",
+    {P::Text},
+    READ_ONLY
+};
+
+// Also returns the invited user's ID so their cached memberships can be dropped
+const Statement Statements::ADD_PROJECT_MEMBER{
+    "add_project_member",
+    "SELECT add_project_member($1, $2, $3) AS added, "
+    "(SELECT u.id FROM users u WHERE u.email = $2) AS user_id",
+    {P::Text, P::Text, P::Text}
+};
+
+const Statement Statements::GET_USER_MEMBERSHIPS{
+    "get_user_memberships",
+    "SELECT project_id, role FROM get_user_memberships($1::uuid)",
+    {P::Text},
+    READ_ONLY,
+    2000
+};
+
+// ============================================
+// Columns
+// ============================================
+
+const Statement Statements::GET_PROJECT_COLUMNS{
+    "get_project_columns",
+    "SELECT * FROM get_project_columns($1)",
+    {P::Text},
+    READ_ONLY
+};
+
+const Statement Statements::CREATE_COLUMN{
+    "create_column",
+    "SELECT * FROM create_column($1, $2, $3)",
+    {P::Text, P::Text, P::Text}
+};
+
+const Statement Statements::UPDATE_COLUMN{
+    "update_column",
+    "SELECT * FROM update_column($1, $2, $3)",
+    {P::Text, P::Text, P::Text}
+};
+
+const Statement Statements::MOVE_COLUMN{
+    "move_column",
+    "SELECT move_column($1::uuid, $2) AS moved",
+    {P::Text, P::Integer}
+};
+
+const Statement Statements::DELETE_COLUMN{
+    "delete_column",
+    "SELECT * FROM delete_column($1)",
+    {P::Text}
+};
+
+const Statement Statements::GET_COLUMN_PROJECT{
+    "get_column_project",
+    "SELECT project_id FROM get_column_project($1::uuid)",
+    {P::Text},
+    READ_ONLY,
+    2000
+};
+
+// ============================================
+// Tasks
+// ============================================
+
+const Statement Statements::GET_PROJECT_TASKS{
+    "get_project_tasks",
+    "SELECT * FROM get_project_tasks($1)",
+    {P::Text},
+    READ_ONLY
+};
+
+// NULLIF turns empty strings into NULL so callers never bind a null pointer.
+// The task statements also return the project (and what else the activity
+// event needs) so the handler can queue it with utils::ActivityLog.
+const Statement Statements::CREATE_TASK{
+    "create_task",
+    "SELECT t.*, c.project_id FROM create_task("
+    "$1::uuid, $2, $3, $4, "
+    "NULLIF($5,'')::uuid, "
+    "NULLIF($6,'')::timestamptz, "
+    "$7::jsonb, $8::uuid) t "
+    "JOIN columns c ON c.id = $1::uuid",
+    {P::Text, P::Text, P::Text, P::Text, P::Text, P::Text, P::Json, P::Text}
+};
+
+// Empty strings (and 'null' tags) mean "leave unchanged"
+const Statement Statements::UPDATE_TASK{
+    "update_task",
+    "SELECT t.*, k.project_id FROM update_task("
+    "$1::uuid, "
+    "NULLIF($2,''), NULLIF($3,''), NULLIF($4,''), "
+    "NULLIF($5,'')::uuid, "
+    "NULLIF($6,'')::timestamptz, "
+    "NULLIF($7,'null')::jsonb, $8::uuid) t "
+    "JOIN tasks k ON k.id = t.id",
+    {P::Text, P::Text, P::Text, P::Text, P::Text, P::Text, P::Text, P::Text}
+};
+
+const Statement Statements::MOVE_TASK{
+    "move_task",
+    "SELECT m.moved, c.project_id, c.name AS column_name "
+    "FROM move_task($1::uuid, $2::uuid, $3, $4::uuid) AS m(moved) "
+    "LEFT JOIN columns c ON c.id = $2::uuid",
+    {P::Text, P::Text, P::Integer, P::Text}
+};
+
+const Statement Statements::DELETE_TASK{
+    "delete_task",
+    "SELECT t.project_id, t.title, delete_task(t.id, $2::uuid) AS deleted "
+    "FROM tasks t WHERE t.id = $1::uuid",
+    {P::Text, P::Text}
+};
+
+const Statement Statements::GET_TASK_PROJECT{
+    "get_task_project",
+    "SELECT project_id FROM get_task_project($1::uuid)",
+    {P::Text},
+    READ_ONLY,
+    2000
+};
+
+// ============================================
+// Activity log
+// ============================================
+
+// One row per array element. Events of projects or users deleted since they
+// were recorded are skipped or lose their user, instead of failing the whole
+// batch on a foreign key. Row ids come from the caller, so a retried batch
+// that had committed after all inserts nothing
+const Statement Statements::INSERT_ACTIVITY_BATCH{
+    "insert_activity_batch",
+    "INSERT INTO activity_log (id, project_id, user_id, action, entity_type, entity_id, details, created_at) "
+    "SELECT e.id, e.project_id, u.id, e.action, e.entity_type, e.entity_id, e.details, to_timestamp(e.created_at) "
+    "FROM unnest($1::uuid[], $2::uuid[], $3::uuid[], $4::varchar[], $5::varchar[], $6::uuid[], $7::jsonb[], "
+    "$8::float8[]) AS e(id, project_id, user_id, action, entity_type, entity_id, details, created_at) "
+    "JOIN projects p ON p.id = e.project_id "
+    "LEFT JOIN users u ON u.id = e.user_id "
+    "ON CONFLICT (id) DO NOTHING",
+    {P::Text, P::Text, P::Text, P::Text, P::Text, P::Text, P::Text, P::Text},
+    false,
+    // Off the request path, but a stuck batch holds up every later one
+    5000
+};
+
+const std::vector<const Statement*>& Statements::all() {
+    static const std::vector<const Statement*> statements = {
+        &GET_USER_BY_EMAIL, &GET_USER_BY_ID, &CREATE_USER, &UPDATE_USER_NAME,
+        &REHASH_PASSWORD, &GET_SESSION_USER, &CREATE_SESSION, &DELETE_SESSION,
+        &GET_USER_PROJECTS, &CREATE_PROJECT, &GET_PROJECT_DETAILS, &GET_PROJECT_BOARD, &DELETE_PROJECT,
+        &GET_PROJECT_MEMBERS, &ADD_PROJECT_MEMBER, &GET_USER_MEMBERSHIPS,
+        &GET_PROJECT_COLUMNS, &CREATE_COLUMN, &UPDATE_COLUMN, &MOVE_COLUMN, &DELETE_COLUMN,
+        &GET_COLUMN_PROJECT,
+        &GET_PROJECT_TASKS, &CREATE_TASK, &UPDATE_TASK, &MOVE_TASK, &DELETE_TASK,
+        &GET_TASK_PROJECT,
+        &INSERT_ACTIVITY_BATCH
+    };
+    return statements;
+}
+
+const Statement* Statements::find(const std::string& name) {
+    static const std::unordered_map<std::string, const Statement*> byName = [] {
+        std::unordered_map<std::string, const Statement*> map;
+        for (const Statement* statement : all()) {
+            map.emplace(statement->name, statement);
+        }
+        return map;
+    }();
+
+    auto it = byName.find(name);
+    return it == byName.end() ? nullptr : it->second;
+}
+
+size_t Statements::indexOf(const Statement* statement) {
+    static const std::unordered_map<const Statement*, size_t> byAddress = [] {
+        std::unordered_map<const Statement*, size_t> map;
+        for (size_t i = 0; i < all().size(); ++i) {
+            map.emplace(all()[i], i);
+        }
+        return map;
+    }();
+
+    auto it = byAddress.find(statement);
+    return it == byAddress.end() ? all().size() : it->second;
+}
+
+} // namespace utils
+} // namespace kanba
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace kanba {
+namespace utils {
+
+// A named SQL statement with the types of its $n placeholders
+struct Statement {
+    // How a parameter is bound by Database::callFunction. Text covers every
+    // type Postgres parses from text (uuid, varchar, timestamptz, ...)
+    enum class Param : uint8_t {
+        Text,
+        Integer,
+        BigInt,
+        Boolean,
+        Json
+    };
+
+    const char* name;
+    const char* sql;
+    std::vector<Param> params;
+    // Changes nothing and takes no credential: the slow query log may keep
+    // its parameter values and re-run it under EXPLAIN ANALYZE
+    bool readOnly = false;
+    int deadlineMs = 0;  // fail after this long; 0 uses Database::Options::queryDeadlineMs
+};
+
+// Registry of the statements on the request path, each declared once.
+//
+// Drogon prepares a parameterised statement on a pooled connection the first
+// time that connection sees its SQL text and reuses the prepared statement for
+// every later call with the same text. Keeping one text per statement here
+// means each statement is parsed and planned once per connection instead of
+// once per request, and gives every statement a stable name.
+class Statements {
+public:
+    // Users and sessions
+    static const Statement GET_USER_BY_EMAIL;
+    static const Statement GET_USER_BY_ID;
+    static const Statement CREATE_USER;
+    static const Statement UPDATE_USER_NAME;
+    static const Statement REHASH_PASSWORD;
+    static const Statement GET_SESSION_USER;
+    static const Statement CREATE_SESSION;
+    static const Statement DELETE_SESSION;
+
+    // Projects and members
+    static const Statement GET_USER_PROJECTS;
+    static const Statement CREATE_PROJECT;
+    static const Statement GET_PROJECT_DETAILS;
+    static const Statement GET_PROJECT_BOARD;
+    static const Statement DELETE_PROJECT;
+    static const Statement GET_PROJECT_MEMBERS;
+    static const Statement ADD_PROJECT_MEMBER;
+    static const Statement GET_USER_MEMBERSHIPS;
+
+    // Columns
+    static const Statement GET_PROJECT_COLUMNS;
+    static const Statement CREATE_COLUMN;
+    static const Statement UPDATE_COLUMN;
+    static const Statement MOVE_COLUMN;
+    static const Statement DELETE_COLUMN;
+    static const Statement GET_COLUMN_PROJECT;
+
+    // Tasks
+    static const Statement GET_PROJECT_TASKS;
+    static const Statement CREATE_TASK;
+    static const Statement UPDATE_TASK;
+    static const Statement MOVE_TASK;
+    static const Statement DELETE_TASK;
+    static const Statement GET_TASK_PROJECT;
+
+    // Activity log (written in batches by utils::ActivityLog)
+    static const Statement INSERT_ACTIVITY_BATCH;
+
+    // Every registered statement
+    static const std::vector<const Statement*>& all();
+
+    // Look up a statement by name (nullptr if not registered)
+    static const Statement* find(const std::string& name);
+
+    // Position of a statement in all(); all().size() for nullptr or an
+    // unregistered statement
+    static size_t indexOf(const Statement* statement);
+};
+
+} // namespace utils
+} // namespace kanba
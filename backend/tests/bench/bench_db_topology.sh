@@ -0,0 +1,96 @@
+#!/usr/bin/env bash
+# Load test for the database client topology (see Database::Options).
+#
+# Drives the two hottest authenticated routes against a running backend:
+#   board - GET /api/projects/{id}: one get_project_board query
+#   move  - POST /api/tasks/move: two cached access checks and one write
+# and prints wrk's latency distribution and throughput for each.
+#
+# Run it once per configuration, restarting the backend in between, e.g.
+#   DATABASE_CONNECTIONS=10 DATABASE_FAST_CLIENTS=false              (shared pool, the default)
+#   DATABASE_CONNECTIONS=4  DATABASE_FAST_CLIENTS=true               (per-IO-thread clients)
+#   DATABASE_CONNECTIONS=4  DATABASE_FAST_CLIENTS=true DATABASE_AUTO_BATCH=true
+# keeping SERVER_THREADS x connections within Postgres' max_connections.
+# GET /api/metrics reports the topology the backend actually started with
+# (pass the backend's METRICS_TOKEN to print it).
+#
+# What to look for: fast clients remove the cross-thread hand-off between the
+# IO loop and the shared pool's loop on every query, which shows in p50/p99
+# of both routes. Auto-batching pipelines queries on a connection; it helps
+# when connections, not Postgres CPU, are the bottleneck, and costs a little
+# latency when the pool is idle.
+#
+# Usage: BASE_URL=http://localhost:3001 [METRICS_TOKEN=...] ./bench_db_topology.sh [duration] [connections] [threads]
+# Requires curl, jq and wrk. A throwaway user and project are created per run.
+
+set -euo pipefail
+
+BASE_URL="${BASE_URL:-http://localhost:3001}"
+DURATION="${1:-30s}"
+CONNECTIONS="${2:-64}"
+THREADS="${3:-4}"
+TASKS=200
+
+WORK_DIR="$(mktemp -d)"
+trap 'rm -rf "$WORK_DIR"' EXIT
+COOKIES="$WORK_DIR/cookies.txt"
+
+api() {
+    local method="$1" path="$2" body="${3:-}"
+    curl -sf -b "$COOKIES" -c "$COOKIES" -X "$method" \
+        -H "Content-Type: application/json" ${body:+-d "$body"} "$BASE_URL$path"
+}
+
+email="bench-$(date +%s)-$$@example.com"
+api POST /api/auth/register "{\"email\":\"$email\",\"password\":\"bench-password-123\",\"name\":\"Bench User\"}" > /dev/null
+session="$(awk '$6 == "session" { print $7 }' "$COOKIES")"
+
+project_id="$(api POST /api/projects '{"name":"Topology Bench","description":"load test"}' | jq -r '.id')"
+board="$(api GET "/api/projects/$project_id")"
+first_column="$(jq -r '.columns[0].id' <<< "$board")"
+second_column="$(jq -r '.columns[1].id' <<< "$board")"
+
+for i in $(seq 1 "$TASKS"); do
+    column="$first_column"
+    if (( i % 2 == 0 )); then column="$second_column"; fi
+    api POST /api/tasks "{\"column_id\":\"$column\",\"title\":\"Task $i\",\"priority\":\"medium\"}" \
+        | jq -r '.id' >> "$WORK_DIR/tasks.txt"
+done
+
+cat > "$WORK_DIR/board.lua" <<EOF
+wrk.method = "GET"
+wrk.path = "/api/projects/$project_id"
+wrk.headers["Cookie"] = "session=$session"
+EOF
+
+# Moves a random task to a random position in one of the two columns
+cat > "$WORK_DIR/move.lua" <<EOF
+local tasks = {}
+for line in io.lines("$WORK_DIR/tasks.txt") do tasks[#tasks + 1] = line end
+local columns = { "$first_column", "$second_column" }
+wrk.method = "POST"
+wrk.headers["Cookie"] = "session=$session"
+wrk.headers["Content-Type"] = "application/json"
+request = function()
+    local body = string.format('{"task_id":"%s","column_id":"%s","position":%d}',
+        tasks[math.random(#tasks)], columns[math.random(2)], math.random(0, 50))
+    return wrk.format(nil, "/api/tasks/move", nil, body)
+end
+EOF
+
+topology="(set METRICS_TOKEN to report it)"
+if [[ -n "${METRICS_TOKEN:-}" ]]; then
+    topology="$(curl -sf -H "Authorization: Bearer $METRICS_TOKEN" "$BASE_URL/api/metrics" | jq -c '.database')"
+fi
+echo "topology: $topology"
+echo "wrk: $THREADS threads, $CONNECTIONS connections, $DURATION per route, $TASKS tasks on the board"
+
+echo
+echo "== board load: GET /api/projects/{id}"
+wrk -t"$THREADS" -c"$CONNECTIONS" -d"$DURATION" --latency -s "$WORK_DIR/board.lua" "$BASE_URL"
+
+echo
+echo "== task move: POST /api/tasks/move"
+wrk -t"$THREADS" -c"$CONNECTIONS" -d"$DURATION" --latency -s "$WORK_DIR/move.lua" "$BASE_URL"
+
+api DELETE "/api/projects/$project_id" > /dev/null || true
@@ -0,0 +1,80 @@
+// Hot-path cost of utils::QueryMetrics.
+//
+// Times QueryMetrics::record() (what every query pays on completion) with one
+// thread and with several threads recording at once, plus the cost of a
+// snapshot() over everything recorded. Needs no database.
+//
+// Usage: ./bench_query_metrics [records per thread] [threads]
+
+#include "utils/QueryMetrics.h"
+#include "utils/Statements.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace kanba::utils;
+
+namespace {
+
+// Spread records over the statements and a realistic latency range
+double recordNsPerCall(int records) {
+    const auto& statements = Statements::all();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < records; ++i) {
+        const Statement* statement = statements[static_cast<size_t>(i) % statements.size()];
+        QueryMetrics::record(statement, std::chrono::microseconds(200 + (i * 7919) % 50000),
+                             static_cast<size_t>(i % 50), i % 1000 == 0);
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    return elapsed / records;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int records = argc > 1 ? std::atoi(argv[1]) : 10000000;
+    int threads = argc > 2 ? std::atoi(argv[2]) : static_cast<int>(std::thread::hardware_concurrency());
+    if (records <= 0) {
+        records = 10000000;
+    }
+    if (threads <= 0) {
+        threads = 4;
+    }
+
+    recordNsPerCall(records / 10);  // warm-up, registers this thread's shard
+    double single = recordNsPerCall(records);
+    std::printf("record, 1 thread   : %6.1f ns per query\n", single);
+
+    std::vector<double> perThread(static_cast<size_t>(threads));
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&perThread, t, records] {
+            perThread[static_cast<size_t>(t)] = recordNsPerCall(records);
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    double worst = 0;
+    for (double ns : perThread) {
+        worst = std::max(worst, ns);
+    }
+    std::printf("record, %2d threads : %6.1f ns per query (slowest thread)\n", threads, worst);
+
+    auto start = std::chrono::steady_clock::now();
+    auto snapshot = QueryMetrics::snapshot();
+    auto snapshotUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    std::printf("snapshot           : %6.1f us for %zu statements over %d shards\n",
+                snapshotUs, snapshot.size(), threads + 1);
+    for (const auto& stats : snapshot) {
+        if (stats.name == std::string(Statements::MOVE_TASK.name)) {
+            std::printf("move_task          : %llu calls, p50 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+                        static_cast<unsigned long long>(stats.calls), stats.p50Ms, stats.p99Ms, stats.maxMs);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,254 @@
+// Decode-cost benchmark for text vs binary result rows.
+//
+// Seeds a 10k-task board and decodes the typed columns of get_project_tasks
+// (id and column_id as uuid, position as int4, created_at and due_date as
+// timestamptz) four ways, timing only the decode:
+//   as<>         - Field::as<std::string>() / as<int>() on the Drogon result,
+//                  the way handlers decoded rows before FieldDecode
+//   in place     - utils::FieldDecode on the same Drogon result (what the
+//                  backend uses now: no string per field)
+//   binary       - the same rows fetched by libpq with binary results
+//                  (16-byte uuids, big-endian int4, int64 microseconds), which
+//                  Drogon's client cannot request
+//   binary+text  - binary, then formatted back to the uuid and timestamp text
+//                  the JSON responses carry
+// The last two show what a binary-result mode would buy over "in place" for
+// rows that end up in JSON.
+//
+// Usage: TEST_DB_CONNINFO="host=... dbname=..." ./bench_result_decode [iterations] [tasks]
+// (defaults to the dbtest database on localhost:5433; it is cleaned first)
+
+#include "utils/FieldDecode.h"
+#include "utils/Statements.h"
+#include <drogon/orm/DbClient.h>
+#include <libpq-fe.h>
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+using namespace kanba::utils;
+
+namespace {
+
+struct DecodedTask {
+    uint8_t id[16];
+    uint8_t columnId[16];
+    int32_t position;
+    int64_t createdAtUs;   // binary decoders only
+    std::string createdAt; // text decoders (and binary+text)
+    std::string dueDate;
+    std::string idText;    // binary+text only
+    std::string columnIdText;
+};
+
+// Columns of get_project_tasks, in result order
+constexpr int ID = 0;
+constexpr int COLUMN_ID = 1;
+constexpr int POSITION = 5;
+constexpr int DUE_DATE = 9;
+constexpr int CREATED_AT = 12;
+
+size_t decodeAs(const drogon::orm::Result& result, std::vector<DecodedTask>& out) {
+    out.clear();
+    for (const auto& row : result) {
+        DecodedTask task;
+        FieldDecode::uuid(row["id"].as<std::string>(), task.id);
+        FieldDecode::uuid(row["column_id"].as<std::string>(), task.columnId);
+        task.position = row["position"].as<int>();
+        task.createdAt = row["created_at"].as<std::string>();
+        if (!row["due_date"].isNull()) {
+            task.dueDate = row["due_date"].as<std::string>();
+        }
+        out.push_back(std::move(task));
+    }
+    return out.size();
+}
+
+size_t decodeInPlace(const drogon::orm::Result& result, std::vector<DecodedTask>& out) {
+    out.clear();
+    for (const auto& row : result) {
+        DecodedTask task;
+        FieldDecode::uuid(FieldDecode::text(row[size_t(ID)]), task.id);
+        FieldDecode::uuid(FieldDecode::text(row[size_t(COLUMN_ID)]), task.columnId);
+        task.position = FieldDecode::integer<int32_t>(row[size_t(POSITION)]).value_or(0);
+        // Timestamps stay text: the JSON writer copies them once, from here
+        task.createdAt.assign(FieldDecode::text(row[size_t(CREATED_AT)]));
+        if (!row[size_t(DUE_DATE)].isNull()) {
+            task.dueDate.assign(FieldDecode::text(row[size_t(DUE_DATE)]));
+        }
+        out.push_back(std::move(task));
+    }
+    return out.size();
+}
+
+int32_t readInt32(const char* bytes) {
+    uint32_t value;
+    std::memcpy(&value, bytes, 4);
+    return static_cast<int32_t>(ntohl(value));
+}
+
+int64_t readInt64(const char* bytes) {
+    uint32_t high, low;
+    std::memcpy(&high, bytes, 4);
+    std::memcpy(&low, bytes + 4, 4);
+    return static_cast<int64_t>((static_cast<uint64_t>(ntohl(high)) << 32) | ntohl(low));
+}
+
+// Postgres timestamps count microseconds from 2000-01-01 UTC
+constexpr int64_t PG_EPOCH_OFFSET_US = 946684800LL * 1000000;
+
+std::string formatTimestamp(int64_t pgMicros) {
+    int64_t unixUs = pgMicros + PG_EPOCH_OFFSET_US;
+    time_t seconds = static_cast<time_t>(unixUs / 1000000);
+    int micros = static_cast<int>(unixUs % 1000000);
+    std::tm tm;
+    gmtime_r(&seconds, &tm);
+    char buffer[40];
+    int n = std::snprintf(buffer, sizeof(buffer), "%04d-%02d-%02d %02d:%02d:%02d.%06d+00",
+                          tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
+                          tm.tm_hour, tm.tm_min, tm.tm_sec, micros);
+    return std::string(buffer, n);
+}
+
+std::string formatUuid(const uint8_t (&bytes)[16]) {
+    static const char digits[] = "0123456789abcdef";
+    std::string text(36, '-');
+    size_t pos = 0;
+    for (int i = 0; i < 16; ++i) {
+        if (pos == 8 || pos == 13 || pos == 18 || pos == 23) {
+            ++pos;
+        }
+        text[pos++] = digits[bytes[i] >> 4];
+        text[pos++] = digits[bytes[i] & 0xf];
+    }
+    return text;
+}
+
+size_t decodeBinary(const PGresult* result, std::vector<DecodedTask>& out, bool toText) {
+    out.clear();
+    int rows = PQntuples(result);
+    for (int r = 0; r < rows; ++r) {
+        DecodedTask task;
+        std::memcpy(task.id, PQgetvalue(result, r, ID), 16);
+        std::memcpy(task.columnId, PQgetvalue(result, r, COLUMN_ID), 16);
+        task.position = readInt32(PQgetvalue(result, r, POSITION));
+        task.createdAtUs = readInt64(PQgetvalue(result, r, CREATED_AT));
+        if (toText) {
+            // What the JSON writer needs: uuid and timestamp text again
+            task.idText = formatUuid(task.id);
+            task.columnIdText = formatUuid(task.columnId);
+            task.createdAt = formatTimestamp(task.createdAtUs);
+            if (!PQgetisnull(result, r, DUE_DATE)) {
+                task.dueDate = formatTimestamp(readInt64(PQgetvalue(result, r, DUE_DATE)));
+            }
+        }
+        out.push_back(std::move(task));
+    }
+    return out.size();
+}
+
+template<typename Decode>
+double timeMs(int iterations, Decode&& decode) {
+    std::vector<DecodedTask> out;
+    size_t sink = decode(out);  // warm-up
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        sink += decode(out);
+    }
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (sink == 0) {
+        std::printf("(empty result)\n");
+    }
+    return elapsed / iterations;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 50;
+    int taskCount = argc > 2 ? std::atoi(argv[2]) : 10000;
+    if (iterations <= 0) {
+        iterations = 50;
+    }
+    if (taskCount <= 0) {
+        taskCount = 10000;
+    }
+
+    const char* conninfoEnv = std::getenv("TEST_DB_CONNINFO");
+    std::string conninfo = conninfoEnv ? conninfoEnv
+        : "host=localhost port=5433 dbname=kanba_test user=postgres password=testpassword";
+    auto db = drogon::orm::DbClient::newPgClient(conninfo, 1);
+
+    for (const char* table : {"activity_log", "task_comments", "tasks", "columns", "project_members",
+                              "sessions", "revoked_sessions", "projects", "users"}) {
+        db->execSqlSync(std::string("DELETE FROM ") + table);
+    }
+
+    auto user = db->execSqlSync("SELECT id FROM create_user($1, $2, $3)",
+                                std::string("bench@example.com"), std::string("$argon2id$fakehash"),
+                                std::string("Bench User"));
+    std::string userId = user[0]["id"].as<std::string>();
+    auto project = db->execSqlSync("SELECT create_project($1, $2, $3, $4) AS id",
+                                   std::string("Bench Project"), std::string("description"),
+                                   std::string(""), userId);
+    std::string projectId = project[0]["id"].as<std::string>();
+    auto columns = db->execSqlSync("SELECT id FROM get_project_columns($1)", projectId);
+    std::string columnId = columns[0]["id"].as<std::string>();
+
+    db->execSqlSync(
+        "SELECT count(*) FROM generate_series(1, $3::int) AS g, "
+        "LATERAL create_task($1::uuid, 'Task ' || g, 'A task description of typical length', "
+        "'medium', $2::uuid, NOW(), '[\"frontend\", \"bug\"]'::jsonb, $2::uuid)",
+        columnId, userId, std::to_string(taskCount));
+
+    auto textResult = db->execSqlSync(Statements::GET_PROJECT_TASKS.sql, projectId);
+
+    PGconn* conn = PQconnectdb(conninfo.c_str());
+    if (PQstatus(conn) != CONNECTION_OK) {
+        std::printf("libpq connection failed: %s", PQerrorMessage(conn));
+        return 1;
+    }
+    const char* params[] = {projectId.c_str()};
+    PGresult* binaryResult = PQexecParams(conn, Statements::GET_PROJECT_TASKS.sql, 1, nullptr, params,
+                                          nullptr, nullptr, 1 /* binary results */);
+    if (PQresultStatus(binaryResult) != PGRES_TUPLES_OK) {
+        std::printf("binary query failed: %s", PQerrorMessage(conn));
+        return 1;
+    }
+
+    // Same rows either way
+    std::vector<DecodedTask> fromText, fromBinary;
+    decodeInPlace(textResult, fromText);
+    decodeBinary(binaryResult, fromBinary, true);
+    if (fromText.size() != fromBinary.size() ||
+        std::memcmp(fromText[0].id, fromBinary[0].id, 16) != 0 ||
+        fromText[0].position != fromBinary[0].position) {
+        std::printf("text and binary decodes differ\n");
+        return 1;
+    }
+
+    double asMs = timeMs(iterations, [&](auto& out) { return decodeAs(textResult, out); });
+    double inPlaceMs = timeMs(iterations, [&](auto& out) { return decodeInPlace(textResult, out); });
+    double binaryMs = timeMs(iterations, [&](auto& out) { return decodeBinary(binaryResult, out, false); });
+    double binaryTextMs = timeMs(iterations, [&](auto& out) { return decodeBinary(binaryResult, out, true); });
+
+    size_t rows = textResult.size();
+    std::printf("%zu rows, %d iterations, decode CPU per board\n", rows, iterations);
+    std::printf("as<>        : %8.3f ms (%6.3f us per row)\n", asMs, asMs * 1000 / rows);
+    std::printf("in place    : %8.3f ms (%6.3f us per row)\n", inPlaceMs, inPlaceMs * 1000 / rows);
+    std::printf("binary      : %8.3f ms (%6.3f us per row)\n", binaryMs, binaryMs * 1000 / rows);
+    std::printf("binary+text : %8.3f ms (%6.3f us per row)\n", binaryTextMs, binaryTextMs * 1000 / rows);
+
+    PQclear(binaryResult);
+    PQfinish(conn);
+
+    for (const char* table : {"activity_log", "tasks", "columns", "project_members", "projects", "users"}) {
+        db->execSqlSync(std::string("DELETE FROM ") + table);
+    }
+    return 0;
+}
@@ -0,0 +1,135 @@
+// Microbenchmark for the row mappers on a large board.
+//
+// Seeds a project with a 5000-task board, fetches get_project_tasks once
+// through Drogon, then maps the same result repeatedly two ways:
+//   by name   - the per-field row["column"].as<std::string>() chains the
+//               controllers used before (a libpq name lookup and a string copy
+//               per field per row, tags through Json::Reader)
+//   mapper    - utils::TASK_MAPPER (positions resolved once per result,
+//               values read in place)
+// Only the mapping is timed; both outputs are compared before timing.
+//
+// Usage: TEST_DB_CONNINFO="host=... dbname=..." ./bench_row_mapping [iterations] [tasks]
+// (defaults to the dbtest database on localhost:5433; it is cleaned first)
+
+#include "utils/RowMapper.h"
+#include "utils/Statements.h"
+#include <drogon/orm/DbClient.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using namespace kanba::utils;
+
+namespace {
+
+Json::Value mapByName(const drogon::orm::Result& result) {
+    Json::Value tasks(Json::arrayValue);
+    for (const auto& row : result) {
+        Json::Value task;
+        task["id"] = row["id"].as<std::string>();
+        task["column_id"] = row["column_id"].as<std::string>();
+        task["title"] = row["title"].as<std::string>();
+        if (!row["description"].isNull()) {
+            task["description"] = row["description"].as<std::string>();
+        }
+        task["priority"] = row["priority"].as<std::string>();
+        task["position"] = row["position"].as<int>();
+        if (!row["assignee_id"].isNull()) {
+            task["assignee_id"] = row["assignee_id"].as<std::string>();
+        }
+        if (!row["assignee_name"].isNull()) {
+            task["assignee_name"] = row["assignee_name"].as<std::string>();
+        }
+        if (!row["due_date"].isNull()) {
+            task["due_date"] = row["due_date"].as<std::string>();
+        }
+        if (!row["tags"].isNull()) {
+            Json::Reader reader;
+            Json::Value tagsArray;
+            if (reader.parse(row["tags"].as<std::string>(), tagsArray)) {
+                task["tags"] = tagsArray;
+            }
+        }
+        task["created_at"] = row["created_at"].as<std::string>();
+        tasks.append(task);
+    }
+    return tasks;
+}
+
+Json::Value mapWithMapper(const drogon::orm::Result& result) {
+    return TASK_MAPPER.array(result);
+}
+
+double timeMs(int iterations, Json::Value (*map)(const drogon::orm::Result&), const drogon::orm::Result& result) {
+    auto start = std::chrono::steady_clock::now();
+    size_t sink = 0;
+    for (int i = 0; i < iterations; ++i) {
+        sink += map(result).size();
+    }
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (sink == 0) {
+        std::printf("(empty result)\n");
+    }
+    return elapsed / iterations;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 50;
+    int taskCount = argc > 2 ? std::atoi(argv[2]) : 5000;
+    if (iterations <= 0) {
+        iterations = 50;
+    }
+    if (taskCount <= 0) {
+        taskCount = 5000;
+    }
+
+    const char* conninfo = std::getenv("TEST_DB_CONNINFO");
+    auto db = drogon::orm::DbClient::newPgClient(
+        conninfo ? conninfo : "host=localhost port=5433 dbname=kanba_test user=postgres password=testpassword", 1);
+
+    for (const char* table : {"activity_log", "task_comments", "tasks", "columns", "project_members",
+                              "sessions", "revoked_sessions", "projects", "users"}) {
+        db->execSqlSync(std::string("DELETE FROM ") + table);
+    }
+
+    auto user = db->execSqlSync("SELECT id FROM create_user($1, $2, $3)",
+                                std::string("bench@example.com"), std::string("$argon2id$fakehash"),
+                                std::string("Bench User"));
+    std::string userId = user[0]["id"].as<std::string>();
+    auto project = db->execSqlSync("SELECT create_project($1, $2, $3, $4) AS id",
+                                   std::string("Bench Project"), std::string("description"),
+                                   std::string(""), userId);
+    std::string projectId = project[0]["id"].as<std::string>();
+    auto columns = db->execSqlSync("SELECT id FROM get_project_columns($1)", projectId);
+    std::string columnId = columns[0]["id"].as<std::string>();
+
+    db->execSqlSync(
+        "SELECT count(*) FROM generate_series(1, $3::int) AS g, "
+        "LATERAL create_task($1::uuid, 'Task ' || g, 'A task description of typical length', "
+        "'medium', $2::uuid, NOW(), '[\"frontend\", \"bug\"]'::jsonb, $2::uuid)",
+        columnId, userId, std::to_string(taskCount));
+
+    auto result = db->execSqlSync(Statements::GET_PROJECT_TASKS.sql, projectId);
+
+    if (mapByName(result) != mapWithMapper(result)) {
+        std::printf("mapper output differs from the by-name mapping\n");
+        return 1;
+    }
+
+    double byName = timeMs(iterations, mapByName, result);
+    double mapper = timeMs(iterations, mapWithMapper, result);
+
+    std::printf("%zu rows, %d iterations\n", result.size(), iterations);
+    std::printf("by name : %8.3f ms per board (%6.3f us per row)\n", byName, byName * 1000 / result.size());
+    std::printf("mapper  : %8.3f ms per board (%6.3f us per row)\n", mapper, mapper * 1000 / result.size());
+    std::printf("speedup : %8.2fx\n", byName / mapper);
+
+    for (const char* table : {"activity_log", "tasks", "columns", "project_members", "projects", "users"}) {
+        db->execSqlSync(std::string("DELETE FROM ") + table);
+    }
+    return 0;
+}
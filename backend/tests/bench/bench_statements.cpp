@@ -0,0 +1,127 @@
+// Before/after benchmark for the statement registry.
+//
+// For each hot statement this runs the same SQL two ways against a seeded
+// database:
+//   unprepared - sent as an unnamed statement each time, so Postgres parses
+//                and plans it on every call (what every request paid when the
+//                SQL text was rebuilt or varied per call site)
+//   prepared   - prepared once on the connection and executed by name, which
+//                is what Drogon does for a registered statement after the
+//                first call on each pooled connection
+//
+// Usage: TEST_DB_CONNINFO="host=... dbname=..." ./bench_statements [iterations]
+// (defaults to the dbtest database on localhost:5433; it is cleaned first)
+
+#include "db_test_helper.h"
+#include "utils/Statements.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <vector>
+
+using kanba::utils::Statement;
+using kanba::utils::Statements;
+
+namespace {
+
+struct Summary {
+    double meanUs = 0;
+    double p50Us = 0;
+    double p99Us = 0;
+};
+
+Summary measure(int iterations, const std::function<void()>& run) {
+    for (int i = 0; i < iterations / 10; ++i) {
+        run();
+    }
+
+    std::vector<double> samples;
+    samples.reserve(iterations);
+    for (int i = 0; i < iterations; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        samples.push_back(std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::now() - start).count());
+    }
+
+    std::sort(samples.begin(), samples.end());
+    Summary summary;
+    for (double sample : samples) {
+        summary.meanUs += sample;
+    }
+    summary.meanUs /= samples.size();
+    summary.p50Us = samples[samples.size() / 2];
+    summary.p99Us = samples[std::min(samples.size() - 1, samples.size() * 99 / 100)];
+    return summary;
+}
+
+template<typename... Args>
+void compare(TestDb& db, int iterations, const Statement& statement, Args... args) {
+    db.conn().prepare(statement.name, statement.sql);
+
+    Summary unprepared = measure(iterations, [&] {
+        pqxx::nontransaction txn(db.conn());
+        txn.exec_params(statement.sql, args...);
+    });
+    Summary prepared = measure(iterations, [&] {
+        pqxx::nontransaction txn(db.conn());
+        txn.exec_prepared(statement.name, args...);
+    });
+
+    std::printf("%-22s %9.1f %9.1f %9.1f   %9.1f %9.1f %9.1f   %6.2fx\n",
+                statement.name,
+                unprepared.meanUs, unprepared.p50Us, unprepared.p99Us,
+                prepared.meanUs, prepared.p50Us, prepared.p99Us,
+                unprepared.meanUs / prepared.meanUs);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 2000;
+    if (iterations <= 0) {
+        iterations = 2000;
+    }
+
+    TestDb db;
+    db.cleanAll();
+
+    // One project board of a realistic size: 2 columns, 200 tasks
+    std::string userId = db.createTestUser("bench@example.com", "Bench User");
+    std::string projectId = db.createTestProject(userId, "Bench Project");
+    auto columns = db.execParams("SELECT id FROM get_project_columns($1)", projectId);
+    std::string firstColumn = columns[0]["id"].as<std::string>();
+    std::string secondColumn = columns[1]["id"].as<std::string>();
+
+    std::string taskId;
+    for (int i = 0; i < 200; ++i) {
+        auto task = db.execParams(
+            "SELECT id FROM create_task($1::uuid, $2, '', 'medium', NULL, NULL, '[]'::jsonb, $3::uuid)",
+            i % 2 == 0 ? firstColumn : secondColumn, "Task " + std::to_string(i), userId);
+        taskId = task[0]["id"].as<std::string>();
+    }
+
+    std::string sessionId = "bench-session-0123456789abcdef0123456789abcdef";
+    db.execParams("INSERT INTO sessions (id, user_id, expires_at) VALUES ($1, $2, NOW() + INTERVAL '1 day')",
+                  sessionId, userId);
+
+    std::printf("%d iterations per statement, latencies in microseconds\n\n", iterations);
+    std::printf("%-22s %29s   %29s\n", "", "unprepared (parse+plan)", "prepared (registry)");
+    std::printf("%-22s %9s %9s %9s   %9s %9s %9s   %7s\n",
+                "statement", "mean", "p50", "p99", "mean", "p50", "p99", "speedup");
+
+    compare(db, iterations, Statements::GET_SESSION_USER, sessionId);
+    compare(db, iterations, Statements::GET_USER_MEMBERSHIPS, userId);
+    compare(db, iterations, Statements::GET_TASK_PROJECT, taskId);
+    compare(db, iterations, Statements::GET_PROJECT_DETAILS, projectId);
+    compare(db, iterations, Statements::GET_PROJECT_COLUMNS, projectId);
+    compare(db, iterations, Statements::GET_PROJECT_TASKS, projectId);
+    compare(db, iterations, Statements::GET_PROJECT_MEMBERS, projectId);
+    compare(db, iterations, Statements::MOVE_TASK, taskId, firstColumn, 0, userId);
+
+    db.cleanAll();
+    return 0;
+}
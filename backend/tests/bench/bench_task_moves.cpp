@@ -0,0 +1,164 @@
+// Cost of a drag-and-drop move in a large column.
+//
+// Seeds one column with a few thousand tasks and moves random tasks to random
+// positions in it two ways:
+//   shifted - the previous scheme, replayed on a temp copy of the column:
+//             dense integer positions, every task at or after the target is
+//             shifted down and the source column is renumbered
+//   ranked  - move_task() as it is now: one new sparse rank for the moved
+//             task, computed from its two neighbours
+// and reports the latency and how many task rows each move rewrote (from
+// pg_stat_get_xact_tuples_updated, read inside the move's transaction).
+//
+// Usage: TEST_DB_CONNINFO="host=... dbname=..." ./bench_task_moves [moves] [tasks]
+// (defaults to the dbtest database on localhost:5433; it is cleaned first)
+
+#include "db_test_helper.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+// The move as it was before sparse ranks, minus the activity log insert
+const char* LEGACY_SETUP = R"SQL(
+CREATE TEMP TABLE legacy_tasks (LIKE tasks INCLUDING DEFAULTS, position INTEGER NOT NULL);
+CREATE INDEX ON legacy_tasks (column_id);
+CREATE UNIQUE INDEX ON legacy_tasks (id);
+
+CREATE FUNCTION pg_temp.legacy_move_task(p_task_id UUID, p_new_column_id UUID, p_new_position INTEGER)
+RETURNS BOOLEAN AS $$
+DECLARE
+    v_old_column_id UUID;
+BEGIN
+    SELECT column_id INTO v_old_column_id FROM legacy_tasks WHERE id = p_task_id;
+
+    UPDATE legacy_tasks
+    SET position = position + 1
+    WHERE column_id = p_new_column_id AND position >= p_new_position;
+
+    UPDATE legacy_tasks
+    SET column_id = p_new_column_id, position = p_new_position
+    WHERE id = p_task_id;
+
+    WITH ordered AS (
+        SELECT id, ROW_NUMBER() OVER (ORDER BY position) - 1 as new_pos
+        FROM legacy_tasks WHERE column_id = v_old_column_id
+    )
+    UPDATE legacy_tasks t SET position = o.new_pos
+    FROM ordered o WHERE t.id = o.id;
+
+    RETURN TRUE;
+END;
+$$ LANGUAGE plpgsql;
+)SQL";
+
+struct Summary {
+    double meanUs = 0;
+    double p50Us = 0;
+    double p99Us = 0;
+    double rowsPerMove = 0;
+};
+
+// run() performs one move inside txn; the rows it updated in table are counted
+Summary measure(TestDb& db, int moves, const char* table,
+                const std::function<void(pqxx::work&, int)>& run) {
+    std::vector<double> samples;
+    samples.reserve(moves);
+    long long rows = 0;
+    std::string updated = std::string("SELECT pg_stat_get_xact_tuples_updated('") + table + "'::regclass)";
+
+    for (int i = 0; i < moves; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        pqxx::work txn(db.conn());
+        run(txn, i);
+        rows += txn.exec(updated)[0][0].as<long long>();
+        txn.commit();
+        samples.push_back(std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::now() - start).count());
+    }
+
+    std::sort(samples.begin(), samples.end());
+    Summary summary;
+    for (double sample : samples) {
+        summary.meanUs += sample;
+    }
+    summary.meanUs /= samples.size();
+    summary.p50Us = samples[samples.size() / 2];
+    summary.p99Us = samples[std::min(samples.size() - 1, samples.size() * 99 / 100)];
+    summary.rowsPerMove = static_cast<double>(rows) / moves;
+    return summary;
+}
+
+void print(const char* name, const Summary& summary) {
+    std::printf("%-8s %9.1f %9.1f %9.1f   %12.1f\n",
+                name, summary.meanUs, summary.p50Us, summary.p99Us, summary.rowsPerMove);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int moves = argc > 1 ? std::atoi(argv[1]) : 1000;
+    int tasks = argc > 2 ? std::atoi(argv[2]) : 5000;
+    if (moves <= 0) {
+        moves = 1000;
+    }
+    if (tasks <= 1) {
+        tasks = 5000;
+    }
+
+    TestDb db;
+    db.cleanAll();
+
+    std::string userId = db.createTestUser("bench@example.com", "Bench User");
+    std::string projectId = db.createTestProject(userId, "Bench Project");
+    std::string columnId = db.getFirstColumnId(projectId);
+
+    // Seeded in bulk, spaced as create_task() would have appended them
+    db.execParams(
+        "INSERT INTO tasks (column_id, project_id, title, rank, created_by) "
+        "SELECT $1::uuid, $2::uuid, 'Task ' || i, i * rank_step(), $3::uuid FROM generate_series(0, $4 - 1) i",
+        columnId, projectId, userId, tasks);
+    db.exec(LEGACY_SETUP);
+    db.execParams(
+        "INSERT INTO legacy_tasks "
+        "SELECT t.*, (ROW_NUMBER() OVER (ORDER BY t.rank) - 1)::int FROM tasks t WHERE t.column_id = $1::uuid",
+        columnId);
+    db.exec("ANALYZE tasks");
+    db.exec("ANALYZE legacy_tasks");
+
+    std::vector<std::string> ids;
+    for (const auto& row : db.execParams("SELECT id FROM tasks WHERE column_id = $1::uuid", columnId)) {
+        ids.push_back(row[0].as<std::string>());
+    }
+
+    // The same random moves for both schemes
+    std::mt19937 random(42);
+    std::vector<std::pair<size_t, int>> plan;
+    for (int i = 0; i < moves; ++i) {
+        plan.emplace_back(random() % ids.size(), static_cast<int>(random() % ids.size()));
+    }
+
+    std::printf("%d random moves within a column of %d tasks, latencies in microseconds\n\n", moves, tasks);
+    std::printf("%-8s %9s %9s %9s   %12s\n", "scheme", "mean", "p50", "p99", "rows/move");
+
+    print("shifted", measure(db, moves, "pg_temp.legacy_tasks", [&](pqxx::work& txn, int i) {
+        txn.exec_params("SELECT pg_temp.legacy_move_task($1::uuid, $2::uuid, $3)",
+                        ids[plan[i].first], columnId, plan[i].second);
+    }));
+    print("ranked", measure(db, moves, "tasks", [&](pqxx::work& txn, int i) {
+        txn.exec_params("SELECT move_task($1::uuid, $2::uuid, $3, $4::uuid)",
+                        ids[plan[i].first], columnId, plan[i].second, userId);
+    }));
+
+    auto queued = db.exec("SELECT COUNT(*) FROM task_rank_rebalance")[0][0].as<int>();
+    std::printf("\ncolumns queued for rebalancing: %d\n", queued);
+
+    db.cleanAll();
+    return 0;
+}
@@ -47,6 +47,7 @@ public:
         txn.exec("DELETE FROM columns");
         txn.exec("DELETE FROM project_members");
         txn.exec("DELETE FROM sessions");
+        txn.exec("DELETE FROM revoked_sessions");
         txn.exec("DELETE FROM projects");
         txn.exec("DELETE FROM users");
     }
@@ -1,6 +1,7 @@
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include "doctest.h"
 #include "db_test_helper.h"
+#include <vector>
 
 // Contract tests for column SQL functions.
 // References: backend/src/controllers/ColumnController.cpp, ProjectController.cpp
@@ -84,4 +85,130 @@ TEST_CASE("delete_column executes without error") {
     CHECK(res.size() == 1);
 }
 
+TEST_CASE("get_column_project resolves a column to its project") {
+    TestDb db; db.cleanAll();
+    std::string userId = db.createTestUser();
+    std::string projectId = db.createTestProject(userId);
+    std::string columnId = db.getFirstColumnId(projectId);
+
+    auto res = db.execParams("SELECT project_id FROM get_column_project($1)", columnId);
+    REQUIRE(res.size() == 1);
+    CHECK(res[0]["project_id"].as<std::string>() == projectId);
+
+    auto missing = db.execParams("SELECT project_id FROM get_column_project($1)",
+                                 "00000000-0000-0000-0000-000000000000");
+    CHECK(missing.size() == 0);
+}
+
+// Column names in board order, checking the derived positions on the way
+static std::vector<std::string> columnNames(TestDb& db, const std::string& projectId) {
+    auto res = db.execParams("SELECT name, position FROM get_project_columns($1)", projectId);
+    std::vector<std::string> names;
+    for (const auto& row : res) {
+        CHECK(row["position"].as<int>() == static_cast<int>(names.size()));
+        names.push_back(row["name"].as<std::string>());
+    }
+    return names;
+}
+
+TEST_CASE("move_column reorders by writing only the moved column") {
+    TestDb db; db.cleanAll();
+    std::string userId = db.createTestUser();
+    std::string projectId = db.createTestProject(userId);
+    db.execParams("SELECT * FROM create_column($1, $2, $3)", projectId, "Review", "#000");
+    auto blocked = db.execParams("SELECT * FROM create_column($1, $2, $3)", projectId, "Blocked", "#000");
+    CHECK(blocked[0]["position"].as<int>() == 3);
+    CHECK(columnNames(db, projectId) == std::vector<std::string>{"To Do", "Done", "Review", "Blocked"});
+
+    auto ranksBefore = db.execParams(
+        "SELECT name, rank FROM columns WHERE project_id = $1::uuid AND name <> 'Review' ORDER BY name", projectId);
+    std::string reviewId = db.execParams(
+        "SELECT id FROM columns WHERE project_id = $1::uuid AND name = 'Review'", projectId)[0][0].as<std::string>();
+
+    auto moved = db.execParams("SELECT move_column($1::uuid, $2) AS moved", reviewId, 1);
+    CHECK(moved[0]["moved"].as<bool>());
+    CHECK(columnNames(db, projectId) == std::vector<std::string>{"To Do", "Review", "Done", "Blocked"});
+
+    auto ranksAfter = db.execParams(
+        "SELECT name, rank FROM columns WHERE project_id = $1::uuid AND name <> 'Review' ORDER BY name", projectId);
+    REQUIRE(ranksAfter.size() == ranksBefore.size());
+    for (size_t i = 0; i < ranksAfter.size(); ++i) {
+        CHECK(ranksAfter[i]["rank"].as<long long>() == ranksBefore[i]["rank"].as<long long>());
+    }
+
+    // To the front, and an index past the end appends
+    db.execParams("SELECT move_column($1::uuid, $2)", reviewId, 0);
+    CHECK(columnNames(db, projectId) == std::vector<std::string>{"Review", "To Do", "Done", "Blocked"});
+    db.execParams("SELECT move_column($1::uuid, $2)", reviewId, 99);
+    CHECK(columnNames(db, projectId) == std::vector<std::string>{"To Do", "Done", "Blocked", "Review"});
+
+    auto missing = db.execParams("SELECT move_column($1::uuid, $2) AS moved",
+                                 "00000000-0000-0000-0000-000000000000", 0);
+    CHECK_FALSE(missing[0]["moved"].as<bool>());
+}
+
+TEST_CASE("delete_column leaves the other ranks alone and appends its tasks to the first column") {
+    TestDb db; db.cleanAll();
+    std::string userId = db.createTestUser();
+    std::string projectId = db.createTestProject(userId);
+    auto cols = db.execParams("SELECT * FROM get_project_columns($1)", projectId);
+    std::string todoId = cols[0]["id"].as<std::string>();
+    std::string doneId = cols[1]["id"].as<std::string>();
+    long long todoRank = db.execParams("SELECT rank FROM columns WHERE id = $1::uuid", todoId)[0][0].as<long long>();
+
+    for (const char* title : {"A", "B"}) {
+        db.execParams("SELECT * FROM create_task($1::uuid, $2, '', 'medium', NULL, NULL, '[]'::jsonb, $3::uuid)",
+                      todoId, title, userId);
+    }
+    for (const char* title : {"C", "D"}) {
+        db.execParams("SELECT * FROM create_task($1::uuid, $2, '', 'medium', NULL, NULL, '[]'::jsonb, $3::uuid)",
+                      doneId, title, userId);
+    }
+
+    db.execParams("SELECT * FROM delete_column($1)", doneId);
+
+    CHECK(db.execParams("SELECT rank FROM columns WHERE id = $1::uuid", todoId)[0][0].as<long long>() == todoRank);
+    auto tasks = db.execParams("SELECT title, position FROM get_project_tasks($1)", projectId);
+    REQUIRE(tasks.size() == 4);
+    const char* expected[] = {"A", "B", "C", "D"};
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        CHECK(tasks[i]["title"].as<std::string>() == expected[i]);
+        CHECK(tasks[i]["position"].as<int>() == static_cast<int>(i));
+    }
+}
+
+TEST_CASE("repeated column moves into one gap queue the project for rebalancing") {
+    TestDb db; db.cleanAll();
+    std::string userId = db.createTestUser();
+    std::string projectId = db.createTestProject(userId);
+    std::vector<std::string> ids;
+    for (const auto& row : db.execParams("SELECT id FROM get_project_columns($1)", projectId)) {
+        ids.push_back(row["id"].as<std::string>());
+    }
+    for (const char* name : {"C2", "C3"}) {
+        auto created = db.execParams("SELECT * FROM create_column($1, $2, $3)", projectId, name, "#000");
+        ids.push_back(created[0]["id"].as<std::string>());
+    }
+
+    // Alternately drop C2 and C3 right after "To Do", halving the same gap
+    for (int i = 0; i < 20; ++i) {
+        db.execParams("SELECT move_column($1::uuid, $2)", ids[2 + i % 2], 1);
+    }
+    CHECK(columnNames(db, projectId) == std::vector<std::string>{"To Do", "C3", "C2", "Done"});
+
+    auto queued = db.execParams("SELECT project_id FROM column_rank_rebalance");
+    REQUIRE(queued.size() == 1);
+    CHECK(queued[0][0].as<std::string>() == projectId);
+
+    CHECK(db.exec("SELECT rebalance_column_ranks(10)")[0][0].as<int>() == 1);
+    CHECK(db.exec("SELECT COUNT(*) FROM column_rank_rebalance")[0][0].as<int>() == 0);
+
+    auto ranks = db.execParams("SELECT rank FROM columns WHERE project_id = $1::uuid ORDER BY rank", projectId);
+    REQUIRE(ranks.size() == 4);
+    for (size_t i = 0; i < ranks.size(); ++i) {
+        CHECK(ranks[i][0].as<long long>() == static_cast<long long>(i) * 65536);
+    }
+    CHECK(columnNames(db, projectId) == std::vector<std::string>{"To Do", "C3", "C2", "Done"});
+}
+
 } // TEST_SUITE
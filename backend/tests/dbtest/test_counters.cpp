@@ -0,0 +1,187 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+#include "db_test_helper.h"
+#include <atomic>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+// Tests for the trigger-maintained counters: projects.task_count,
+// projects.member_count and columns.task_count (see database/schema.sql).
+// References: get_user_projects / get_project_columns, read by
+// ProjectController::getProjects and ColumnController
+
+namespace {
+
+// Every counter of a project against a fresh COUNT(*)
+void checkCounters(TestDb& db, const std::string& projectId) {
+    auto project = db.execParams(
+        "SELECT p.task_count, p.member_count, "
+        "(SELECT COUNT(*) FROM tasks t JOIN columns c ON c.id = t.column_id WHERE c.project_id = p.id) AS tasks, "
+        "(SELECT COUNT(*) FROM project_members pm WHERE pm.project_id = p.id) AS members "
+        "FROM projects p WHERE p.id = $1::uuid", projectId);
+    REQUIRE(project.size() == 1);
+    CHECK(project[0]["task_count"].as<long long>() == project[0]["tasks"].as<long long>());
+    CHECK(project[0]["member_count"].as<long long>() == project[0]["members"].as<long long>());
+
+    auto columns = db.execParams(
+        "SELECT c.task_count, (SELECT COUNT(*) FROM tasks t WHERE t.column_id = c.id) AS tasks "
+        "FROM columns c WHERE c.project_id = $1::uuid", projectId);
+    for (const auto& column : columns) {
+        CHECK(column["task_count"].as<long long>() == column["tasks"].as<long long>());
+    }
+}
+
+std::string createTask(TestDb& db, const std::string& columnId, const std::string& userId) {
+    auto created = db.execParams(
+        "SELECT id FROM create_task($1::uuid, 'T', '', 'medium', NULL, NULL, '[]'::jsonb, $2::uuid)",
+        columnId, userId);
+    return created[0]["id"].as<std::string>();
+}
+
+} // namespace
+
+TEST_SUITE("DB Contract: Counters") {
+
+TEST_CASE("counters follow task and member changes") {
+    TestDb db; db.cleanAll();
+    std::string ownerId = db.createTestUser();
+    std::string projectId = db.createTestProject(ownerId);
+    auto cols = db.execParams("SELECT id FROM get_project_columns($1)", projectId);
+    std::string todoId = cols[0]["id"].as<std::string>();
+    std::string doneId = cols[1]["id"].as<std::string>();
+
+    auto projects = db.execParams("SELECT task_count, member_count FROM get_user_projects($1)", ownerId);
+    REQUIRE(projects.size() == 1);
+    CHECK(projects[0]["task_count"].as<int>() == 0);
+    CHECK(projects[0]["member_count"].as<int>() == 1);
+
+    std::string a = createTask(db, todoId, ownerId);
+    std::string b = createTask(db, todoId, ownerId);
+    createTask(db, doneId, ownerId);
+    db.execParams("SELECT move_task($1::uuid, $2::uuid, $3, $4::uuid)", a, doneId, 0, ownerId);
+    db.execParams("SELECT delete_task($1::uuid, $2::uuid)", b, ownerId);
+
+    auto columns = db.execParams("SELECT task_count FROM get_project_columns($1)", projectId);
+    CHECK(columns[0]["task_count"].as<int>() == 0);
+    CHECK(columns[1]["task_count"].as<int>() == 2);
+
+    db.createTestUser("member@example.com", "Member");
+    db.execParams("SELECT add_project_member($1, $2, $3)", projectId, "member@example.com", "member");
+    projects = db.execParams("SELECT task_count, member_count FROM get_user_projects($1)", ownerId);
+    CHECK(projects[0]["task_count"].as<int>() == 2);
+    CHECK(projects[0]["member_count"].as<int>() == 2);
+
+    // Deleting a user removes their membership
+    db.exec("DELETE FROM users WHERE email = 'member@example.com'");
+    checkCounters(db, projectId);
+}
+
+TEST_CASE("counter updates leave updated_at alone") {
+    TestDb db; db.cleanAll();
+    std::string ownerId = db.createTestUser();
+    std::string projectId = db.createTestProject(ownerId);
+    auto cols = db.execParams("SELECT id FROM get_project_columns($1)", projectId);
+    std::string todoId = cols[0]["id"].as<std::string>();
+
+    const char* stamps =
+        "SELECT p.updated_at::text AS project, c.updated_at::text AS column_ "
+        "FROM projects p JOIN columns c ON c.project_id = p.id "
+        "WHERE p.id = $1::uuid AND c.id = $2::uuid";
+    auto before = db.execParams(stamps, projectId, todoId);
+
+    // A separate statement, so NOW() differs from the project's creation
+    std::string taskId = createTask(db, todoId, ownerId);
+    db.execParams("SELECT delete_task($1::uuid, $2::uuid)", taskId, ownerId);
+    db.createTestUser("member@example.com", "Member");
+    db.execParams("SELECT add_project_member($1, $2, $3)", projectId, "member@example.com", "member");
+
+    auto after = db.execParams(stamps, projectId, todoId);
+    CHECK(after[0]["project"].as<std::string>() == before[0]["project"].as<std::string>());
+    CHECK(after[0]["column_"].as<std::string>() == before[0]["column_"].as<std::string>());
+
+    // A real edit still bumps it
+    db.execParams("UPDATE projects SET name = 'Renamed' WHERE id = $1::uuid", projectId);
+    auto renamed = db.execParams(stamps, projectId, todoId);
+    CHECK(renamed[0]["project"].as<std::string>() != before[0]["project"].as<std::string>());
+}
+
+TEST_CASE("deleting columns keeps the project's task count") {
+    TestDb db; db.cleanAll();
+    std::string userId = db.createTestUser();
+    std::string projectId = db.createTestProject(userId);
+    auto cols = db.execParams("SELECT id FROM get_project_columns($1)", projectId);
+    std::string todoId = cols[0]["id"].as<std::string>();
+    std::string doneId = cols[1]["id"].as<std::string>();
+    createTask(db, todoId, userId);
+    createTask(db, doneId, userId);
+    createTask(db, doneId, userId);
+
+    // Tasks move to the remaining column
+    db.execParams("SELECT delete_column($1)", doneId);
+    checkCounters(db, projectId);
+    CHECK(db.execParams("SELECT task_count FROM columns WHERE id = $1::uuid", todoId)[0][0].as<int>() == 3);
+
+    // The last column takes its tasks with it
+    db.execParams("SELECT delete_column($1)", todoId);
+    checkCounters(db, projectId);
+    CHECK(db.execParams("SELECT task_count FROM projects WHERE id = $1::uuid", projectId)[0][0].as<int>() == 0);
+}
+
+TEST_CASE("counters stay exact under concurrent create, move and delete") {
+    std::string userId;
+    std::string projectId;
+    std::vector<std::string> columnIds;
+    {
+        TestDb db; db.cleanAll();
+        userId = db.createTestUser();
+        projectId = db.createTestProject(userId);
+        db.execParams("SELECT * FROM create_column($1, $2, $3)", projectId, "Doing", "#000");
+        for (const auto& row : db.execParams("SELECT id FROM get_project_columns($1)", projectId)) {
+            columnIds.push_back(row["id"].as<std::string>());
+        }
+    }
+
+    constexpr int THREADS = 8;
+    constexpr int OPERATIONS = 150;
+    std::atomic<int> failures{0};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < THREADS; ++t) {
+        workers.emplace_back([&, t] {
+            try {
+                TestDb db;
+                std::mt19937 random(static_cast<unsigned>(t));
+                std::vector<std::string> mine;
+                for (int i = 0; i < OPERATIONS; ++i) {
+                    const std::string& column = columnIds[random() % columnIds.size()];
+                    unsigned op = random() % 4;
+                    if (mine.empty() || op == 0) {
+                        mine.push_back(createTask(db, column, userId));
+                    } else if (op == 3) {
+                        size_t index = random() % mine.size();
+                        db.execParams("SELECT delete_task($1::uuid, $2::uuid)", mine[index], userId);
+                        mine.erase(mine.begin() + static_cast<long>(index));
+                    } else {
+                        db.execParams("SELECT move_task($1::uuid, $2::uuid, $3, $4::uuid)",
+                                      mine[random() % mine.size()], column,
+                                      static_cast<int>(random() % 20), userId);
+                    }
+                }
+            } catch (const std::exception& e) {
+                // A deadlock or serialization error fails the test
+                std::fprintf(stderr, "worker %d failed: %s\n", t, e.what());
+                failures.fetch_add(1);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    CHECK(failures.load() == 0);
+    TestDb db;
+    checkCounters(db, projectId);
+}
+
+} // TEST_SUITE
@@ -51,4 +51,25 @@ TEST_CASE("add_project_member fails for non-existent email") {
                                 projectId, "nobody@test.com", "member"));
 }
 
+TEST_CASE("get_user_memberships returns project_id and role") {
+    TestDb db; db.cleanAll();
+    std::string ownerId = db.createTestUser("owner@test.com", "Owner");
+    std::string memberId = db.createTestUser("member@test.com", "Member");
+    std::string projectId = db.createTestProject(ownerId);
+    db.execParams("SELECT * FROM add_project_member($1, $2, $3)",
+                  projectId, "member@test.com", "admin");
+
+    // ProjectAccess.cpp reads these columns
+    auto owner = db.execParams("SELECT * FROM get_user_memberships($1)", ownerId);
+    REQUIRE(owner.size() == 1);
+    CHECK(hasColumn(owner, "project_id"));
+    CHECK(hasColumn(owner, "role"));
+    CHECK(owner[0]["project_id"].as<std::string>() == projectId);
+    CHECK(owner[0]["role"].as<std::string>() == "owner");
+
+    auto member = db.execParams("SELECT * FROM get_user_memberships($1)", memberId);
+    REQUIRE(member.size() == 1);
+    CHECK(member[0]["role"].as<std::string>() == "admin");
+}
+
 } // TEST_SUITE
@@ -73,6 +73,64 @@ TEST_CASE("get_project_details returns columns read by ProjectController") {
     CHECK(hasColumn(res, "created_at"));
 }
 
+TEST_CASE("get_project_board returns the board document sent by ProjectController") {
+    TestDb db; db.cleanAll();
+    std::string userId = db.createTestUser();
+    std::string projectId = db.createTestProject(userId);
+    std::string columnId = db.getFirstColumnId(projectId);
+    db.execParams("UPDATE projects SET description = NULL WHERE id = $1", projectId);
+    // create_task appends, so First is at position 0 and Second at 1
+    db.execParams(
+        "SELECT create_task($1::uuid, 'First', 'desc', 'high', NULL, NULL, '[]'::jsonb, $2::uuid)",
+        columnId, userId);
+    db.execParams(
+        "SELECT create_task($1::uuid, 'Second', NULL, 'low', NULL, NULL, '[\"bug\"]'::jsonb, $2::uuid)",
+        columnId, userId);
+
+    // ProjectController::sendProject sends this document as the response body
+    auto res = db.execParams(
+        "WITH b AS (SELECT get_project_board($1::uuid) AS board) SELECT "
+        "board->'project'->>'id' AS project_id, "
+        "json_typeof(board->'project'->'description') AS description_type, "
+        "json_array_length(board->'columns') AS column_count, "
+        "board->'columns'->0->>'id' AS first_column, "
+        "(board->'columns'->0->>'task_count')::int AS task_count, "
+        "board->'columns'->0->'tasks'->0->>'title' AS first_title, "
+        "board->'columns'->0->'tasks'->1->>'title' AS second_title, "
+        "(board->'columns'->0->'tasks'->1)::jsonb ? 'description' AS second_has_description, "
+        "board->'columns'->0->'tasks'->1->'tags'->>0 AS second_tag, "
+        "json_array_length(board->'columns'->1->'tasks') AS empty_tasks, "
+        "json_array_length(board->'members') AS member_count, "
+        "board->'members'->0->>'role' AS owner_role "
+        "FROM b",
+        projectId);
+
+    REQUIRE(res.size() == 1);
+    CHECK(res[0]["project_id"].as<std::string>() == projectId);
+    CHECK(res[0]["description_type"].as<std::string>() == "null");  // present, null when unset
+    CHECK(res[0]["column_count"].as<int>() == 2);
+    CHECK(res[0]["first_column"].as<std::string>() == columnId);
+    CHECK(res[0]["task_count"].as<int>() == 2);
+    CHECK(res[0]["first_title"].as<std::string>() == "First");
+    CHECK(res[0]["second_title"].as<std::string>() == "Second");
+    CHECK_FALSE(res[0]["second_has_description"].as<bool>());  // NULL task fields are omitted
+    CHECK(res[0]["second_tag"].as<std::string>() == "bug");
+    CHECK(res[0]["empty_tasks"].as<int>() == 0);
+    CHECK(res[0]["member_count"].as<int>() == 1);
+    CHECK(res[0]["owner_role"].as<std::string>() == "owner");
+}
+
+TEST_CASE("get_project_board returns NULL for an unknown project") {
+    TestDb db; db.cleanAll();
+
+    auto res = db.execParams(
+        "SELECT get_project_board($1::uuid) AS board",
+        "00000000-0000-0000-0000-000000000000");
+
+    REQUIRE(res.size() == 1);
+    CHECK(res[0]["board"].is_null());
+}
+
 TEST_CASE("delete_project executes without error") {
     TestDb db; db.cleanAll();
     std::string userId = db.createTestUser();
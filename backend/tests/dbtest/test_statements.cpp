@@ -0,0 +1,115 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+#include "db_test_helper.h"
+#include "utils/Statements.h"
+#include <vector>
+
+// Contract tests: every statement in the registry prepares against the schema,
+// and its declared parameter types match what Postgres infers, so the binary
+// parameters bound by Database::callFunction have the right width.
+// References: backend/src/utils/Statements.cpp, backend/src/utils/Database.cpp
+
+using kanba::utils::Statement;
+using kanba::utils::Statements;
+
+namespace {
+
+std::vector<std::string> preparedParameterTypes(TestDb& db, const std::string& name) {
+    auto res = db.execParams(
+        "SELECT u.t::text AS type "
+        "FROM pg_prepared_statements p, unnest(p.parameter_types) WITH ORDINALITY AS u(t, n) "
+        "WHERE p.name = $1 ORDER BY u.n",
+        name);
+    std::vector<std::string> types;
+    for (const auto& row : res) {
+        types.push_back(row["type"].as<std::string>());
+    }
+    return types;
+}
+
+} // namespace
+
+TEST_SUITE("DB Contract: Statement Registry") {
+
+TEST_CASE("registered statement names are unique and resolvable") {
+    for (const Statement* statement : Statements::all()) {
+        CAPTURE(statement->name);
+        CHECK(Statements::find(statement->name) == statement);
+    }
+    CHECK(Statements::find("no_such_statement") == nullptr);
+}
+
+TEST_CASE("every registered statement prepares with its declared parameter types") {
+    TestDb db;
+
+    for (const Statement* statement : Statements::all()) {
+        CAPTURE(statement->name);
+        // Server-side PREPARE infers parameter types the same way the
+        // driver's protocol-level prepare does
+        REQUIRE_NOTHROW(db.exec(std::string("PREPARE ") + statement->name + " AS " + statement->sql));
+
+        auto types = preparedParameterTypes(db, statement->name);
+        REQUIRE(types.size() == statement->params.size());
+
+        for (size_t i = 0; i < types.size(); ++i) {
+            CAPTURE(i);
+            CAPTURE(types[i]);
+            switch (statement->params[i]) {
+                case Statement::Param::Integer:
+                    CHECK(types[i] == "integer");
+                    break;
+                case Statement::Param::BigInt:
+                    CHECK(types[i] == "bigint");
+                    break;
+                case Statement::Param::Boolean:
+                    CHECK(types[i] == "boolean");
+                    break;
+                case Statement::Param::Json:
+                    CHECK((types[i] == "jsonb" || types[i] == "json"));
+                    break;
+                case Statement::Param::Text:
+                    // Sent as text, so any type Postgres parses from text
+                    CHECK(types[i] != "integer");
+                    CHECK(types[i] != "bigint");
+                    CHECK(types[i] != "boolean");
+                    break;
+            }
+        }
+    }
+}
+
+TEST_CASE("insert_activity_batch writes one row per event, once, and skips deleted projects") {
+    TestDb db; db.cleanAll();
+    std::string ownerId = db.createTestUser();
+    std::string projectId = db.createTestProject(ownerId);
+    std::string entityId = "00000000-0000-4000-8000-000000000001";
+    std::string goneProjectId = "00000000-0000-4000-8000-0000000000ff";
+
+    auto insertBatch = [&] {
+        db.execParams(
+            Statements::INSERT_ACTIVITY_BATCH.sql,
+            std::string("{\"00000000-0000-4000-8000-00000000a001\",\"00000000-0000-4000-8000-00000000a002\","
+                        "\"00000000-0000-4000-8000-00000000a003\"}"),
+            "{\"" + projectId + "\",\"" + projectId + "\",\"" + goneProjectId + "\"}",
+            "{\"" + ownerId + "\",NULL,\"" + ownerId + "\"}",
+            std::string("{\"created\",\"moved\",\"deleted\"}"),
+            std::string("{\"task\",\"task\",\"task\"}"),
+            "{\"" + entityId + "\",\"" + entityId + "\",\"" + entityId + "\"}",
+            std::string("{\"{\\\"title\\\":\\\"T\\\"}\",\"{}\",\"{}\"}"),
+            std::string("{\"1700000000.5\",\"1700000001\",\"1700000002\"}"));
+    };
+    insertBatch();
+    // A retry of a batch that had committed
+    insertBatch();
+
+    auto rows = db.execParams(
+        "SELECT action, user_id IS NULL AS anonymous, details->>'title' AS title FROM activity_log "
+        "WHERE entity_id = $1::uuid ORDER BY created_at", entityId);
+    REQUIRE(rows.size() == 2);
+    CHECK(rows[0]["action"].as<std::string>() == "created");
+    CHECK(rows[0]["title"].as<std::string>() == "T");
+    CHECK(rows[1]["action"].as<std::string>() == "moved");
+    CHECK(rows[1]["anonymous"].as<bool>());
+}
+
+} // TEST_SUITE
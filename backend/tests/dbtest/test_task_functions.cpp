@@ -165,4 +165,178 @@ TEST_CASE("delete_task executes without error") {
     CHECK(res.size() == 1);
 }
 
+TEST_CASE("task writes leave activity_log to the backend") {
+    TestDb db; db.cleanAll();
+    std::string userId = db.createTestUser();
+    std::string projectId = db.createTestProject(userId);
+    auto cols = db.execParams("SELECT * FROM get_project_columns($1)", projectId);
+    std::string col1 = cols[0]["id"].as<std::string>();
+    std::string col2 = cols[1]["id"].as<std::string>();
+    auto logged = [&] {
+        return db.exec("SELECT COUNT(*) FROM activity_log WHERE entity_type = 'task'")[0][0].as<int>();
+    };
+
+    auto created = db.execParams(
+        "SELECT * FROM create_task($1::uuid, $2, $3, $4, $5::uuid, $6::timestamptz, $7::jsonb, $8::uuid)",
+        col1, "Quiet", "", "medium", null{}, null{}, "[]", userId);
+    std::string taskId = created[0]["id"].as<std::string>();
+    db.execParams(
+        "SELECT * FROM update_task($1::uuid, $2, $3, $4, $5::uuid, $6::timestamptz, $7::jsonb, $8::uuid)",
+        taskId, "Still quiet", null{}, null{}, null{}, null{}, null{}, userId);
+    db.execParams("SELECT move_task($1::uuid, $2::uuid, $3, $4::uuid)", taskId, col2, 0, userId);
+    db.execParams("SELECT delete_task($1::uuid, $2::uuid)", taskId, userId);
+
+    // Queued and appended in batches by utils::ActivityLog instead
+    CHECK(logged() == 0);
+}
+
+TEST_CASE("get_task_project resolves a task to its project") {
+    TestDb db; db.cleanAll();
+    std::string userId = db.createTestUser();
+    std::string projectId = db.createTestProject(userId);
+    std::string columnId = db.getFirstColumnId(projectId);
+
+    auto created = db.execParams(
+        "SELECT * FROM create_task($1::uuid, $2, $3, $4, $5::uuid, $6::timestamptz, $7::jsonb, $8::uuid)",
+        columnId, "Resolvable", "", "medium",
+        null{}, null{}, "[]", userId);
+    std::string taskId = created[0]["id"].as<std::string>();
+
+    auto res = db.execParams("SELECT project_id FROM get_task_project($1)", taskId);
+    REQUIRE(res.size() == 1);
+    CHECK(res[0]["project_id"].as<std::string>() == projectId);
+}
+
+TEST_CASE("tasks carry their column's project_id") {
+    TestDb db; db.cleanAll();
+    std::string userId = db.createTestUser();
+    std::string projectId = db.createTestProject(userId);
+    std::string otherProjectId = db.createTestProject(userId, "Other Project");
+    auto cols = db.execParams("SELECT * FROM get_project_columns($1)", projectId);
+    std::string col1 = cols[0]["id"].as<std::string>();
+    std::string col2 = cols[1]["id"].as<std::string>();
+    std::string otherColumn = db.getFirstColumnId(otherProjectId);
+
+    auto created = db.execParams(
+        "SELECT * FROM create_task($1::uuid, $2, $3, $4, $5::uuid, $6::timestamptz, $7::jsonb, $8::uuid)",
+        col1, "Travelling", "", "medium", null{}, null{}, "[]", userId);
+    std::string taskId = created[0]["id"].as<std::string>();
+    auto projectOf = [&] {
+        return db.execParams("SELECT project_id FROM tasks WHERE id = $1::uuid", taskId)[0][0].as<std::string>();
+    };
+    CHECK(projectOf() == projectId);
+
+    db.execParams("SELECT move_task($1::uuid, $2::uuid, $3, $4::uuid)", taskId, col2, 0, userId);
+    CHECK(projectOf() == projectId);
+
+    // A move to another project's column is refused: TaskController answers
+    // 404 and ProjectAccess may keep caching the task's project
+    auto moved = db.execParams("SELECT move_task($1::uuid, $2::uuid, $3, $4::uuid) AS moved",
+                               taskId, otherColumn, 0, userId);
+    CHECK_FALSE(moved[0]["moved"].as<bool>());
+    CHECK(projectOf() == projectId);
+    auto res = db.execParams("SELECT project_id FROM get_task_project($1)", taskId);
+    REQUIRE(res.size() == 1);
+    CHECK(res[0]["project_id"].as<std::string>() == projectId);
+    CHECK(db.execParams("SELECT column_id FROM tasks WHERE id = $1::uuid", taskId)[0][0].as<std::string>() == col2);
+    CHECK(db.execParams("SELECT task_count FROM projects WHERE id = $1::uuid", otherProjectId)[0][0].as<int>() == 0);
+
+    // The column and project_id must agree
+    CHECK_THROWS(db.execParams("UPDATE tasks SET project_id = $1::uuid WHERE id = $2::uuid", projectId, taskId));
+}
+
+// Titles of a column's tasks in board order
+static std::vector<std::string> columnTitles(TestDb& db, const std::string& projectId,
+                                             const std::string& columnId) {
+    auto res = db.execParams("SELECT title, column_id, position FROM get_project_tasks($1)", projectId);
+    std::vector<std::string> titles;
+    for (const auto& row : res) {
+        if (row["column_id"].as<std::string>() == columnId) {
+            CHECK(row["position"].as<int>() == static_cast<int>(titles.size()));
+            titles.push_back(row["title"].as<std::string>());
+        }
+    }
+    return titles;
+}
+
+TEST_CASE("move_task places the task at the index among the column's other tasks") {
+    TestDb db; db.cleanAll();
+    std::string userId = db.createTestUser();
+    std::string projectId = db.createTestProject(userId);
+    auto cols = db.execParams("SELECT * FROM get_project_columns($1)", projectId);
+    std::string col1 = cols[0]["id"].as<std::string>();
+    std::string col2 = cols[1]["id"].as<std::string>();
+
+    std::vector<std::string> ids;
+    for (const char* title : {"A", "B", "C", "D"}) {
+        auto created = db.execParams(
+            "SELECT * FROM create_task($1::uuid, $2, $3, $4, $5::uuid, $6::timestamptz, $7::jsonb, $8::uuid)",
+            col1, title, "", "medium", null{}, null{}, "[]", userId);
+        ids.push_back(created[0]["id"].as<std::string>());
+    }
+    auto rankOf = [&](const std::string& id) {
+        return db.execParams("SELECT rank FROM tasks WHERE id = $1::uuid", id)[0][0].as<long long>();
+    };
+    long long rankB = rankOf(ids[1]);
+    long long rankD = rankOf(ids[3]);
+
+    // Down within the column: A lands after C, as a drag-and-drop list shows it
+    db.execParams("SELECT move_task($1::uuid, $2::uuid, $3, $4::uuid)", ids[0], col1, 2, userId);
+    CHECK(columnTitles(db, projectId, col1) == std::vector<std::string>{"B", "C", "A", "D"});
+
+    // Only the moved row changed
+    CHECK(rankOf(ids[1]) == rankB);
+    CHECK(rankOf(ids[3]) == rankD);
+
+    // To the head of another column, then past the end of it
+    db.execParams("SELECT move_task($1::uuid, $2::uuid, $3, $4::uuid)", ids[3], col2, 0, userId);
+    db.execParams("SELECT move_task($1::uuid, $2::uuid, $3, $4::uuid)", ids[1], col2, 99, userId);
+    CHECK(columnTitles(db, projectId, col1) == std::vector<std::string>{"C", "A"});
+    CHECK(columnTitles(db, projectId, col2) == std::vector<std::string>{"D", "B"});
+
+    // Deleting leaves the other ranks alone
+    long long rankA = rankOf(ids[0]);
+    db.execParams("SELECT delete_task($1::uuid, $2::uuid)", ids[2], userId);
+    CHECK(rankOf(ids[0]) == rankA);
+    CHECK(columnTitles(db, projectId, col1) == std::vector<std::string>{"A"});
+}
+
+TEST_CASE("repeated moves into one gap queue the column and the rebalance renumbers it") {
+    TestDb db; db.cleanAll();
+    std::string userId = db.createTestUser();
+    std::string projectId = db.createTestProject(userId);
+    std::string columnId = db.getFirstColumnId(projectId);
+
+    std::vector<std::string> ids;
+    for (int i = 0; i < 4; ++i) {
+        auto created = db.execParams(
+            "SELECT * FROM create_task($1::uuid, $2, $3, $4, $5::uuid, $6::timestamptz, $7::jsonb, $8::uuid)",
+            columnId, "T" + std::to_string(i), "", "medium", null{}, null{}, "[]", userId);
+        ids.push_back(created[0]["id"].as<std::string>());
+    }
+
+    // Alternately drop T2 and T3 right after T0: every move halves the same gap,
+    // 20 halvings exhaust it and force one inline renumbering
+    for (int i = 0; i < 20; ++i) {
+        db.execParams("SELECT move_task($1::uuid, $2::uuid, $3, $4::uuid)",
+                      ids[2 + i % 2], columnId, 1, userId);
+    }
+    CHECK(columnTitles(db, projectId, columnId) == std::vector<std::string>{"T0", "T3", "T2", "T1"});
+
+    auto queued = db.execParams("SELECT column_id FROM task_rank_rebalance");
+    REQUIRE(queued.size() == 1);
+    CHECK(queued[0][0].as<std::string>() == columnId);
+
+    auto rebalanced = db.exec("SELECT rebalance_task_ranks(10)");
+    CHECK(rebalanced[0][0].as<int>() == 1);
+    CHECK(db.exec("SELECT COUNT(*) FROM task_rank_rebalance")[0][0].as<int>() == 0);
+
+    auto ranks = db.execParams("SELECT rank FROM tasks WHERE column_id = $1::uuid ORDER BY rank", columnId);
+    REQUIRE(ranks.size() == 4);
+    for (size_t i = 0; i < ranks.size(); ++i) {
+        CHECK(ranks[i][0].as<long long>() == static_cast<long long>(i) * 65536);
+    }
+    CHECK(columnTitles(db, projectId, columnId) == std::vector<std::string>{"T0", "T3", "T2", "T1"});
+}
+
 } // TEST_SUITE
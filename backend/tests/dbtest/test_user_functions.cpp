@@ -69,4 +69,74 @@ TEST_CASE("get_user_by_id returns columns read by AuthController") {
     CHECK(hasColumn(res, "created_at"));
 }
 
+TEST_CASE("get_session_user returns profile and expiry read by Session") {
+    TestDb db; db.cleanAll();
+    std::string userId = db.createTestUser("session@test.com", "Session User");
+    db.execParams("INSERT INTO sessions (id, user_id) VALUES ($1, $2)", "sess-valid", userId);
+
+    auto res = db.execParams("SELECT * FROM get_session_user($1)", "sess-valid");
+
+    REQUIRE(res.size() == 1);
+
+    // Session.cpp (getUserFromSession) reads these columns
+    CHECK(hasColumn(res, "id"));
+    CHECK(hasColumn(res, "email"));
+    CHECK(hasColumn(res, "name"));
+    CHECK(hasColumn(res, "avatar_url"));
+    CHECK(hasColumn(res, "expires_at"));
+
+    CHECK(res[0]["id"].as<std::string>() == userId);
+    CHECK(res[0]["email"].as<std::string>() == "session@test.com");
+}
+
+TEST_CASE("get_session_user returns empty for expired or unknown sessions") {
+    TestDb db; db.cleanAll();
+    std::string userId = db.createTestUser();
+    db.execParams("INSERT INTO sessions (id, user_id, expires_at) VALUES ($1, $2, NOW() - INTERVAL '1 minute')",
+                  "sess-expired", userId);
+
+    CHECK(db.execParams("SELECT * FROM get_session_user($1)", "sess-expired").size() == 0);
+    CHECK(db.execParams("SELECT * FROM get_session_user($1)", "sess-missing").size() == 0);
+}
+
+TEST_CASE("create_session stores a session get_session_user finds for 7 days") {
+    TestDb db; db.cleanAll();
+    std::string userId = db.createTestUser();
+
+    db.execParams("SELECT create_session($1, $2::uuid)", "sess-new", userId);
+
+    auto res = db.execParams("SELECT * FROM get_session_user($1)", "sess-new");
+    REQUIRE(res.size() == 1);
+    CHECK(res[0]["id"].as<std::string>() == userId);
+    CHECK(db.execParams("SELECT 1 FROM sessions WHERE id = $1 "
+                        "AND expires_at > NOW() + INTERVAL '6 days 23 hours'", "sess-new").size() == 1);
+}
+
+TEST_CASE("cleanup_expired_sessions_batch deletes at most one batch of expired rows") {
+    TestDb db; db.cleanAll();
+    std::string userId = db.createTestUser();
+    for (int i = 0; i < 3; ++i) {
+        db.execParams("INSERT INTO sessions (id, user_id, expires_at) VALUES ($1, $2, NOW() - INTERVAL '1 hour')",
+                      "sess-old-" + std::to_string(i), userId);
+    }
+    db.execParams("INSERT INTO sessions (id, user_id) VALUES ($1, $2)", "sess-live", userId);
+
+    // SessionReaper reads the count to decide whether to run another batch
+    CHECK(db.execParams("SELECT cleanup_expired_sessions_batch($1) AS deleted", 2)[0]["deleted"].as<int>() == 2);
+    CHECK(db.execParams("SELECT cleanup_expired_sessions_batch($1) AS deleted", 2)[0]["deleted"].as<int>() == 1);
+    CHECK(db.execParams("SELECT cleanup_expired_sessions_batch($1) AS deleted", 2)[0]["deleted"].as<int>() == 0);
+
+    CHECK(db.exec("SELECT id FROM sessions").size() == 1);
+}
+
+TEST_CASE("cleanup_revoked_sessions_batch keeps revocations of unexpired tokens") {
+    TestDb db; db.cleanAll();
+    db.exec("INSERT INTO revoked_sessions (token_id, expires_at) VALUES "
+            "('00000000000000000000000000000001', NOW() - INTERVAL '1 hour'), "
+            "('00000000000000000000000000000002', NOW() + INTERVAL '1 hour')");
+
+    CHECK(db.execParams("SELECT cleanup_revoked_sessions_batch($1) AS deleted", 10)[0]["deleted"].as<int>() == 1);
+    CHECK(db.exec("SELECT token_id FROM revoked_sessions").size() == 1);
+}
+
 } // TEST_SUITE
@@ -49,7 +49,9 @@ HttpTestClient::~HttpTestClient() {
 HttpTestClient::HttpTestClient(HttpTestClient&& other) noexcept
     : baseUrl_(std::move(other.baseUrl_)),
       cookieJarPath_(std::move(other.cookieJarPath_)),
-      origin_(std::move(other.origin_)) {
+      origin_(std::move(other.origin_)),
+      extraCookie_(std::move(other.extraCookie_)),
+      authorization_(std::move(other.authorization_)) {
     other.cookieJarPath_.clear();  // Prevent double-delete of temp file
 }
 
@@ -61,6 +63,8 @@ HttpTestClient& HttpTestClient::operator=(HttpTestClient&& other) noexcept {
         baseUrl_ = std::move(other.baseUrl_);
         cookieJarPath_ = std::move(other.cookieJarPath_);
         origin_ = std::move(other.origin_);
+        extraCookie_ = std::move(other.extraCookie_);
+        authorization_ = std::move(other.authorization_);
         other.cookieJarPath_.clear();
     }
     return *this;
@@ -102,6 +106,14 @@ void HttpTestClient::setOrigin(const std::string& origin) {
     origin_ = origin;
 }
 
+void HttpTestClient::setCookie(const std::string& name, const std::string& value) {
+    extraCookie_ = name + "=" + value;
+}
+
+void HttpTestClient::setAuthorization(const std::string& value) {
+    authorization_ = value;
+}
+
 size_t HttpTestClient::writeCallback(char* ptr, size_t size, size_t nmemb, void* userdata) {
     auto* body = static_cast<std::string*>(userdata);
     body->append(ptr, size * nmemb);
@@ -164,6 +176,9 @@ HttpResponse HttpTestClient::execute(const std::string& method,
     curl_easy_setopt(curl, CURLOPT_COOKIEJAR, cookieJarPath_.c_str());
     curl_easy_setopt(curl, CURLOPT_COOKIEFILE, cookieJarPath_.c_str());
     curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
+    if (!extraCookie_.empty()) {
+        curl_easy_setopt(curl, CURLOPT_COOKIE, extraCookie_.c_str());
+    }
 
     struct curl_slist* headerList = nullptr;
     headerList = curl_slist_append(headerList, "Content-Type: application/json");
@@ -172,6 +187,10 @@ HttpResponse HttpTestClient::execute(const std::string& method,
         headerList = curl_slist_append(headerList, ("Origin: " + origin_).c_str());
     }
 
+    if (!authorization_.empty()) {
+        headerList = curl_slist_append(headerList, ("Authorization: " + authorization_).c_str());
+    }
+
     curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headerList);
 
     if (method == "POST") {
@@ -30,6 +30,10 @@ public:
 
     void clearCookies();
     void setOrigin(const std::string& origin);
+    // Send a cookie that was not set by the server (e.g. a forged session)
+    void setCookie(const std::string& name, const std::string& value);
+    // Send an Authorization header (e.g. "Bearer <token>") with every request
+    void setAuthorization(const std::string& value);
 
     HttpTestClient(const HttpTestClient&) = delete;
     HttpTestClient& operator=(const HttpTestClient&) = delete;
@@ -40,6 +44,8 @@ private:
     std::string baseUrl_;
     std::string cookieJarPath_;
     std::string origin_;
+    std::string extraCookie_;
+    std::string authorization_;
 
     HttpResponse execute(const std::string& method,
                          const std::string& path,
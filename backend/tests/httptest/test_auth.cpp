@@ -116,6 +116,21 @@ TEST_SUITE("Auth") {
         CHECK(resp.body["error"].asString() == "Invalid email or password");
     }
 
+    TEST_CASE("POST /api/auth/login - repeated attempts on one email return 429") {
+        httptest::HttpTestClient client;
+        Json::Value body;
+        body["email"] = uniqueEmail("stuffing");
+        body["password"] = "guess";
+
+        // Per-email burst is small (AUTH_EMAIL_BURST, default 5)
+        httptest::HttpResponse last;
+        for (int i = 0; i < 10; ++i) {
+            last = client.post("/api/auth/login", body);
+        }
+        CHECK(last.statusCode == 429);
+        CHECK(last.hasHeader("retry-after"));
+    }
+
     TEST_CASE("POST /api/auth/login - success with correct credentials") {
         getTestDb().cleanAll();
         auto email = uniqueEmail("login_ok");
@@ -179,6 +194,52 @@ TEST_SUITE("Auth") {
         CHECK(meResp.body["user"].isNull());
     }
 
+    TEST_CASE("POST /api/auth/logout - a cached session is rejected right after logout") {
+        getTestDb().cleanAll();
+        httptest::HttpTestClient client;
+        Json::Value body;
+        body["email"] = uniqueEmail("logout_cached");
+        body["password"] = "Pass123";
+        body["name"] = "Cached User";
+        auto registered = client.post("/api/auth/register", body);
+        REQUIRE(registered.statusCode == 200);
+        std::string session = sessionCookie(registered);
+        REQUIRE(!session.empty());
+
+        // The second request is answered from the session cache
+        CHECK(client.get("/api/projects").statusCode == 200);
+        CHECK(client.get("/api/projects").statusCode == 200);
+
+        CHECK(client.post("/api/auth/logout").statusCode == 200);
+
+        // Replaying the old cookie must not hit a stale cache entry
+        httptest::HttpTestClient replay;
+        replay.setCookie("session", session);
+        CHECK(replay.get("/api/projects").statusCode == 401);
+        CHECK(replay.get("/api/auth/me").body["user"].isNull());
+    }
+
+    TEST_CASE("GET /api/auth/me - a session just created on another node is accepted") {
+        getTestDb().cleanAll();
+        auto email = uniqueEmail("other_node");
+        registerAndLogin(email, "Pass123", "Other Node User");
+
+        // Inserted the way another backend would, so only the next filter
+        // sync could know it; the miss has to be checked in the database
+        auto inserted = getTestDb().execParams(
+            "INSERT INTO sessions (id, user_id) SELECT uuid_generate_v4()::text, id FROM users WHERE email = $1 "
+            "RETURNING id", email);
+        REQUIRE(inserted.size() == 1);
+        std::string sessionId = inserted[0]["id"].as<std::string>();
+
+        httptest::HttpTestClient client;
+        client.setCookie("session", sessionId);
+        auto resp = client.get("/api/auth/me");
+        CHECK(resp.statusCode == 200);
+        CHECK(resp.body["user"]["email"].asString() == email);
+        CHECK(client.get("/api/projects").statusCode == 200);
+    }
+
     TEST_CASE("PUT /api/auth/update - requires authentication") {
         httptest::HttpTestClient client;
         Json::Value body;
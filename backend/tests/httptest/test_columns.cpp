@@ -111,6 +111,44 @@ TEST_SUITE("Columns") {
         CHECK(columns.size() == 2);  // Only the 2 default columns remain
     }
 
+    TEST_CASE("POST /api/columns/move - reorders columns") {
+        getTestDb().cleanAll();
+        auto email = uniqueEmail("col_move");
+        auto client = registerAndLogin(email, "Pass123", "User");
+        auto projectId = createProject(client, "Col Project");
+
+        Json::Value body;
+        body["project_id"] = projectId;
+        body["name"] = "Review";
+        auto createResp = client.post("/api/columns", body);
+        auto reviewId = createResp.body["id"].asString();
+
+        Json::Value move;
+        move["column_id"] = reviewId;
+        move["position"] = 0;
+        auto resp = client.post("/api/columns/move", move);
+        CHECK(resp.statusCode == 200);
+        CHECK(resp.body["success"].asBool() == true);
+
+        auto columns = getProjectColumns(client, projectId);
+        REQUIRE(columns.size() == 3);
+        CHECK(columns[0].second == "Review");
+        CHECK(columns[1].second == "To Do");
+        CHECK(columns[2].second == "Done");
+    }
+
+    TEST_CASE("POST /api/columns/move - missing fields returns 400") {
+        getTestDb().cleanAll();
+        auto email = uniqueEmail("col_movemissing");
+        auto client = registerAndLogin(email, "Pass123", "User");
+
+        Json::Value body;
+        body["column_id"] = "00000000-0000-0000-0000-000000000000";
+        auto resp = client.post("/api/columns/move", body);
+        CHECK(resp.statusCode == 400);
+        CHECK(resp.body["error"].asString() == "Column ID and position are required");
+    }
+
     TEST_CASE("DELETE /api/columns - missing id returns 400") {
         getTestDb().cleanAll();
         auto email = uniqueEmail("col_delmissing");
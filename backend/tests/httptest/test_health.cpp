@@ -19,4 +19,14 @@ TEST_SUITE("Health") {
         CHECK(resp.getHeader("content-type").find("application/json") != std::string::npos);
     }
 
+    TEST_CASE("GET /api/health reports the database circuit as closed") {
+        httptest::HttpTestClient client;
+        auto resp = client.get("/api/health");
+
+        CHECK(resp.statusCode == 200);
+        CHECK(resp.body["database"]["circuit"].asString() == "closed");
+        CHECK(resp.body["database"].isMember("in_flight"));
+        CHECK(resp.body["database"].isMember("latency_ms"));
+    }
+
 }
@@ -1,4 +1,5 @@
 #include "test_helpers.h"
+#include <cstdlib>
 #include <stdexcept>
 
 static TestDb* gTestDb = nullptr;
@@ -35,6 +36,23 @@ httptest::HttpTestClient registerAndLogin(
     return client;
 }
 
+httptest::HttpTestClient metricsAdminClient() {
+    const char* token = std::getenv("METRICS_TOKEN");
+    httptest::HttpTestClient client;
+    client.setAuthorization(std::string("Bearer ") + (token ? token : "test-metrics-token"));
+    return client;
+}
+
+std::string sessionCookie(const httptest::HttpResponse& resp) {
+    std::string header = resp.getHeader("set-cookie");
+    auto start = header.find("session=");
+    if (start == std::string::npos) {
+        return "";
+    }
+    start += 8;
+    return header.substr(start, header.find(';', start) - start);
+}
+
 std::string uniqueEmail(const std::string& prefix) {
     int n = emailCounter.fetch_add(1);
     return prefix + "_" + std::to_string(n) + "@test.com";
@@ -16,6 +16,12 @@ httptest::HttpTestClient registerAndLogin(
     const std::string& name = "Test User"
 );
 
+// A client that may read /api/metrics (METRICS_TOKEN, as given to the backend)
+httptest::HttpTestClient metricsAdminClient();
+
+// Value of the session cookie a response sets ("" when it sets none)
+std::string sessionCookie(const httptest::HttpResponse& resp);
+
 // Generate unique email addresses to avoid conflicts
 std::string uniqueEmail(const std::string& prefix = "test");
 
@@ -0,0 +1,172 @@
+#include "doctest.h"
+#include "http_test_client.h"
+#include "test_helpers.h"
+
+TEST_SUITE("Metrics") {
+
+    TEST_CASE("GET /api/metrics - requires the metrics token") {
+        httptest::HttpTestClient anonymous;
+        CHECK(anonymous.get("/api/metrics").statusCode == 401);
+
+        httptest::HttpTestClient wrongToken;
+        wrongToken.setAuthorization("Bearer not-the-token");
+        CHECK(wrongToken.get("/api/metrics").statusCode == 401);
+
+        // A session is not enough either
+        getTestDb().cleanAll();
+        auto user = registerAndLogin(uniqueEmail("nometrics"), "Pass123", "Plain User");
+        CHECK(user.get("/api/metrics").statusCode == 401);
+
+        // Health stays public
+        CHECK(anonymous.get("/api/health").statusCode == 200);
+    }
+
+    TEST_CASE("GET /api/metrics exposes session cache counters") {
+        auto client = metricsAdminClient();
+        auto resp = client.get("/api/metrics");
+
+        CHECK(resp.statusCode == 200);
+        REQUIRE(resp.body.isMember("session_cache"));
+        CHECK(resp.body["session_cache"].isMember("hits"));
+        CHECK(resp.body["session_cache"].isMember("misses"));
+        CHECK(resp.body["session_cache"].isMember("size"));
+    }
+
+    TEST_CASE("GET /api/metrics - password hashing runs on the hash executor") {
+        getTestDb().cleanAll();
+
+        auto metricsClient = metricsAdminClient();
+        auto before = metricsClient.get("/api/metrics");
+        REQUIRE(before.statusCode == 200);
+        REQUIRE(before.body.isMember("password_hashing"));
+        CHECK(before.body["password_hashing"]["workers"].asUInt64() >= 1);
+
+        registerAndLogin(uniqueEmail("hashmetrics"), "Pass123", "Hash User");
+
+        auto after = metricsClient.get("/api/metrics");
+        REQUIRE(after.statusCode == 200);
+        CHECK(after.body["password_hashing"]["completed"].asUInt64() >
+              before.body["password_hashing"]["completed"].asUInt64());
+    }
+
+    TEST_CASE("GET /api/metrics - fresh sessions are not renewed on every request") {
+        getTestDb().cleanAll();
+        auto client = registerAndLogin(uniqueEmail("renewal"), "Pass123", "Renewal User");
+
+        auto metricsClient = metricsAdminClient();
+        auto before = metricsClient.get("/api/metrics");
+        REQUIRE(before.statusCode == 200);
+        REQUIRE(before.body.isMember("session_renewal"));
+
+        for (int i = 0; i < 3; ++i) {
+            CHECK(client.get("/api/projects").statusCode == 200);
+        }
+
+        // Login set the expiry, so these fall inside the skip window
+        auto after = metricsClient.get("/api/metrics");
+        REQUIRE(after.statusCode == 200);
+        CHECK(after.body["session_renewal"]["queued"].asUInt64() ==
+              before.body["session_renewal"]["queued"].asUInt64());
+        CHECK(after.body["session_renewal"]["skipped"].asUInt64() >=
+              before.body["session_renewal"]["skipped"].asUInt64() + 3);
+    }
+
+    TEST_CASE("GET /api/metrics - authenticated requests are served from the session cache") {
+        getTestDb().cleanAll();
+        auto client = registerAndLogin(uniqueEmail("metrics"), "Pass123", "Metrics User");
+
+        auto metricsClient = metricsAdminClient();
+        auto before = metricsClient.get("/api/metrics");
+        REQUIRE(before.statusCode == 200);
+
+        auto resp = client.get("/api/projects");
+        CHECK(resp.statusCode == 200);
+
+        auto after = metricsClient.get("/api/metrics");
+        REQUIRE(after.statusCode == 200);
+        CHECK(after.body["session_cache"]["hits"].asUInt64() >
+              before.body["session_cache"]["hits"].asUInt64());
+    }
+
+    TEST_CASE("GET /api/metrics - forged session cookies are rejected without a DB lookup") {
+        auto metricsClient = metricsAdminClient();
+        auto before = metricsClient.get("/api/metrics");
+        REQUIRE(before.statusCode == 200);
+        REQUIRE(before.body.isMember("session_rejections"));
+
+        httptest::HttpTestClient forged;
+        forged.setCookie("session", "not-a-real-session");
+        CHECK(forged.get("/api/projects").statusCode == 401);
+
+        auto after = metricsClient.get("/api/metrics");
+        CHECK(after.body["session_rejections"]["malformed"].asUInt64() >
+              before.body["session_rejections"]["malformed"].asUInt64());
+    }
+
+    TEST_CASE("GET /api/metrics - repeated unknown session is served from the rejection cache") {
+        httptest::HttpTestClient stale;
+        stale.setCookie("session", "00000000-0000-4000-8000-000000000000");
+        CHECK(stale.get("/api/projects").statusCode == 401);
+
+        auto metricsClient = metricsAdminClient();
+        auto before = metricsClient.get("/api/metrics");
+        REQUIRE(before.statusCode == 200);
+
+        CHECK(stale.get("/api/projects").statusCode == 401);
+
+        auto after = metricsClient.get("/api/metrics");
+        auto rejectedBefore = before.body["session_rejections"]["known_bad"].asUInt64() +
+                              before.body["session_rejections"]["bloom"].asUInt64();
+        auto rejectedAfter = after.body["session_rejections"]["known_bad"].asUInt64() +
+                             after.body["session_rejections"]["bloom"].asUInt64();
+        CHECK(rejectedAfter > rejectedBefore);
+    }
+
+    TEST_CASE("GET /api/metrics - database pools report per-role counters") {
+        getTestDb().cleanAll();
+        auto client = registerAndLogin(uniqueEmail("pools"), "Pass123", "Pool User");
+
+        auto metricsClient = metricsAdminClient();
+        auto before = metricsClient.get("/api/metrics");
+        REQUIRE(before.statusCode == 200);
+        REQUIRE(before.body.isMember("database"));
+        REQUIRE(before.body["database"].isMember("primary"));
+        REQUIRE(before.body["database"].isMember("replica"));
+        REQUIRE(before.body["database"].isMember("read_routing"));
+
+        CHECK(client.get("/api/projects").statusCode == 200);
+
+        // The test stack has no replica, so reads stay on the primary
+        auto after = metricsClient.get("/api/metrics");
+        const auto& db = after.body["database"];
+        CHECK(db["primary"]["queries"].asUInt64() > before.body["database"]["primary"]["queries"].asUInt64());
+        CHECK(db["replica"]["configured"].asBool() == false);
+        CHECK(db["replica"]["queries"].asUInt64() == 0);
+        CHECK(db["read_routing"]["replica_reads"].asUInt64() == 0);
+    }
+
+    TEST_CASE("GET /api/metrics - statements report calls, rows and latency percentiles") {
+        getTestDb().cleanAll();
+        auto client = registerAndLogin(uniqueEmail("statements"), "Pass123", "Statement User");
+        createProject(client, "Statement Project");
+
+        auto metricsClient = metricsAdminClient();
+        auto before = metricsClient.get("/api/metrics");
+        REQUIRE(before.statusCode == 200);
+        REQUIRE(before.body.isMember("statements"));
+
+        CHECK(client.get("/api/projects").statusCode == 200);
+        CHECK(client.get("/api/projects").statusCode == 200);
+
+        auto after = metricsClient.get("/api/metrics");
+        REQUIRE(after.body["statements"].isMember("get_user_projects"));
+        const auto& projects = after.body["statements"]["get_user_projects"];
+        const auto& previous = before.body["statements"]["get_user_projects"];
+        CHECK(projects["calls"].asUInt64() >= previous["calls"].asUInt64() + 2);
+        CHECK(projects["rows"].asUInt64() >= previous["rows"].asUInt64() + 2);
+        CHECK(projects["errors"].asUInt64() == previous["errors"].asUInt64());
+        CHECK(projects["p50_ms"].asDouble() <= projects["p99_ms"].asDouble());
+        CHECK(projects["p99_ms"].asDouble() <= projects["max_ms"].asDouble());
+    }
+
+}
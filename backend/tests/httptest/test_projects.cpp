@@ -87,6 +87,30 @@ TEST_SUITE("Projects") {
         CHECK(resp.body["members"][0]["email"].asString() == email);
     }
 
+    TEST_CASE("GET /api/projects/{id} - nests each task in its own column") {
+        getTestDb().cleanAll();
+        auto client = registerAndLogin(uniqueEmail("proj_board"), "Pass123", "Board User");
+
+        auto projectId = createProject(client, "Board Project");
+        auto columns = getProjectColumns(client, projectId);
+        REQUIRE(columns.size() == 2);
+        createTask(client, columns[0].first, "First");
+        createTask(client, columns[1].first, "Second");
+        createTask(client, columns[1].first, "Third");
+
+        auto resp = client.get("/api/projects/" + projectId);
+        REQUIRE(resp.statusCode == 200);
+        REQUIRE(resp.body["columns"].size() == 2);
+        for (const auto& column : resp.body["columns"]) {
+            for (const auto& task : column["tasks"]) {
+                CHECK(task["column_id"].asString() == column["id"].asString());
+            }
+        }
+        size_t total = resp.body["columns"][0]["tasks"].size() + resp.body["columns"][1]["tasks"].size();
+        CHECK(total == 3);
+        CHECK(resp.body["members"].size() == 1);
+    }
+
     TEST_CASE("GET /api/projects/{id} - non-existent returns 404") {
         getTestDb().cleanAll();
         auto email = uniqueEmail("proj_404");
@@ -97,6 +121,17 @@ TEST_SUITE("Projects") {
         CHECK(resp.body["error"].asString() == "Project not found");
     }
 
+    TEST_CASE("GET /api/projects/{id} - non-member gets 404") {
+        getTestDb().cleanAll();
+        auto ownerClient = registerAndLogin(uniqueEmail("proj_priv_own"), "Pass123", "Owner");
+        auto projectId = createProject(ownerClient, "Private Project");
+
+        auto outsider = registerAndLogin(uniqueEmail("proj_priv_out"), "Pass123", "Outsider");
+        auto resp = outsider.get("/api/projects/" + projectId);
+        CHECK(resp.statusCode == 404);
+        CHECK(resp.body["error"].asString() == "Project not found");
+    }
+
     TEST_CASE("DELETE /api/projects/{id} - owner can delete") {
         getTestDb().cleanAll();
         auto email = uniqueEmail("proj_del");
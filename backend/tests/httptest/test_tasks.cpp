@@ -1,6 +1,8 @@
 #include "doctest.h"
 #include "http_test_client.h"
 #include "test_helpers.h"
+#include <chrono>
+#include <thread>
 
 TEST_SUITE("Tasks") {
 
@@ -102,6 +104,22 @@ TEST_SUITE("Tasks") {
         CHECK(resp.body["priority"].asString() == "low");
     }
 
+    TEST_CASE("PUT /api/tasks - non-member gets 404") {
+        getTestDb().cleanAll();
+        auto owner = registerAndLogin(uniqueEmail("task_priv_own"), "Pass123", "Owner");
+        auto projectId = createProject(owner, "Task Project");
+        auto columnId = getFirstColumnId(owner, projectId);
+        auto taskId = createTask(owner, columnId, "Private Task");
+
+        auto outsider = registerAndLogin(uniqueEmail("task_priv_out"), "Pass123", "Outsider");
+        Json::Value body;
+        body["id"] = taskId;
+        body["title"] = "Hijacked";
+        auto resp = outsider.put("/api/tasks", body);
+        CHECK(resp.statusCode == 404);
+        CHECK(resp.body["error"].asString() == "Task not found");
+    }
+
     TEST_CASE("PUT /api/tasks - missing id returns 400") {
         getTestDb().cleanAll();
         auto email = uniqueEmail("task_noid");
@@ -177,6 +195,36 @@ TEST_SUITE("Tasks") {
         CHECK(foundInCol2);
     }
 
+    TEST_CASE("POST /api/tasks/move - a column of another project returns 404") {
+        getTestDb().cleanAll();
+        auto email = uniqueEmail("task_move_project");
+        auto client = registerAndLogin(email, "Pass123", "User");
+        auto projectId = createProject(client, "Home Project");
+        auto otherProjectId = createProject(client, "Other Project");
+        auto taskId = createTask(client, getFirstColumnId(client, projectId), "Stays Home");
+
+        Json::Value body;
+        body["task_id"] = taskId;
+        body["column_id"] = getFirstColumnId(client, otherProjectId);
+        body["position"] = 0;
+        auto resp = client.post("/api/tasks/move", body);
+        CHECK(resp.statusCode == 404);
+
+        // Still on its own board, and nothing arrived on the other
+        auto home = client.get("/api/projects/" + projectId);
+        bool found = false;
+        for (const auto& col : home.body["columns"]) {
+            for (const auto& task : col["tasks"]) {
+                found = found || task["id"].asString() == taskId;
+            }
+        }
+        CHECK(found);
+        auto other = client.get("/api/projects/" + otherProjectId);
+        for (const auto& col : other.body["columns"]) {
+            CHECK(col["tasks"].size() == 0);
+        }
+    }
+
     TEST_CASE("POST /api/tasks/move - missing fields returns 400") {
         getTestDb().cleanAll();
         auto email = uniqueEmail("task_movebad");
@@ -197,4 +245,48 @@ TEST_SUITE("Tasks") {
         }
     }
 
+    TEST_CASE("POST /api/tasks - activity is written to the log in batches") {
+        getTestDb().cleanAll();
+        auto client = registerAndLogin(uniqueEmail("activity"), "Pass123", "Activity User");
+        auto projectId = createProject(client, "Activity Project");
+        auto columns = getProjectColumns(client, projectId);
+        REQUIRE(columns.size() == 2);
+
+        auto metricsClient = metricsAdminClient();
+        auto before = metricsClient.get("/api/metrics");
+        REQUIRE(before.statusCode == 200);
+        REQUIRE(before.body.isMember("activity_log"));
+
+        auto taskId = createTask(client, columns[0].first, "Logged Task");
+        Json::Value move;
+        move["task_id"] = taskId;
+        move["column_id"] = columns[1].first;
+        move["position"] = 0;
+        CHECK(client.post("/api/tasks/move", move).statusCode == 200);
+        CHECK(client.del("/api/tasks?id=" + taskId).statusCode == 200);
+
+        // Async by default: the events land within a few flush intervals
+        std::string count = "SELECT COUNT(*) FROM activity_log WHERE entity_id = '" + taskId + "'";
+        for (int i = 0; i < 50 && getTestDb().exec(count)[0][0].as<int>() < 3; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        auto actions = getTestDb().exec(
+            "SELECT action, details->>'title' AS title, details->>'column' AS column_name FROM activity_log "
+            "WHERE entity_id = '" + taskId + "' ORDER BY created_at");
+        REQUIRE(actions.size() == 3);
+        CHECK(actions[0]["action"].as<std::string>() == "created");
+        CHECK(actions[0]["title"].as<std::string>() == "Logged Task");
+        CHECK(actions[1]["action"].as<std::string>() == "moved");
+        CHECK(actions[1]["column_name"].as<std::string>() == columns[1].second);
+        CHECK(actions[2]["action"].as<std::string>() == "deleted");
+
+        auto after = metricsClient.get("/api/metrics");
+        REQUIRE(after.statusCode == 200);
+        CHECK(after.body["activity_log"]["written"].asUInt64() >=
+              before.body["activity_log"]["written"].asUInt64() + 3);
+        CHECK(after.body["activity_log"]["batches"].asUInt64() > before.body["activity_log"]["batches"].asUInt64());
+        CHECK(after.body["activity_log"].isMember("lag_ms"));
+        CHECK(after.body["activity_log"].isMember("dropped"));
+    }
+
 }
@@ -0,0 +1,162 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+#include "utils/DbCircuitBreaker.h"
+#include <chrono>
+#include <thread>
+
+// Tests for the database circuit breaker's state machine: opening on
+// latency, failures and queue depth, probing while half open, and which
+// queries may decide the probe. Reference: utils/DbCircuitBreaker.h
+
+using namespace kanba::utils;
+using namespace std::chrono_literals;
+
+namespace {
+
+using State = DbCircuitBreaker::State;
+
+DbCircuitBreaker::Options testOptions() {
+    DbCircuitBreaker::Options options;
+    options.maxInFlight = 10;
+    options.latencyThresholdMs = 100;
+    options.minSamples = 5;
+    options.openSeconds = 1;
+    options.halfOpenProbes = 2;
+    return options;
+}
+
+State state() {
+    return DbCircuitBreaker::stats().state;
+}
+
+void runQuery(std::chrono::nanoseconds latency, bool unavailable = false, uint64_t probe = 0) {
+    DbCircuitBreaker::queryStarted();
+    DbCircuitBreaker::queryFinished(latency, unavailable, probe);
+}
+
+// Open on failures, wait out the open period and admit the first probe
+uint64_t openAndProbe() {
+    for (int i = 0; i < 100 && state() == State::Closed; ++i) {
+        runQuery(1ms, true);
+    }
+    REQUIRE(state() == State::Open);
+    std::this_thread::sleep_for(1100ms);
+    uint64_t probe = 0;
+    REQUIRE(DbCircuitBreaker::allowRequest(probe));
+    REQUIRE(state() == State::HalfOpen);
+    REQUIRE(probe != 0);
+    return probe;
+}
+
+} // namespace
+
+TEST_SUITE("DbCircuitBreaker") {
+
+TEST_CASE("stays closed below minSamples and opens on latency") {
+    DbCircuitBreaker::configure(testOptions());
+    uint64_t probe = 1;
+    CHECK(DbCircuitBreaker::allowRequest(probe));
+    CHECK(probe == 0);
+
+    for (int i = 0; i < 4; ++i) {
+        runQuery(1s);
+    }
+    CHECK(state() == State::Closed);
+    runQuery(1s);
+    CHECK(state() == State::Open);
+
+    uint64_t rejected = DbCircuitBreaker::stats().rejected;
+    CHECK_FALSE(DbCircuitBreaker::allowRequest(probe));
+    CHECK(DbCircuitBreaker::stats().rejected == rejected + 1);
+    CHECK(DbCircuitBreaker::retryAfterSeconds() == 1);
+}
+
+TEST_CASE("opens when too many queries are outstanding") {
+    DbCircuitBreaker::configure(testOptions());
+    for (int i = 0; i < 10; ++i) {
+        DbCircuitBreaker::queryStarted();
+    }
+    CHECK(state() == State::Closed);
+    DbCircuitBreaker::queryStarted();
+    CHECK(state() == State::Open);
+    for (int i = 0; i < 11; ++i) {
+        DbCircuitBreaker::queryFinished(1ms, false, 0);
+    }
+    CHECK(DbCircuitBreaker::stats().inFlight == 0);
+}
+
+TEST_CASE("half open admits halfOpenProbes requests and closes on their queries") {
+    DbCircuitBreaker::configure(testOptions());
+    uint64_t first = openAndProbe();
+    uint64_t second = 0;
+    CHECK(DbCircuitBreaker::allowRequest(second));
+    CHECK(second == first);
+    uint64_t third = 0;
+    CHECK_FALSE(DbCircuitBreaker::allowRequest(third));
+
+    runQuery(1ms, false, first);
+    CHECK(state() == State::HalfOpen);
+    runQuery(1ms, false, second);
+    CHECK(state() == State::Closed);
+}
+
+TEST_CASE("queries not issued by a probe do not decide the probe") {
+    DbCircuitBreaker::configure(testOptions());
+    uint64_t probe = openAndProbe();
+
+    // Stragglers and background jobs, fast or failing
+    for (int i = 0; i < 10; ++i) {
+        runQuery(1ms);
+        runQuery(1ms, true);
+    }
+    CHECK(state() == State::HalfOpen);
+
+    // A query tagged by the previous half-open period is a straggler too
+    runQuery(1ms, true, probe - 1);
+    CHECK(state() == State::HalfOpen);
+
+    runQuery(1s, false, probe);
+    CHECK(state() == State::Open);
+}
+
+TEST_CASE("ProbeScope marks the queries of the current thread") {
+    CHECK(DbCircuitBreaker::currentProbe() == 0);
+    {
+        DbCircuitBreaker::ProbeScope outer(7);
+        CHECK(DbCircuitBreaker::currentProbe() == 7);
+        {
+            DbCircuitBreaker::ProbeScope inner(0);
+            CHECK(DbCircuitBreaker::currentProbe() == 0);
+        }
+        CHECK(DbCircuitBreaker::currentProbe() == 7);
+        std::thread([] { CHECK(DbCircuitBreaker::currentProbe() == 0); }).join();
+    }
+    CHECK(DbCircuitBreaker::currentProbe() == 0);
+}
+
+TEST_CASE("a timed-out query is counted once") {
+    DbCircuitBreaker::configure(testOptions());
+    DbCircuitBreaker::queryStarted();
+    DbCircuitBreaker::queryTimedOut(0);
+    auto afterTimeout = DbCircuitBreaker::stats();
+    CHECK(afterTimeout.failureRatio > 0);
+    CHECK(afterTimeout.inFlight == 1);
+
+    // The answer that finally arrives only frees its slot
+    DbCircuitBreaker::lateQueryFinished();
+    auto afterAnswer = DbCircuitBreaker::stats();
+    CHECK(afterAnswer.failureRatio == doctest::Approx(afterTimeout.failureRatio));
+    CHECK(afterAnswer.latencyMs == 0);
+    CHECK(afterAnswer.inFlight == 0);
+}
+
+TEST_CASE("a timed-out probe query reopens the breaker") {
+    DbCircuitBreaker::configure(testOptions());
+    uint64_t probe = openAndProbe();
+    DbCircuitBreaker::queryStarted();
+    DbCircuitBreaker::queryTimedOut(probe);
+    CHECK(state() == State::Open);
+    DbCircuitBreaker::lateQueryFinished();
+}
+
+} // TEST_SUITE
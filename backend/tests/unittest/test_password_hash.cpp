@@ -0,0 +1,63 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+#include "utils/PasswordHash.h"
+#include <sodium.h>
+#include <string>
+
+// Tests for the rehash-on-login decision: a hash is replaced only when it is
+// weaker than the current Argon2id parameters, never when it is stronger.
+// Reference: utils/PasswordHash.h
+
+using namespace kanba::utils;
+
+namespace {
+
+const std::string PASSWORD = "correct horse battery staple";
+
+std::string hashWith(unsigned long long ops, size_t mem, int alg = crypto_pwhash_ALG_ARGON2ID13) {
+    char hashed[crypto_pwhash_STRBYTES];
+    REQUIRE(crypto_pwhash_str_alg(hashed, PASSWORD.c_str(), PASSWORD.size(), ops, mem, alg) == 0);
+    return hashed;
+}
+
+bool needsRehash(const std::string& storedHash) {
+    bool rehash = false;
+    REQUIRE(PasswordHash::verify(PASSWORD, storedHash, rehash));
+    return rehash;
+}
+
+} // namespace
+
+TEST_SUITE("PasswordHash") {
+
+TEST_CASE("a hash with the current parameters is kept") {
+    REQUIRE(PasswordHash::initialize());
+    CHECK_FALSE(needsRehash(PasswordHash::hash(PASSWORD)));
+}
+
+TEST_CASE("a hash with fewer passes or less memory is replaced") {
+    REQUIRE(PasswordHash::initialize());
+    CHECK(needsRehash(hashWith(PasswordHash::opsLimit() - 1, PasswordHash::memoryPerHash())));
+    CHECK(needsRehash(hashWith(PasswordHash::opsLimit(), PasswordHash::memoryPerHash() / 2)));
+}
+
+TEST_CASE("a hash with more passes or more memory is kept") {
+    REQUIRE(PasswordHash::initialize());
+    CHECK_FALSE(needsRehash(hashWith(PasswordHash::opsLimit() + 1, PasswordHash::memoryPerHash())));
+    CHECK_FALSE(needsRehash(hashWith(PasswordHash::opsLimit(), PasswordHash::memoryPerHash() + 8 * 1024 * 1024)));
+}
+
+TEST_CASE("an Argon2i hash is replaced") {
+    REQUIRE(PasswordHash::initialize());
+    CHECK(needsRehash(hashWith(PasswordHash::opsLimit() + 1, PasswordHash::memoryPerHash(),
+                               crypto_pwhash_ALG_ARGON2I13)));
+}
+
+TEST_CASE("a wrong password reports no rehash") {
+    REQUIRE(PasswordHash::initialize());
+    bool rehash = true;
+    CHECK_FALSE(PasswordHash::verify("wrong", hashWith(1, PasswordHash::memoryPerHash() / 2), rehash));
+    CHECK_FALSE(rehash);
+}
+
+} // TEST_SUITE
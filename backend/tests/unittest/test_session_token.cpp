@@ -0,0 +1,116 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+#include "utils/RevocationList.h"
+#include "utils/SessionToken.h"
+#include <sodium.h>
+#include <chrono>
+#include <string>
+
+// Tests for signed session tokens (SESSION_MODE=signed): signing, MAC and
+// key checks, expiry, and revocation as Session::verifySignedSession
+// combines them. Reference: utils/SessionToken.h, utils/RevocationList.h
+
+using namespace kanba::utils;
+
+namespace {
+
+const std::string USER_ID = "3f2b8c1e-5a4d-4e6f-9b7a-0c1d2e3f4a5b";
+const std::string KEY_1 = "k1:" + std::string(64, 'a');
+const std::string KEY_2 = "k2:" + std::string(64, 'b');
+
+// Flip one character of the given part of "<kid>.<payload>.<mac>"
+std::string tamper(std::string token, size_t part) {
+    size_t pos = 0;
+    for (size_t i = 0; i < part; ++i) {
+        pos = token.find('.', pos) + 1;
+    }
+    token[pos + 2] = token[pos + 2] == 'A' ? 'B' : 'A';
+    return token;
+}
+
+struct SodiumInit {
+    SodiumInit() { REQUIRE(sodium_init() >= 0); }
+};
+
+} // namespace
+
+TEST_SUITE("SessionToken") {
+
+TEST_CASE("configure rejects malformed key lists") {
+    SodiumInit sodium;
+    CHECK_FALSE(SessionToken::configure("", ""));
+    CHECK_FALSE(SessionToken::configure("k1:abcd", ""));
+    CHECK_FALSE(SessionToken::configure("k.1:" + std::string(64, 'a'), ""));
+    CHECK_FALSE(SessionToken::configure(KEY_1, "k2"));
+}
+
+TEST_CASE("an issued token verifies and carries its claims") {
+    SodiumInit sodium;
+    REQUIRE(SessionToken::configure(KEY_1, "k1"));
+
+    std::string token = SessionToken::issue(USER_ID, std::chrono::hours(1));
+    CHECK(token.rfind("k1.", 0) == 0);
+
+    auto claims = SessionToken::verify(token);
+    REQUIRE(claims.has_value());
+    CHECK(claims->userId == USER_ID);
+    CHECK(claims->expiresAt - claims->issuedAt == 3600);
+
+    // Every token gets its own ID
+    auto other = SessionToken::verify(SessionToken::issue(USER_ID, std::chrono::hours(1)));
+    REQUIRE(other.has_value());
+    CHECK(other->tokenId != claims->tokenId);
+}
+
+TEST_CASE("a tampered token is rejected") {
+    SodiumInit sodium;
+    REQUIRE(SessionToken::configure(KEY_1, "k1"));
+    std::string token = SessionToken::issue(USER_ID, std::chrono::hours(1));
+
+    CHECK_FALSE(SessionToken::verify(tamper(token, 1)).has_value());  // payload
+    CHECK_FALSE(SessionToken::verify(tamper(token, 2)).has_value());  // MAC
+    CHECK_FALSE(SessionToken::verify(token.substr(0, token.size() - 1)).has_value());
+    CHECK_FALSE(SessionToken::verify("k1." + token.substr(token.find('.') + 1, 20)).has_value());
+    CHECK_FALSE(SessionToken::verify("").has_value());
+}
+
+TEST_CASE("a token signed with an unknown or different key is rejected") {
+    SodiumInit sodium;
+    REQUIRE(SessionToken::configure(KEY_2, "k2"));
+    std::string signedByK2 = SessionToken::issue(USER_ID, std::chrono::hours(1));
+
+    // k2 removed: its tokens stop verifying
+    REQUIRE(SessionToken::configure(KEY_1, "k1"));
+    CHECK_FALSE(SessionToken::verify(signedByK2).has_value());
+
+    // Relabelled with a known key ID, the MAC no longer matches
+    CHECK_FALSE(SessionToken::verify("k1" + signedByK2.substr(2)).has_value());
+
+    // During a rotation both keys verify
+    REQUIRE(SessionToken::configure(KEY_1 + "," + KEY_2, "k1"));
+    CHECK(SessionToken::verify(signedByK2).has_value());
+}
+
+TEST_CASE("an expired token is rejected") {
+    SodiumInit sodium;
+    REQUIRE(SessionToken::configure(KEY_1, "k1"));
+    CHECK_FALSE(SessionToken::verify(SessionToken::issue(USER_ID, std::chrono::seconds(0))).has_value());
+    CHECK_FALSE(SessionToken::verify(SessionToken::issue(USER_ID, std::chrono::seconds(-60))).has_value());
+}
+
+TEST_CASE("a revoked token is rejected while others stay valid") {
+    SodiumInit sodium;
+    REQUIRE(SessionToken::configure(KEY_1, "k1"));
+    auto loggedOut = SessionToken::verify(SessionToken::issue(USER_ID, std::chrono::hours(1)));
+    auto stillIn = SessionToken::verify(SessionToken::issue(USER_ID, std::chrono::hours(1)));
+    REQUIRE(loggedOut.has_value());
+    REQUIRE(stillIn.has_value());
+
+    // No database here: revoke() applies locally and skips persisting
+    RevocationList::revoke(loggedOut->tokenId, loggedOut->expiresAt);
+
+    CHECK(RevocationList::isRevoked(loggedOut->tokenId));
+    CHECK_FALSE(RevocationList::isRevoked(stillIn->tokenId));
+}
+
+} // TEST_SUITE
@@ -0,0 +1,159 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+#include "utils/SlowQueryLog.h"
+#include "utils/Statements.h"
+#include <unistd.h>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Tests for what the slow query log keeps and re-runs: only read-only
+// statements are explained, and parameter values never reach the log file.
+// No database is needed; without one an explain is reported as skipped.
+// Reference: utils/SlowQueryLog.h, utils/Statements.h
+
+using namespace kanba::utils;
+using namespace std::chrono_literals;
+
+namespace {
+
+const std::string SECRET = "3f2b8c1e-5a4d-4e6f-9b7a-0c1d2e3f4a5b";
+
+std::string logPath() {
+    return (std::filesystem::temp_directory_path() /
+            ("kanba_slow_queries_" + std::to_string(::getpid()) + ".log")).string();
+}
+
+void startLog(bool explain) {
+    std::filesystem::remove(logPath());
+    SlowQueryLog::Options options;
+    options.thresholdMs = 10;
+    options.explain = explain;
+    options.explainIntervalSeconds = 0;
+    options.statementIntervalSeconds = 0;
+    options.explainTimeoutMs = 1000;
+    options.path = logPath();
+    options.maxFiles = 0;
+    SlowQueryLog::start(options);
+}
+
+// Stop the writer so everything queued is in the file, and read it back
+std::vector<std::string> stopAndRead() {
+    SlowQueryLog::stop();
+    std::ifstream file(logPath());
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(file, line);) {
+        lines.push_back(line);
+    }
+    std::filesystem::remove(logPath());
+    return lines;
+}
+
+SlowQueryLog::Params params(std::vector<std::string> values) {
+    return std::make_shared<const std::vector<std::string>>(std::move(values));
+}
+
+// Lines under the entry for a statement: its plan, or why there is none
+std::vector<std::string> explainLines(const std::vector<std::string>& lines, const std::string& name) {
+    std::vector<std::string> found;
+    bool inEntry = false;
+    for (const auto& line : lines) {
+        if (line.rfind("  ", 0) != 0) {
+            inEntry = line.find("slow query " + name + ":") != std::string::npos;
+        } else if (inEntry) {
+            found.push_back(line);
+        }
+    }
+    return found;
+}
+
+bool mentions(const std::vector<std::string>& lines, const std::string& text) {
+    for (const auto& line : lines) {
+        if (line.find(text) != std::string::npos) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+TEST_SUITE("SlowQueryLog") {
+
+TEST_CASE("statements that write or take a credential are not read-only") {
+    CHECK_FALSE(Statements::GET_SESSION_USER.readOnly);
+    CHECK_FALSE(Statements::CREATE_SESSION.readOnly);
+    CHECK_FALSE(Statements::REHASH_PASSWORD.readOnly);
+    CHECK(Statements::GET_PROJECT_BOARD.readOnly);
+
+    for (const Statement* statement : Statements::all()) {
+        if (!statement->readOnly) {
+            continue;
+        }
+        std::string sql = statement->sql;
+        CAPTURE(statement->name);
+        CHECK(sql.rfind("SELECT ", 0) == 0);
+        CHECK(sql.find("INSERT ") == std::string::npos);
+        CHECK(sql.find("UPDATE ") == std::string::npos);
+        CHECK(sql.find("DELETE ") == std::string::npos);
+        CHECK(std::string(statement->name).rfind("get_", 0) == 0);
+    }
+}
+
+TEST_CASE("parameter values are only kept while explain is on") {
+    startLog(false);
+    CHECK_FALSE(SlowQueryLog::capturingParams());
+    SlowQueryLog::stop();
+
+    startLog(true);
+    CHECK(SlowQueryLog::capturingParams());
+    SlowQueryLog::stop();
+    CHECK_FALSE(SlowQueryLog::capturingParams());
+}
+
+TEST_CASE("fast queries are not logged") {
+    startLog(true);
+    uint64_t before = SlowQueryLog::stats().slowQueries;
+    SlowQueryLog::observe(&Statements::GET_PROJECT_BOARD, 1ms, 1, false, params({SECRET}));
+    CHECK(SlowQueryLog::stats().slowQueries == before);
+    CHECK(stopAndRead().empty());
+}
+
+TEST_CASE("a slow write is logged redacted and never explained") {
+    startLog(true);
+    SlowQueryLog::observe(&Statements::CREATE_SESSION, 50ms, 1, false, params({SECRET, SECRET}));
+    auto lines = stopAndRead();
+
+    REQUIRE(lines.size() == 1);
+    CHECK(mentions(lines, "slow query create_session:"));
+    CHECK(mentions(lines, "2 params (redacted)"));
+    CHECK_FALSE(mentions(lines, SECRET));
+    CHECK(explainLines(lines, "create_session").empty());
+}
+
+TEST_CASE("a slow read-only statement is explained without logging its values") {
+    startLog(true);
+    SlowQueryLog::observe(&Statements::GET_PROJECT_BOARD, 50ms, 1, false, params({SECRET}));
+    SlowQueryLog::observe(&Statements::GET_TASK_PROJECT, 50ms, 1, false, params({SECRET}), true);
+    auto lines = stopAndRead();
+
+    CHECK(mentions(lines, "slow query get_project_board:"));
+    CHECK_FALSE(explainLines(lines, "get_project_board").empty());
+    CHECK_FALSE(explainLines(lines, "get_task_project").empty());
+    CHECK_FALSE(mentions(lines, SECRET));
+}
+
+TEST_CASE("a slow read-only statement is not explained while explain is off") {
+    startLog(false);
+    SlowQueryLog::observe(&Statements::GET_PROJECT_BOARD, 50ms, 1, false, params({SECRET}));
+    auto lines = stopAndRead();
+
+    REQUIRE(lines.size() == 1);
+    CHECK(explainLines(lines, "get_project_board").empty());
+}
+
+} // TEST_SUITE
@@ -63,6 +63,141 @@ BEGIN
 END;
 $$ LANGUAGE plpgsql;
 
+-- Resolve a session to its user in one statement (session check + profile)
+CREATE OR REPLACE FUNCTION get_session_user(p_session_id VARCHAR(255))
+RETURNS TABLE(
+    id UUID,
+    email VARCHAR(255),
+    name VARCHAR(255),
+    avatar_url VARCHAR(500),
+    expires_at TIMESTAMP WITH TIME ZONE
+) AS $$
+BEGIN
+    RETURN QUERY
+    SELECT u.id, u.email, u.name, u.avatar_url, s.expires_at
+    FROM sessions s
+    JOIN users u ON u.id = s.user_id
+    WHERE s.id = p_session_id AND s.expires_at > NOW();
+END;
+$$ LANGUAGE plpgsql STABLE;
+
+-- Store a new session for 7 days. With the partitioned table
+-- (database/sessions_partitioned.sql) an expiry no partition covers yet,
+-- because the reaper fell behind, would fail the login: the missing daily
+-- partitions are created and the insert retried instead.
+CREATE OR REPLACE FUNCTION create_session(p_session_id VARCHAR(255), p_user_id UUID)
+RETURNS VOID AS $$
+BEGIN
+    BEGIN
+        INSERT INTO sessions (id, user_id, expires_at)
+        VALUES (p_session_id, p_user_id, NOW() + INTERVAL '7 days');
+        RETURN;
+    EXCEPTION WHEN check_violation THEN
+        -- "no partition of relation found for row"
+        PERFORM ensure_session_partitions(8);
+    END;
+
+    INSERT INTO sessions (id, user_id, expires_at)
+    VALUES (p_session_id, p_user_id, NOW() + INTERVAL '7 days');
+END;
+$$ LANGUAGE plpgsql;
+
+-- ============================================
+-- SESSION MAINTENANCE FUNCTIONS
+-- ============================================
+
+-- Delete at most p_batch_size expired sessions. The reaper calls this in a
+-- loop with pauses until it returns less than p_batch_size, so no single
+-- statement holds row locks or generates WAL for long.
+CREATE OR REPLACE FUNCTION cleanup_expired_sessions_batch(p_batch_size INTEGER)
+RETURNS INTEGER AS $$
+DECLARE
+    v_deleted INTEGER;
+BEGIN
+    DELETE FROM sessions
+    WHERE (id, expires_at) IN (
+        SELECT s.id, s.expires_at FROM sessions s
+        WHERE s.expires_at <= NOW()
+        ORDER BY s.expires_at
+        LIMIT p_batch_size
+        FOR UPDATE SKIP LOCKED
+    );
+    GET DIAGNOSTICS v_deleted = ROW_COUNT;
+    RETURN v_deleted;
+END;
+$$ LANGUAGE plpgsql;
+
+-- Same as above for revocations of signed tokens that have expired anyway
+CREATE OR REPLACE FUNCTION cleanup_revoked_sessions_batch(p_batch_size INTEGER)
+RETURNS INTEGER AS $$
+DECLARE
+    v_deleted INTEGER;
+BEGIN
+    DELETE FROM revoked_sessions
+    WHERE token_id IN (
+        SELECT r.token_id FROM revoked_sessions r
+        WHERE r.expires_at <= NOW()
+        LIMIT p_batch_size
+        FOR UPDATE SKIP LOCKED
+    );
+    GET DIAGNOSTICS v_deleted = ROW_COUNT;
+    RETURN v_deleted;
+END;
+$$ LANGUAGE plpgsql;
+
+-- Partitioned sessions only (database/sessions_partitioned.sql): create the
+-- daily partitions sessions_pYYYYMMDD from today through p_days_ahead days out.
+-- Safe to race with another caller (create_session, a second backend).
+CREATE OR REPLACE FUNCTION ensure_session_partitions(p_days_ahead INTEGER)
+RETURNS INTEGER AS $$
+DECLARE
+    v_day DATE;
+    v_name TEXT;
+    v_created INTEGER := 0;
+BEGIN
+    FOR v_day IN
+        SELECT d::date FROM generate_series(CURRENT_DATE, CURRENT_DATE + p_days_ahead, INTERVAL '1 day') d
+    LOOP
+        v_name := 'sessions_p' || to_char(v_day, 'YYYYMMDD');
+        IF to_regclass(v_name) IS NULL THEN
+            BEGIN
+                EXECUTE format(
+                    'CREATE TABLE %I PARTITION OF sessions FOR VALUES FROM (%L) TO (%L)',
+                    v_name, v_day::timestamptz, (v_day + 1)::timestamptz
+                );
+                v_created := v_created + 1;
+            EXCEPTION WHEN duplicate_table THEN
+                NULL;
+            END;
+        END IF;
+    END LOOP;
+    RETURN v_created;
+END;
+$$ LANGUAGE plpgsql;
+
+-- Partitioned sessions only: the daily partitions whose upper bound has
+-- passed, so all of their rows are expired. The reaper detaches each with
+-- DETACH PARTITION ... CONCURRENTLY and then drops it; a plain DROP TABLE
+-- would take ACCESS EXCLUSIVE on sessions and stall every session lookup.
+-- CONCURRENTLY cannot run inside a function (or any transaction block), so
+-- only the listing lives here. detach_pending marks a partition whose
+-- concurrent detach was interrupted and must be finished with FINALIZE.
+DROP FUNCTION IF EXISTS drop_expired_session_partitions();
+
+CREATE OR REPLACE FUNCTION expired_session_partitions()
+RETURNS TABLE(name TEXT, detach_pending BOOLEAN) AS $$
+BEGIN
+    RETURN QUERY
+    SELECT c.relname::text, i.inhdetachpending
+    FROM pg_inherits i
+    JOIN pg_class c ON c.oid = i.inhrelid
+    WHERE i.inhparent = 'sessions'::regclass
+      AND c.relname ~ '^sessions_p[0-9]{8}$'
+      AND (to_date(substr(c.relname, 11), 'YYYYMMDD') + 1)::timestamptz <= NOW()
+    ORDER BY c.relname;
+END;
+$$ LANGUAGE plpgsql STABLE;
+
 -- ============================================
 -- PROJECT FUNCTIONS
 -- ============================================
@@ -88,9 +223,9 @@ BEGIN
     VALUES (v_project_id, p_owner_id, 'owner');
 
     -- Create default columns
-    INSERT INTO columns (project_id, name, position, color) VALUES
+    INSERT INTO columns (project_id, name, rank, color) VALUES
         (v_project_id, 'To Do', 0, '#6366f1'),
-        (v_project_id, 'Done', 1, '#22c55e');
+        (v_project_id, 'Done', rank_step(), '#22c55e');
 
     -- Log activity
     INSERT INTO activity_log (project_id, user_id, action, entity_type, entity_id, details)
@@ -101,7 +236,7 @@ BEGIN
 END;
 $$ LANGUAGE plpgsql;
 
--- Get all projects for a user
+-- Get all projects for a user; the counts are the trigger-maintained counters
 CREATE OR REPLACE FUNCTION get_user_projects(p_user_id UUID)
 RETURNS TABLE(
     id UUID,
@@ -122,10 +257,8 @@ BEGIN
         p.icon,
         p.owner_id,
         p.created_at,
-        (SELECT COUNT(*) FROM tasks t
-         JOIN columns c ON t.column_id = c.id
-         WHERE c.project_id = p.id) as task_count,
-        (SELECT COUNT(*) FROM project_members pm WHERE pm.project_id = p.id) as member_count
+        p.task_count::BIGINT,
+        p.member_count::BIGINT
     FROM projects p
     JOIN project_members pm ON p.id = pm.project_id
     WHERE pm.user_id = p_user_id
@@ -171,6 +304,121 @@ $$ LANGUAGE plpgsql;
 -- COLUMN FUNCTIONS
 -- ============================================
 
+-- Columns within a project, and tasks within a column, are ordered by a
+-- sparse BIGINT rank. Reordering takes a rank between the new neighbours,
+-- so the moved row is the only one written and concurrent reorders on one
+-- board do not lock each other's rows; positions (0-based indexes) are
+-- derived on read. New ranks are rank_step() apart, which leaves room for
+-- 16 halvings at one spot before the ranks have to be renumbered.
+CREATE OR REPLACE FUNCTION rank_step()
+RETURNS BIGINT AS $$
+    SELECT 65536::BIGINT;
+$$ LANGUAGE sql IMMUTABLE;
+
+-- Spread a project's column ranks rank_step() apart again, keeping the
+-- order. Returns the number of columns whose rank changed.
+CREATE OR REPLACE FUNCTION renumber_column_ranks(p_project_id UUID)
+RETURNS INTEGER AS $$
+DECLARE
+    v_updated INTEGER;
+BEGIN
+    WITH ordered AS (
+        SELECT c.id, (ROW_NUMBER() OVER (ORDER BY c.rank, c.id) - 1) * rank_step() AS new_rank
+        FROM columns c WHERE c.project_id = p_project_id
+    )
+    UPDATE columns c SET rank = o.new_rank
+    FROM ordered o
+    WHERE c.id = o.id AND c.rank <> o.new_rank;
+    GET DIAGNOSTICS v_updated = ROW_COUNT;
+    RETURN v_updated;
+END;
+$$ LANGUAGE plpgsql;
+
+-- Rank for a column placed at p_index (0-based) among the project's other
+-- columns; the same rules as task_rank_at(), with projects queued in
+-- column_rank_rebalance.
+CREATE OR REPLACE FUNCTION column_rank_at(p_project_id UUID, p_index INTEGER, p_column_id UUID)
+RETURNS BIGINT AS $$
+DECLARE
+    v_index INTEGER := GREATEST(COALESCE(p_index, 0), 0);
+    v_neighbours BIGINT[];
+    v_before BIGINT;
+    v_after BIGINT;
+BEGIN
+    SELECT array_agg(n.rank ORDER BY n.rank, n.id) INTO v_neighbours
+    FROM (
+        SELECT c.rank, c.id FROM columns c
+        WHERE c.project_id = p_project_id AND c.id IS DISTINCT FROM p_column_id
+        ORDER BY c.rank, c.id
+        OFFSET GREATEST(v_index - 1, 0)
+        LIMIT 2
+    ) n;
+
+    IF v_index = 0 THEN
+        v_after := v_neighbours[1];
+    ELSIF v_neighbours IS NULL THEN
+        SELECT MAX(c.rank) INTO v_before FROM columns c
+        WHERE c.project_id = p_project_id AND c.id IS DISTINCT FROM p_column_id;
+    ELSE
+        v_before := v_neighbours[1];
+        v_after := v_neighbours[2];
+    END IF;
+
+    IF v_before IS NULL AND v_after IS NULL THEN
+        RETURN 0;
+    ELSIF v_before IS NULL THEN
+        RETURN v_after - rank_step();
+    ELSIF v_after IS NULL THEN
+        RETURN v_before + rank_step();
+    END IF;
+
+    IF v_after - v_before < 2 THEN
+        PERFORM renumber_column_ranks(p_project_id);
+        RETURN column_rank_at(p_project_id, p_index, p_column_id);
+    END IF;
+    IF v_after - v_before < 1024 THEN
+        INSERT INTO column_rank_rebalance (project_id) VALUES (p_project_id)
+        ON CONFLICT (project_id) DO NOTHING;
+    END IF;
+    RETURN v_before + (v_after - v_before) / 2;
+END;
+$$ LANGUAGE plpgsql;
+
+-- 0-based index of a column within its project
+CREATE OR REPLACE FUNCTION column_position(p_column_id UUID)
+RETURNS INTEGER AS $$
+    SELECT COUNT(*)::INTEGER
+    FROM columns c
+    JOIN columns o ON o.project_id = c.project_id AND (o.rank, o.id) < (c.rank, c.id)
+    WHERE c.id = p_column_id;
+$$ LANGUAGE sql STABLE;
+
+-- Renumber at most p_batch_size projects queued by column_rank_at(), oldest
+-- first. Called by the backend's rank rebalancer alongside
+-- rebalance_task_ranks(); returns the number of projects renumbered.
+CREATE OR REPLACE FUNCTION rebalance_column_ranks(p_batch_size INTEGER)
+RETURNS INTEGER AS $$
+DECLARE
+    v_project_id UUID;
+    v_projects INTEGER := 0;
+BEGIN
+    FOR v_project_id IN
+        DELETE FROM column_rank_rebalance
+        WHERE project_id IN (
+            SELECT q.project_id FROM column_rank_rebalance q
+            ORDER BY q.queued_at
+            LIMIT p_batch_size
+            FOR UPDATE SKIP LOCKED
+        )
+        RETURNING project_id
+    LOOP
+        PERFORM renumber_column_ranks(v_project_id);
+        v_projects := v_projects + 1;
+    END LOOP;
+    RETURN v_projects;
+END;
+$$ LANGUAGE plpgsql;
+
 -- Get columns for a project
 CREATE OR REPLACE FUNCTION get_project_columns(p_project_id UUID)
 RETURNS TABLE(
@@ -187,12 +435,12 @@ BEGIN
         c.id,
         c.project_id,
         c.name,
-        c."position",
+        (ROW_NUMBER() OVER (ORDER BY c.rank, c.id) - 1)::INTEGER,
         c.color,
-        (SELECT COUNT(*) FROM tasks t WHERE t.column_id = c.id) as task_count
+        c.task_count::BIGINT
     FROM columns c
     WHERE c.project_id = p_project_id
-    ORDER BY c."position" ASC;
+    ORDER BY c.rank ASC, c.id ASC;
 END;
 $$ LANGUAGE plpgsql;
 
@@ -211,17 +459,18 @@ RETURNS TABLE(
 ) AS $$
 DECLARE
     v_column_id UUID;
-    v_max_position INTEGER;
+    v_rank BIGINT;
 BEGIN
-    SELECT COALESCE(MAX(c."position"), -1) + 1 INTO v_max_position
+    -- Append: one step after the last rank
+    SELECT COALESCE(MAX(c.rank) + rank_step(), 0) INTO v_rank
     FROM columns c WHERE c.project_id = p_project_id;
 
-    INSERT INTO columns (project_id, name, position, color)
-    VALUES (p_project_id, p_name, v_max_position, COALESCE(p_color, '#6366f1'))
+    INSERT INTO columns (project_id, name, rank, color)
+    VALUES (p_project_id, p_name, v_rank, COALESCE(p_color, '#6366f1'))
     RETURNING columns.id INTO v_column_id;
 
     RETURN QUERY
-    SELECT c.id, c.project_id, c.name, c."position", c.color
+    SELECT c.id, c.project_id, c.name, column_position(c.id), c.color
     FROM columns c WHERE c.id = v_column_id;
 END;
 $$ LANGUAGE plpgsql;
@@ -245,17 +494,38 @@ BEGIN
     WHERE c.id = p_column_id;
 
     RETURN QUERY
-    SELECT c.id, c.name, c."position", c.color
+    SELECT c.id, c.name, column_position(c.id), c.color
     FROM columns c WHERE c.id = p_column_id;
 END;
 $$ LANGUAGE plpgsql;
 
+-- Move a column to p_new_position (0-based) among the project's other
+-- columns. Only the moved column's row is written.
+CREATE OR REPLACE FUNCTION move_column(p_column_id UUID, p_new_position INTEGER)
+RETURNS BOOLEAN AS $$
+DECLARE
+    v_project_id UUID;
+BEGIN
+    SELECT project_id INTO v_project_id FROM columns WHERE id = p_column_id;
+    IF v_project_id IS NULL THEN
+        RETURN FALSE;
+    END IF;
+
+    UPDATE columns
+    SET rank = column_rank_at(v_project_id, p_new_position, p_column_id)
+    WHERE id = p_column_id;
+
+    RETURN TRUE;
+END;
+$$ LANGUAGE plpgsql;
+
 -- Delete column and reassign tasks to first column
 CREATE OR REPLACE FUNCTION delete_column(p_column_id UUID)
 RETURNS BOOLEAN AS $$
 DECLARE
     v_project_id UUID;
     v_first_column_id UUID;
+    v_last_rank BIGINT;
 BEGIN
     SELECT project_id INTO v_project_id FROM columns WHERE id = p_column_id;
 
@@ -263,33 +533,167 @@ BEGIN
     SELECT id INTO v_first_column_id
     FROM columns
     WHERE project_id = v_project_id AND id != p_column_id
-    ORDER BY position ASC
+    ORDER BY rank ASC, id ASC
     LIMIT 1;
 
-    -- Move tasks to first column if one exists
+    -- Move tasks to first column if one exists, after its own tasks and in
+    -- their old order
     IF v_first_column_id IS NOT NULL THEN
-        UPDATE tasks SET column_id = v_first_column_id WHERE column_id = p_column_id;
+        SELECT COALESCE(MAX(t.rank), -rank_step()) INTO v_last_rank
+        FROM tasks t WHERE t.project_id = v_project_id AND t.column_id = v_first_column_id;
+
+        WITH moved AS (
+            SELECT t.id, ROW_NUMBER() OVER (ORDER BY t.rank, t.id) AS n
+            FROM tasks t WHERE t.project_id = v_project_id AND t.column_id = p_column_id
+        )
+        UPDATE tasks t
+        SET column_id = v_first_column_id, rank = v_last_rank + m.n * rank_step()
+        FROM moved m WHERE t.id = m.id;
     END IF;
 
+    -- The remaining columns keep their ranks; nothing is renumbered
     DELETE FROM columns WHERE id = p_column_id;
 
-    -- Reorder remaining columns
-    WITH ordered AS (
-        SELECT id, ROW_NUMBER() OVER (ORDER BY position) - 1 as new_pos
-        FROM columns WHERE project_id = v_project_id
-    )
-    UPDATE columns c SET position = o.new_pos
-    FROM ordered o WHERE c.id = o.id;
-
     RETURN TRUE;
 END;
 $$ LANGUAGE plpgsql;
 
+-- Project a column belongs to (authorization resolver)
+CREATE OR REPLACE FUNCTION get_column_project(p_column_id UUID)
+RETURNS TABLE(project_id UUID) AS $$
+BEGIN
+    RETURN QUERY
+    SELECT c.project_id FROM columns c WHERE c.id = p_column_id;
+END;
+$$ LANGUAGE plpgsql STABLE;
+
 -- ============================================
 -- TASK FUNCTIONS
 -- ============================================
 
--- Get all tasks for a project (grouped by column)
+-- Task order is a sparse BIGINT rank per column, kept like column ranks
+-- (see rank_step()): a created or moved task takes a rank between its new
+-- neighbours, so it is the only row written.
+--
+-- Tasks carry their column's project_id, so project-wide reads and the
+-- authorization lookup never join columns, and every task query leads with
+-- project_id to stay on idx_tasks_project_column_rank.
+
+-- Spread a column's ranks rank_step() apart again, keeping the order.
+-- Returns the number of tasks whose rank changed.
+CREATE OR REPLACE FUNCTION renumber_task_ranks(p_column_id UUID)
+RETURNS INTEGER AS $$
+DECLARE
+    v_project_id UUID;
+    v_updated INTEGER;
+BEGIN
+    SELECT c.project_id INTO v_project_id FROM columns c WHERE c.id = p_column_id;
+
+    WITH ordered AS (
+        SELECT t.id, (ROW_NUMBER() OVER (ORDER BY t.rank, t.id) - 1) * rank_step() AS new_rank
+        FROM tasks t WHERE t.project_id = v_project_id AND t.column_id = p_column_id
+    )
+    UPDATE tasks t SET rank = o.new_rank
+    FROM ordered o
+    WHERE t.id = o.id AND t.rank <> o.new_rank;
+    GET DIAGNOSTICS v_updated = ROW_COUNT;
+    RETURN v_updated;
+END;
+$$ LANGUAGE plpgsql;
+
+-- Rank for a task placed at p_index (0-based) among the other tasks of a
+-- column of project p_project_id; p_task_id is left out so a task can move
+-- within its own column.
+-- Only the two neighbours are read. An index past the end appends. A gap
+-- halved below 1024 queues the column for rebalance_task_ranks(); a gap
+-- with no room left at all is renumbered here first.
+CREATE OR REPLACE FUNCTION task_rank_at(p_project_id UUID, p_column_id UUID, p_index INTEGER, p_task_id UUID)
+RETURNS BIGINT AS $$
+DECLARE
+    v_index INTEGER := GREATEST(COALESCE(p_index, 0), 0);
+    v_neighbours BIGINT[];
+    v_before BIGINT;
+    v_after BIGINT;
+BEGIN
+    SELECT array_agg(n.rank ORDER BY n.rank, n.id) INTO v_neighbours
+    FROM (
+        SELECT t.rank, t.id FROM tasks t
+        WHERE t.project_id = p_project_id AND t.column_id = p_column_id
+          AND t.id IS DISTINCT FROM p_task_id
+        ORDER BY t.rank, t.id
+        OFFSET GREATEST(v_index - 1, 0)
+        LIMIT 2
+    ) n;
+
+    IF v_index = 0 THEN
+        v_after := v_neighbours[1];
+    ELSIF v_neighbours IS NULL THEN
+        SELECT MAX(t.rank) INTO v_before FROM tasks t
+        WHERE t.project_id = p_project_id AND t.column_id = p_column_id
+          AND t.id IS DISTINCT FROM p_task_id;
+    ELSE
+        v_before := v_neighbours[1];
+        v_after := v_neighbours[2];
+    END IF;
+
+    IF v_before IS NULL AND v_after IS NULL THEN
+        RETURN 0;
+    ELSIF v_before IS NULL THEN
+        RETURN v_after - rank_step();
+    ELSIF v_after IS NULL THEN
+        RETURN v_before + rank_step();
+    END IF;
+
+    IF v_after - v_before < 2 THEN
+        PERFORM renumber_task_ranks(p_column_id);
+        RETURN task_rank_at(p_project_id, p_column_id, p_index, p_task_id);
+    END IF;
+    IF v_after - v_before < 1024 THEN
+        INSERT INTO task_rank_rebalance (column_id) VALUES (p_column_id)
+        ON CONFLICT (column_id) DO NOTHING;
+    END IF;
+    RETURN v_before + (v_after - v_before) / 2;
+END;
+$$ LANGUAGE plpgsql;
+
+-- 0-based index of a task within its column
+CREATE OR REPLACE FUNCTION task_position(p_task_id UUID)
+RETURNS INTEGER AS $$
+    SELECT COUNT(*)::INTEGER
+    FROM tasks t
+    JOIN tasks o ON o.project_id = t.project_id AND o.column_id = t.column_id
+                AND (o.rank, o.id) < (t.rank, t.id)
+    WHERE t.id = p_task_id;
+$$ LANGUAGE sql STABLE;
+
+-- Renumber at most p_batch_size columns queued by task_rank_at(), oldest
+-- first. Called periodically by the backend's rank rebalancer; returns the
+-- number of columns renumbered.
+CREATE OR REPLACE FUNCTION rebalance_task_ranks(p_batch_size INTEGER)
+RETURNS INTEGER AS $$
+DECLARE
+    v_column_id UUID;
+    v_columns INTEGER := 0;
+BEGIN
+    FOR v_column_id IN
+        DELETE FROM task_rank_rebalance
+        WHERE column_id IN (
+            SELECT q.column_id FROM task_rank_rebalance q
+            ORDER BY q.queued_at
+            LIMIT p_batch_size
+            FOR UPDATE SKIP LOCKED
+        )
+        RETURNING column_id
+    LOOP
+        PERFORM renumber_task_ranks(v_column_id);
+        v_columns := v_columns + 1;
+    END LOOP;
+    RETURN v_columns;
+END;
+$$ LANGUAGE plpgsql;
+
+-- Get all tasks for a project (grouped by column): one range scan of the
+-- project's tasks, with the columns read only for their order
 CREATE OR REPLACE FUNCTION get_project_tasks(p_project_id UUID)
 RETURNS TABLE(
     id UUID,
@@ -314,7 +718,7 @@ BEGIN
         t.title,
         t.description,
         t.priority,
-        t."position",
+        (ROW_NUMBER() OVER (PARTITION BY t.column_id ORDER BY t.rank, t.id) - 1)::INTEGER,
         t.assignee_id,
         u.name as assignee_name,
         u.avatar_url as assignee_avatar,
@@ -323,14 +727,16 @@ BEGIN
         t.created_by,
         t.created_at
     FROM tasks t
-    JOIN columns c ON t.column_id = c.id
+    JOIN columns c ON c.id = t.column_id
     LEFT JOIN users u ON t.assignee_id = u.id
-    WHERE c.project_id = p_project_id
-    ORDER BY c."position" ASC, t."position" ASC;
+    WHERE t.project_id = p_project_id
+    ORDER BY c.rank ASC, c.id ASC, t.rank ASC, t.id ASC;
 END;
 $$ LANGUAGE plpgsql;
 
--- Create a new task
+-- Create a new task. The task writes below do not log activity: the
+-- backend queues each event and appends them in batches (utils::ActivityLog).
+-- Their user parameters are kept so the signatures stay stable.
 CREATE OR REPLACE FUNCTION create_task(
     p_column_id UUID,
     p_title VARCHAR(500),
@@ -355,28 +761,22 @@ RETURNS TABLE(
 ) AS $$
 DECLARE
     v_task_id UUID;
-    v_max_position INTEGER;
+    v_rank BIGINT;
     v_project_id UUID;
 BEGIN
-    -- Get max position
-    SELECT COALESCE(MAX(t."position"), -1) + 1 INTO v_max_position
-    FROM tasks t WHERE t.column_id = p_column_id;
-
-    -- Get project ID for activity log
     SELECT c.project_id INTO v_project_id FROM columns c WHERE c.id = p_column_id;
 
-    INSERT INTO tasks (column_id, title, description, priority, position, assignee_id, due_date, tags, created_by)
-    VALUES (p_column_id, p_title, p_description, COALESCE(p_priority, 'medium'), v_max_position,
+    -- Append: one step after the last rank
+    SELECT COALESCE(MAX(t.rank) + rank_step(), 0) INTO v_rank
+    FROM tasks t WHERE t.project_id = v_project_id AND t.column_id = p_column_id;
+
+    INSERT INTO tasks (column_id, project_id, title, description, priority, rank, assignee_id, due_date, tags, created_by)
+    VALUES (p_column_id, v_project_id, p_title, p_description, COALESCE(p_priority, 'medium'), v_rank,
             p_assignee_id, p_due_date, p_tags, p_created_by)
     RETURNING tasks.id INTO v_task_id;
 
-    -- Log activity
-    INSERT INTO activity_log (project_id, user_id, action, entity_type, entity_id, details)
-    VALUES (v_project_id, p_created_by, 'created', 'task', v_task_id,
-            jsonb_build_object('title', p_title));
-
     RETURN QUERY
-    SELECT t.id, t.column_id, t.title, t.description, t.priority, t."position",
+    SELECT t.id, t.column_id, t.title, t.description, t.priority, task_position(t.id),
            t.assignee_id, t.due_date, t.tags, t.created_at
     FROM tasks t WHERE t.id = v_task_id;
 END;
@@ -405,14 +805,7 @@ RETURNS TABLE(
     tags JSONB,
     created_at TIMESTAMP WITH TIME ZONE
 ) AS $$
-DECLARE
-    v_project_id UUID;
 BEGIN
-    -- Get project ID
-    SELECT c.project_id INTO v_project_id
-    FROM tasks t JOIN columns c ON t.column_id = c.id
-    WHERE t.id = p_task_id;
-
     UPDATE tasks t
     SET title = COALESCE(p_title, t.title),
         description = COALESCE(p_description, t.description),
@@ -422,19 +815,15 @@ BEGIN
         tags = COALESCE(p_tags, t.tags)
     WHERE t.id = p_task_id;
 
-    -- Log activity
-    INSERT INTO activity_log (project_id, user_id, action, entity_type, entity_id, details)
-    VALUES (v_project_id, p_user_id, 'updated', 'task', p_task_id,
-            jsonb_build_object('title', p_title));
-
     RETURN QUERY
-    SELECT t.id, t.column_id, t.title, t.description, t.priority, t."position",
+    SELECT t.id, t.column_id, t.title, t.description, t.priority, task_position(t.id),
            t.assignee_id, t.due_date, t.tags, t.created_at
     FROM tasks t WHERE t.id = p_task_id;
 END;
 $$ LANGUAGE plpgsql;
 
--- Move task to different column
+-- Move a task to p_new_position (0-based) in a column, which may be its
+-- own. Only the moved task's row is written (see task_rank_at).
 CREATE OR REPLACE FUNCTION move_task(
     p_task_id UUID,
     p_new_column_id UUID,
@@ -443,37 +832,28 @@ CREATE OR REPLACE FUNCTION move_task(
 )
 RETURNS BOOLEAN AS $$
 DECLARE
-    v_old_column_id UUID;
     v_project_id UUID;
-    v_column_name VARCHAR(255);
+    v_rank BIGINT;
 BEGIN
-    SELECT column_id INTO v_old_column_id FROM tasks WHERE id = p_task_id;
-    SELECT project_id INTO v_project_id FROM columns WHERE id = p_new_column_id;
-    SELECT name INTO v_column_name FROM columns WHERE id = p_new_column_id;
+    -- Tasks stay in their project: a column of another project is refused
+    -- (FALSE), so a task's project never changes once it is created and the
+    -- authorization resolver may cache it
+    SELECT c.project_id INTO v_project_id
+    FROM tasks t
+    JOIN columns c ON c.id = p_new_column_id AND c.project_id = t.project_id
+    WHERE t.id = p_task_id;
 
-    -- Shift tasks in new column to make room
-    UPDATE tasks
-    SET position = position + 1
-    WHERE column_id = p_new_column_id AND position >= p_new_position;
+    IF NOT FOUND THEN
+        RETURN FALSE;
+    END IF;
+
+    -- Computed first: it may renumber the column, moved task included
+    v_rank := task_rank_at(v_project_id, p_new_column_id, p_new_position, p_task_id);
 
-    -- Move the task
     UPDATE tasks
-    SET column_id = p_new_column_id, position = p_new_position
+    SET column_id = p_new_column_id, rank = v_rank
     WHERE id = p_task_id;
 
-    -- Reorder old column
-    WITH ordered AS (
-        SELECT id, ROW_NUMBER() OVER (ORDER BY position) - 1 as new_pos
-        FROM tasks WHERE column_id = v_old_column_id
-    )
-    UPDATE tasks t SET position = o.new_pos
-    FROM ordered o WHERE t.id = o.id;
-
-    -- Log activity
-    INSERT INTO activity_log (project_id, user_id, action, entity_type, entity_id, details)
-    VALUES (v_project_id, p_user_id, 'moved', 'task', p_task_id,
-            jsonb_build_object('column', v_column_name));
-
     RETURN TRUE;
 END;
 $$ LANGUAGE plpgsql;
@@ -481,33 +861,23 @@ $$ LANGUAGE plpgsql;
 -- Delete task
 CREATE OR REPLACE FUNCTION delete_task(p_task_id UUID, p_user_id UUID)
 RETURNS BOOLEAN AS $$
-DECLARE
-    v_column_id UUID;
-    v_project_id UUID;
-    v_title VARCHAR(500);
 BEGIN
-    SELECT column_id, title INTO v_column_id, v_title FROM tasks WHERE id = p_task_id;
-    SELECT project_id INTO v_project_id FROM columns WHERE id = v_column_id;
-
+    -- The remaining ranks keep their order; nothing is renumbered
     DELETE FROM tasks WHERE id = p_task_id;
 
-    -- Reorder remaining tasks
-    WITH ordered AS (
-        SELECT id, ROW_NUMBER() OVER (ORDER BY position) - 1 as new_pos
-        FROM tasks WHERE column_id = v_column_id
-    )
-    UPDATE tasks t SET position = o.new_pos
-    FROM ordered o WHERE t.id = o.id;
-
-    -- Log activity
-    INSERT INTO activity_log (project_id, user_id, action, entity_type, entity_id, details)
-    VALUES (v_project_id, p_user_id, 'deleted', 'task', p_task_id,
-            jsonb_build_object('title', v_title));
-
     RETURN TRUE;
 END;
 $$ LANGUAGE plpgsql;
 
+-- Project a task belongs to (authorization resolver): one primary key probe
+CREATE OR REPLACE FUNCTION get_task_project(p_task_id UUID)
+RETURNS TABLE(project_id UUID) AS $$
+BEGIN
+    RETURN QUERY
+    SELECT t.project_id FROM tasks t WHERE t.id = p_task_id;
+END;
+$$ LANGUAGE plpgsql STABLE;
+
 -- ============================================
 -- PROJECT MEMBER FUNCTIONS
 -- ============================================
@@ -540,6 +910,90 @@ BEGIN
 END;
 $$ LANGUAGE plpgsql;
 
+-- Whole project board as one JSON document, shaped like the
+-- GET /api/projects/{id} response: the project, its columns in order with
+-- their tasks nested in order, and its members. NULL fields of columns,
+-- tasks and members are left out; timestamps are rendered as text, like
+-- the row-returning functions above. NULL if the project does not exist.
+CREATE OR REPLACE FUNCTION get_project_board(p_project_id UUID)
+RETURNS JSON AS $$
+    SELECT json_build_object(
+        'project', json_build_object(
+            'id', p.id,
+            'name', p.name,
+            'description', p.description,
+            'icon', p.icon,
+            'owner_id', p.owner_id,
+            'created_at', p.created_at::text
+        ),
+        'columns', COALESCE((
+            SELECT json_agg(json_strip_nulls(json_build_object(
+                'id', c.id,
+                'project_id', c.project_id,
+                'name', c.name,
+                'color', c.color,
+                'position', c.column_position,
+                'task_count', ct.task_count,
+                'tasks', ct.tasks
+            )) ORDER BY c.column_position)
+            FROM (
+                SELECT ranked.*, ROW_NUMBER() OVER (ORDER BY ranked.rank, ranked.id) - 1 AS column_position
+                FROM columns ranked
+                WHERE ranked.project_id = p.id
+            ) c
+            CROSS JOIN LATERAL (
+                SELECT
+                    COUNT(*) AS task_count,
+                    COALESCE(json_agg(json_build_object(
+                        'id', t.id,
+                        'column_id', t.column_id,
+                        'title', t.title,
+                        'description', t.description,
+                        'priority', t.priority,
+                        'position', t.task_position,
+                        'assignee_id', t.assignee_id,
+                        'assignee_name', u.name,
+                        'due_date', t.due_date::text,
+                        'tags', t.tags,
+                        'created_at', t.created_at::text
+                    ) ORDER BY t.task_position), '[]'::json) AS tasks
+                FROM (
+                    SELECT ranked.*, ROW_NUMBER() OVER (ORDER BY ranked.rank, ranked.id) - 1 AS task_position
+                    FROM tasks ranked
+                    WHERE ranked.project_id = p.id AND ranked.column_id = c.id
+                ) t
+                LEFT JOIN users u ON t.assignee_id = u.id
+            ) ct
+        ), '[]'::json),
+        'members', COALESCE((
+            SELECT json_agg(json_strip_nulls(json_build_object(
+                'id', pm.id,
+                'user_id', pm.user_id,
+                'name', u.name,
+                'email', u.email,
+                'role', pm.role,
+                'avatar_url', u.avatar_url
+            )) ORDER BY pm.joined_at)
+            FROM project_members pm
+            JOIN users u ON pm.user_id = u.id
+            WHERE pm.project_id = p.id
+        ), '[]'::json)
+    )
+    FROM projects p
+    WHERE p.id = p_project_id;
+$$ LANGUAGE sql STABLE;
+
+-- Every project a user belongs to with their role (authorization cache)
+CREATE OR REPLACE FUNCTION get_user_memberships(p_user_id UUID)
+RETURNS TABLE(project_id UUID, role VARCHAR(50)) AS $$
+BEGIN
+    RETURN QUERY
+    SELECT pm.project_id, pm.role
+    FROM project_members pm
+    WHERE pm.user_id = p_user_id;
+END;
+$$ LANGUAGE plpgsql STABLE;
+
 -- Add project member
 CREATE OR REPLACE FUNCTION add_project_member(
     p_project_id UUID,
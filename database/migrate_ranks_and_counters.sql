@@ -0,0 +1,253 @@
+-- Upgrade a database created from an earlier schema.sql (integer position
+-- ordering, tasks without project_id, no counters) to the current schema.
+-- Run once, then re-apply functions.sql:
+--
+--   psql -f database/migrate_ranks_and_counters.sql
+--   psql -f database/functions.sql
+--
+-- Ranks keep the old order (position, then creation time), rank_step()
+-- (65536) apart. The updated_at triggers are disabled while rows are
+-- backfilled so no column, task or project looks edited. Tasks, columns and
+-- projects are locked for the whole migration.
+
+BEGIN;
+
+-- Keep the counts exact: no member changes until the triggers exist
+LOCK TABLE project_members IN SHARE MODE;
+
+ALTER TABLE projects DISABLE TRIGGER update_projects_updated_at;
+ALTER TABLE columns DISABLE TRIGGER update_columns_updated_at;
+ALTER TABLE tasks DISABLE TRIGGER update_tasks_updated_at;
+
+-- ============================================
+-- COLUMN ORDER: position -> sparse rank
+-- ============================================
+
+ALTER TABLE columns ADD COLUMN rank BIGINT NOT NULL DEFAULT 0;
+
+UPDATE columns c SET rank = o.new_rank
+FROM (
+    SELECT id, (ROW_NUMBER() OVER (PARTITION BY project_id ORDER BY position, created_at, id) - 1) * 65536 AS new_rank
+    FROM columns
+) o
+WHERE c.id = o.id;
+
+ALTER TABLE columns DROP COLUMN position;
+ALTER TABLE columns ADD CONSTRAINT columns_id_project_id_key UNIQUE (id, project_id);
+
+DROP INDEX IF EXISTS idx_columns_project_id;
+CREATE INDEX idx_columns_project_rank ON columns(project_id, rank);
+
+-- ============================================
+-- TASKS: project_id and sparse rank
+-- ============================================
+
+ALTER TABLE tasks ADD COLUMN project_id UUID;
+ALTER TABLE tasks ADD COLUMN rank BIGINT NOT NULL DEFAULT 0;
+
+UPDATE tasks t SET project_id = c.project_id, rank = o.new_rank
+FROM columns c, (
+    SELECT id, (ROW_NUMBER() OVER (PARTITION BY column_id ORDER BY position, created_at, id) - 1) * 65536 AS new_rank
+    FROM tasks
+) o
+WHERE c.id = t.column_id AND o.id = t.id;
+
+ALTER TABLE tasks ALTER COLUMN project_id SET NOT NULL;
+ALTER TABLE tasks DROP COLUMN position;
+
+-- A task can only name its column's own project
+ALTER TABLE tasks DROP CONSTRAINT tasks_column_id_fkey;
+ALTER TABLE tasks ADD CONSTRAINT tasks_column_id_project_id_fkey
+    FOREIGN KEY (column_id, project_id) REFERENCES columns(id, project_id) ON DELETE CASCADE;
+
+DROP INDEX IF EXISTS idx_tasks_column_id;
+CREATE INDEX idx_tasks_project_column_rank ON tasks(project_id, column_id, rank);
+
+-- Rank renumbering queues (see rebalance_task_ranks / rebalance_column_ranks)
+CREATE TABLE task_rank_rebalance (
+    column_id UUID PRIMARY KEY REFERENCES columns(id) ON DELETE CASCADE,
+    queued_at TIMESTAMP WITH TIME ZONE DEFAULT NOW()
+);
+
+CREATE TABLE column_rank_rebalance (
+    project_id UUID PRIMARY KEY REFERENCES projects(id) ON DELETE CASCADE,
+    queued_at TIMESTAMP WITH TIME ZONE DEFAULT NOW()
+);
+
+-- ============================================
+-- COUNTERS
+-- ============================================
+
+ALTER TABLE projects ADD COLUMN task_count INTEGER NOT NULL DEFAULT 0;
+ALTER TABLE projects ADD COLUMN member_count INTEGER NOT NULL DEFAULT 0;
+ALTER TABLE columns ADD COLUMN task_count INTEGER NOT NULL DEFAULT 0;
+
+UPDATE columns c SET task_count = n.tasks
+FROM (SELECT column_id, COUNT(*)::INTEGER AS tasks FROM tasks GROUP BY column_id) n
+WHERE c.id = n.column_id;
+
+UPDATE projects p SET task_count = n.tasks
+FROM (SELECT project_id, COUNT(*)::INTEGER AS tasks FROM tasks GROUP BY project_id) n
+WHERE p.id = n.project_id;
+
+UPDATE projects p SET member_count = n.members
+FROM (SELECT project_id, COUNT(*)::INTEGER AS members FROM project_members GROUP BY project_id) n
+WHERE p.id = n.project_id;
+
+-- Triggers and functions as in schema.sql
+CREATE OR REPLACE FUNCTION adjust_task_counts(p_column_ids UUID[], p_project_ids UUID[], p_deltas INTEGER[])
+RETURNS VOID AS $$
+DECLARE
+    r RECORD;
+BEGIN
+    FOR r IN
+        SELECT d.column_id AS id, SUM(d.delta)::INTEGER AS delta
+        FROM unnest(p_column_ids, p_deltas) AS d(column_id, delta)
+        GROUP BY d.column_id
+        HAVING SUM(d.delta) <> 0
+        ORDER BY d.column_id
+    LOOP
+        UPDATE columns SET task_count = task_count + r.delta WHERE id = r.id;
+    END LOOP;
+
+    FOR r IN
+        SELECT d.project_id AS id, SUM(d.delta)::INTEGER AS delta
+        FROM unnest(p_project_ids, p_deltas) AS d(project_id, delta)
+        GROUP BY d.project_id
+        HAVING SUM(d.delta) <> 0
+        ORDER BY d.project_id
+    LOOP
+        UPDATE projects SET task_count = task_count + r.delta WHERE id = r.id;
+    END LOOP;
+END;
+$$ LANGUAGE plpgsql;
+
+CREATE OR REPLACE FUNCTION count_tasks()
+RETURNS TRIGGER AS $$
+DECLARE
+    v_column_ids UUID[];
+    v_project_ids UUID[];
+    v_deltas INTEGER[];
+BEGIN
+    IF TG_OP = 'INSERT' THEN
+        SELECT array_agg(d.column_id), array_agg(d.project_id), array_agg(d.delta)
+        INTO v_column_ids, v_project_ids, v_deltas
+        FROM (
+            SELECT n.column_id, n.project_id, COUNT(*)::INTEGER AS delta
+            FROM new_tasks n GROUP BY n.column_id, n.project_id
+        ) d;
+    ELSIF TG_OP = 'DELETE' THEN
+        SELECT array_agg(d.column_id), array_agg(d.project_id), array_agg(d.delta)
+        INTO v_column_ids, v_project_ids, v_deltas
+        FROM (
+            SELECT o.column_id, o.project_id, -COUNT(*)::INTEGER AS delta
+            FROM old_tasks o GROUP BY o.column_id, o.project_id
+        ) d;
+    ELSE
+        -- Only tasks that changed column move a counter
+        SELECT array_agg(d.column_id), array_agg(d.project_id), array_agg(d.delta)
+        INTO v_column_ids, v_project_ids, v_deltas
+        FROM (
+            SELECT o.column_id, o.project_id, -1 AS delta
+            FROM old_tasks o JOIN new_tasks n ON n.id = o.id
+            WHERE n.column_id <> o.column_id
+            UNION ALL
+            SELECT n.column_id, n.project_id, 1 AS delta
+            FROM old_tasks o JOIN new_tasks n ON n.id = o.id
+            WHERE n.column_id <> o.column_id
+        ) d;
+    END IF;
+
+    IF v_column_ids IS NOT NULL THEN
+        PERFORM adjust_task_counts(v_column_ids, v_project_ids, v_deltas);
+    END IF;
+    RETURN NULL;
+END;
+$$ LANGUAGE plpgsql;
+
+CREATE TRIGGER count_inserted_tasks AFTER INSERT ON tasks
+    REFERENCING NEW TABLE AS new_tasks
+    FOR EACH STATEMENT EXECUTE FUNCTION count_tasks();
+
+CREATE TRIGGER count_moved_tasks AFTER UPDATE ON tasks
+    REFERENCING OLD TABLE AS old_tasks NEW TABLE AS new_tasks
+    FOR EACH STATEMENT EXECUTE FUNCTION count_tasks();
+
+CREATE TRIGGER count_deleted_tasks AFTER DELETE ON tasks
+    REFERENCING OLD TABLE AS old_tasks
+    FOR EACH STATEMENT EXECUTE FUNCTION count_tasks();
+
+CREATE OR REPLACE FUNCTION count_members()
+RETURNS TRIGGER AS $$
+DECLARE
+    v_project_ids UUID[];
+    v_deltas INTEGER[];
+    i INTEGER;
+BEGIN
+    -- Each branch names only the transition table its trigger declares
+    IF TG_OP = 'INSERT' THEN
+        SELECT array_agg(d.project_id ORDER BY d.project_id), array_agg(d.delta ORDER BY d.project_id)
+        INTO v_project_ids, v_deltas
+        FROM (SELECT n.project_id, COUNT(*)::INTEGER AS delta FROM new_members n GROUP BY n.project_id) d;
+    ELSE
+        SELECT array_agg(d.project_id ORDER BY d.project_id), array_agg(d.delta ORDER BY d.project_id)
+        INTO v_project_ids, v_deltas
+        FROM (SELECT o.project_id, -COUNT(*)::INTEGER AS delta FROM old_members o GROUP BY o.project_id) d;
+    END IF;
+
+    FOR i IN 1 .. COALESCE(array_length(v_project_ids, 1), 0) LOOP
+        UPDATE projects SET member_count = member_count + v_deltas[i] WHERE id = v_project_ids[i];
+    END LOOP;
+    RETURN NULL;
+END;
+$$ LANGUAGE plpgsql;
+
+CREATE TRIGGER count_added_members AFTER INSERT ON project_members
+    REFERENCING NEW TABLE AS new_members
+    FOR EACH STATEMENT EXECUTE FUNCTION count_members();
+
+CREATE TRIGGER count_removed_members AFTER DELETE ON project_members
+    REFERENCING OLD TABLE AS old_members
+    FOR EACH STATEMENT EXECUTE FUNCTION count_members();
+
+-- ============================================
+-- SESSIONS
+-- ============================================
+
+-- Revoked signed session tokens (SESSION_MODE=signed)
+CREATE TABLE revoked_sessions (
+    token_id CHAR(32) PRIMARY KEY,
+    expires_at TIMESTAMP WITH TIME ZONE NOT NULL,
+    revoked_at TIMESTAMP WITH TIME ZONE NOT NULL DEFAULT NOW()
+);
+
+CREATE INDEX idx_revoked_sessions_revoked_at ON revoked_sessions(revoked_at);
+
+CREATE OR REPLACE FUNCTION cleanup_expired_sessions()
+RETURNS INTEGER AS $$
+DECLARE
+  deleted_count INTEGER;
+BEGIN
+  DELETE FROM sessions WHERE expires_at <= NOW();
+  GET DIAGNOSTICS deleted_count = ROW_COUNT;
+  DELETE FROM revoked_sessions WHERE expires_at <= NOW();
+  RETURN deleted_count;
+END;
+$$ LANGUAGE plpgsql;
+
+-- Re-created as in schema.sql: counter updates are not edits
+DROP TRIGGER update_projects_updated_at ON projects;
+CREATE TRIGGER update_projects_updated_at BEFORE UPDATE ON projects
+    FOR EACH ROW
+    WHEN (OLD.task_count = NEW.task_count AND OLD.member_count = NEW.member_count)
+    EXECUTE FUNCTION update_updated_at_column();
+
+DROP TRIGGER update_columns_updated_at ON columns;
+CREATE TRIGGER update_columns_updated_at BEFORE UPDATE ON columns
+    FOR EACH ROW
+    WHEN (OLD.task_count = NEW.task_count)
+    EXECUTE FUNCTION update_updated_at_column();
+
+ALTER TABLE tasks ENABLE TRIGGER update_tasks_updated_at;
+
+COMMIT;
@@ -0,0 +1,5 @@
+#!/bin/bash
+# Lets the local replica (docker-compose.replica.yml) stream WAL from this
+# primary. Runs once, when the primary's data directory is initialised.
+set -e
+echo "host replication all all scram-sha-256" >> "$PGDATA/pg_hba.conf"
@@ -30,6 +30,8 @@ CREATE TABLE projects (
     description TEXT,
     icon VARCHAR(50) DEFAULT '📋',
     owner_id UUID NOT NULL REFERENCES users(id) ON DELETE CASCADE,
+    task_count INTEGER NOT NULL DEFAULT 0,   -- maintained by count_tasks()
+    member_count INTEGER NOT NULL DEFAULT 0, -- maintained by count_members()
     created_at TIMESTAMP WITH TIME ZONE DEFAULT NOW(),
     updated_at TIMESTAMP WITH TIME ZONE DEFAULT NOW()
 );
@@ -49,26 +51,31 @@ CREATE TABLE columns (
     id UUID PRIMARY KEY DEFAULT uuid_generate_v4(),
     project_id UUID NOT NULL REFERENCES projects(id) ON DELETE CASCADE,
     name VARCHAR(255) NOT NULL,
-    position INTEGER NOT NULL DEFAULT 0,
+    rank BIGINT NOT NULL DEFAULT 0, -- sparse order within the project (see column_rank_at)
     color VARCHAR(50) DEFAULT '#6366f1',
+    task_count INTEGER NOT NULL DEFAULT 0, -- maintained by count_tasks()
     created_at TIMESTAMP WITH TIME ZONE DEFAULT NOW(),
-    updated_at TIMESTAMP WITH TIME ZONE DEFAULT NOW()
+    updated_at TIMESTAMP WITH TIME ZONE DEFAULT NOW(),
+    UNIQUE (id, project_id) -- target of the tasks foreign key
 );
 
 -- Tasks table
 CREATE TABLE tasks (
     id UUID PRIMARY KEY DEFAULT uuid_generate_v4(),
-    column_id UUID NOT NULL REFERENCES columns(id) ON DELETE CASCADE,
+    column_id UUID NOT NULL,
+    project_id UUID NOT NULL, -- the column's project, so project reads skip columns
     title VARCHAR(500) NOT NULL,
     description TEXT,
     priority VARCHAR(20) DEFAULT 'medium', -- low, medium, high
-    position INTEGER NOT NULL DEFAULT 0,
+    rank BIGINT NOT NULL DEFAULT 0, -- sparse order within the column (see task_rank_at)
     assignee_id UUID REFERENCES users(id) ON DELETE SET NULL,
     due_date TIMESTAMP WITH TIME ZONE,
     tags JSONB DEFAULT '[]'::jsonb, -- JSON array of tags
     created_by UUID REFERENCES users(id) ON DELETE SET NULL,
     created_at TIMESTAMP WITH TIME ZONE DEFAULT NOW(),
-    updated_at TIMESTAMP WITH TIME ZONE DEFAULT NOW()
+    updated_at TIMESTAMP WITH TIME ZONE DEFAULT NOW(),
+    -- A task can only name its column's own project
+    FOREIGN KEY (column_id, project_id) REFERENCES columns(id, project_id) ON DELETE CASCADE
 );
 
 -- Task comments
@@ -92,6 +99,30 @@ CREATE TABLE sessions (
 CREATE INDEX idx_sessions_user_id ON sessions(user_id);
 CREATE INDEX idx_sessions_expires_at ON sessions(expires_at);
 
+-- Revoked signed session tokens (SESSION_MODE=signed); rows are only needed
+-- until the token they revoke expires
+CREATE TABLE revoked_sessions (
+    token_id CHAR(32) PRIMARY KEY,
+    expires_at TIMESTAMP WITH TIME ZONE NOT NULL,
+    revoked_at TIMESTAMP WITH TIME ZONE NOT NULL DEFAULT NOW()
+);
+
+CREATE INDEX idx_revoked_sessions_revoked_at ON revoked_sessions(revoked_at);
+
+-- Columns whose task ranks ran out of room between neighbours, renumbered
+-- in the background by rebalance_task_ranks()
+CREATE TABLE task_rank_rebalance (
+    column_id UUID PRIMARY KEY REFERENCES columns(id) ON DELETE CASCADE,
+    queued_at TIMESTAMP WITH TIME ZONE DEFAULT NOW()
+);
+
+-- Projects whose column ranks ran out of room between neighbours,
+-- renumbered in the background by rebalance_column_ranks()
+CREATE TABLE column_rank_rebalance (
+    project_id UUID PRIMARY KEY REFERENCES projects(id) ON DELETE CASCADE,
+    queued_at TIMESTAMP WITH TIME ZONE DEFAULT NOW()
+);
+
 -- Activity log
 CREATE TABLE activity_log (
     id UUID PRIMARY KEY DEFAULT uuid_generate_v4(),
@@ -105,9 +136,11 @@ CREATE TABLE activity_log (
 );
 
 -- Indexes for performance
-CREATE INDEX idx_tasks_column_id ON tasks(column_id);
+-- Serves board loads (one range scan per project), per-column rank
+-- lookups and the cascade from columns
+CREATE INDEX idx_tasks_project_column_rank ON tasks(project_id, column_id, rank);
 CREATE INDEX idx_tasks_assignee_id ON tasks(assignee_id);
-CREATE INDEX idx_columns_project_id ON columns(project_id);
+CREATE INDEX idx_columns_project_rank ON columns(project_id, rank);
 CREATE INDEX idx_project_members_project_id ON project_members(project_id);
 CREATE INDEX idx_project_members_user_id ON project_members(user_id);
 CREATE INDEX idx_activity_log_project_id ON activity_log(project_id);
@@ -136,6 +169,7 @@ DECLARE
 BEGIN
   DELETE FROM sessions WHERE expires_at <= NOW();
   GET DIAGNOSTICS deleted_count = ROW_COUNT;
+  DELETE FROM revoked_sessions WHERE expires_at <= NOW();
   RETURN deleted_count;
 END;
 $$ LANGUAGE plpgsql;
@@ -153,14 +187,148 @@ $$ LANGUAGE plpgsql;
 CREATE TRIGGER update_users_updated_at BEFORE UPDATE ON users
     FOR EACH ROW EXECUTE FUNCTION update_updated_at_column();
 
+-- Counter updates (see COUNTERS) change nothing else and are not edits
 CREATE TRIGGER update_projects_updated_at BEFORE UPDATE ON projects
-    FOR EACH ROW EXECUTE FUNCTION update_updated_at_column();
+    FOR EACH ROW
+    WHEN (OLD.task_count = NEW.task_count AND OLD.member_count = NEW.member_count)
+    EXECUTE FUNCTION update_updated_at_column();
 
 CREATE TRIGGER update_columns_updated_at BEFORE UPDATE ON columns
-    FOR EACH ROW EXECUTE FUNCTION update_updated_at_column();
+    FOR EACH ROW
+    WHEN (OLD.task_count = NEW.task_count)
+    EXECUTE FUNCTION update_updated_at_column();
 
 CREATE TRIGGER update_tasks_updated_at BEFORE UPDATE ON tasks
     FOR EACH ROW EXECUTE FUNCTION update_updated_at_column();
 
 CREATE TRIGGER update_task_comments_updated_at BEFORE UPDATE ON task_comments
     FOR EACH ROW EXECUTE FUNCTION update_updated_at_column();
+
+-- ============================================
+-- COUNTERS
+-- ============================================
+-- columns.task_count, projects.task_count and projects.member_count are
+-- kept exact by statement-level triggers, so listing projects or columns
+-- never counts tasks. Each statement adjusts each affected counter once.
+-- Counter rows are updated columns first, then projects, each in id order,
+-- so concurrent statements touching the same counters queue rather than
+-- deadlock; the row locks taken are the same FOR NO KEY UPDATE locks any
+-- update takes, which do not block foreign key checks on those rows.
+
+-- Add p_deltas[i] tasks to column p_column_ids[i] and to project
+-- p_project_ids[i]. A column or project deleted in the same statement (a
+-- cascade) simply has no row left to update.
+CREATE OR REPLACE FUNCTION adjust_task_counts(p_column_ids UUID[], p_project_ids UUID[], p_deltas INTEGER[])
+RETURNS VOID AS $$
+DECLARE
+    r RECORD;
+BEGIN
+    FOR r IN
+        SELECT d.column_id AS id, SUM(d.delta)::INTEGER AS delta
+        FROM unnest(p_column_ids, p_deltas) AS d(column_id, delta)
+        GROUP BY d.column_id
+        HAVING SUM(d.delta) <> 0
+        ORDER BY d.column_id
+    LOOP
+        UPDATE columns SET task_count = task_count + r.delta WHERE id = r.id;
+    END LOOP;
+
+    FOR r IN
+        SELECT d.project_id AS id, SUM(d.delta)::INTEGER AS delta
+        FROM unnest(p_project_ids, p_deltas) AS d(project_id, delta)
+        GROUP BY d.project_id
+        HAVING SUM(d.delta) <> 0
+        ORDER BY d.project_id
+    LOOP
+        UPDATE projects SET task_count = task_count + r.delta WHERE id = r.id;
+    END LOOP;
+END;
+$$ LANGUAGE plpgsql;
+
+CREATE OR REPLACE FUNCTION count_tasks()
+RETURNS TRIGGER AS $$
+DECLARE
+    v_column_ids UUID[];
+    v_project_ids UUID[];
+    v_deltas INTEGER[];
+BEGIN
+    IF TG_OP = 'INSERT' THEN
+        SELECT array_agg(d.column_id), array_agg(d.project_id), array_agg(d.delta)
+        INTO v_column_ids, v_project_ids, v_deltas
+        FROM (
+            SELECT n.column_id, n.project_id, COUNT(*)::INTEGER AS delta
+            FROM new_tasks n GROUP BY n.column_id, n.project_id
+        ) d;
+    ELSIF TG_OP = 'DELETE' THEN
+        SELECT array_agg(d.column_id), array_agg(d.project_id), array_agg(d.delta)
+        INTO v_column_ids, v_project_ids, v_deltas
+        FROM (
+            SELECT o.column_id, o.project_id, -COUNT(*)::INTEGER AS delta
+            FROM old_tasks o GROUP BY o.column_id, o.project_id
+        ) d;
+    ELSE
+        -- Only tasks that changed column move a counter
+        SELECT array_agg(d.column_id), array_agg(d.project_id), array_agg(d.delta)
+        INTO v_column_ids, v_project_ids, v_deltas
+        FROM (
+            SELECT o.column_id, o.project_id, -1 AS delta
+            FROM old_tasks o JOIN new_tasks n ON n.id = o.id
+            WHERE n.column_id <> o.column_id
+            UNION ALL
+            SELECT n.column_id, n.project_id, 1 AS delta
+            FROM old_tasks o JOIN new_tasks n ON n.id = o.id
+            WHERE n.column_id <> o.column_id
+        ) d;
+    END IF;
+
+    IF v_column_ids IS NOT NULL THEN
+        PERFORM adjust_task_counts(v_column_ids, v_project_ids, v_deltas);
+    END IF;
+    RETURN NULL;
+END;
+$$ LANGUAGE plpgsql;
+
+CREATE TRIGGER count_inserted_tasks AFTER INSERT ON tasks
+    REFERENCING NEW TABLE AS new_tasks
+    FOR EACH STATEMENT EXECUTE FUNCTION count_tasks();
+
+CREATE TRIGGER count_moved_tasks AFTER UPDATE ON tasks
+    REFERENCING OLD TABLE AS old_tasks NEW TABLE AS new_tasks
+    FOR EACH STATEMENT EXECUTE FUNCTION count_tasks();
+
+CREATE TRIGGER count_deleted_tasks AFTER DELETE ON tasks
+    REFERENCING OLD TABLE AS old_tasks
+    FOR EACH STATEMENT EXECUTE FUNCTION count_tasks();
+
+CREATE OR REPLACE FUNCTION count_members()
+RETURNS TRIGGER AS $$
+DECLARE
+    v_project_ids UUID[];
+    v_deltas INTEGER[];
+    i INTEGER;
+BEGIN
+    -- Each branch names only the transition table its trigger declares
+    IF TG_OP = 'INSERT' THEN
+        SELECT array_agg(d.project_id ORDER BY d.project_id), array_agg(d.delta ORDER BY d.project_id)
+        INTO v_project_ids, v_deltas
+        FROM (SELECT n.project_id, COUNT(*)::INTEGER AS delta FROM new_members n GROUP BY n.project_id) d;
+    ELSE
+        SELECT array_agg(d.project_id ORDER BY d.project_id), array_agg(d.delta ORDER BY d.project_id)
+        INTO v_project_ids, v_deltas
+        FROM (SELECT o.project_id, -COUNT(*)::INTEGER AS delta FROM old_members o GROUP BY o.project_id) d;
+    END IF;
+
+    FOR i IN 1 .. COALESCE(array_length(v_project_ids, 1), 0) LOOP
+        UPDATE projects SET member_count = member_count + v_deltas[i] WHERE id = v_project_ids[i];
+    END LOOP;
+    RETURN NULL;
+END;
+$$ LANGUAGE plpgsql;
+
+CREATE TRIGGER count_added_members AFTER INSERT ON project_members
+    REFERENCING NEW TABLE AS new_members
+    FOR EACH STATEMENT EXECUTE FUNCTION count_members();
+
+CREATE TRIGGER count_removed_members AFTER DELETE ON project_members
+    REFERENCING OLD TABLE AS old_members
+    FOR EACH STATEMENT EXECUTE FUNCTION count_members();
@@ -0,0 +1,42 @@
+-- Optional: range-partition sessions by expires_at (SESSION_PARTITIONING=true)
+-- Run once after schema.sql and functions.sql. Live sessions are copied over.
+--
+-- The primary key has to include the partition key, so it becomes
+-- (id, expires_at). Lookups by id still use it but cannot prune on
+-- expires_at, so every lookup probes one index per partition: the reaper
+-- keeps that to the 7 live days plus SESSION_PARTITION_DAYS_AHEAD (8, about
+-- 16 partitions) and should not be configured far beyond it.
+--
+-- Expired days are detached with DETACH PARTITION ... CONCURRENTLY and then
+-- dropped by the reaper (expired_session_partitions() lists them) instead of
+-- row-by-row DELETEs. There is deliberately no DEFAULT partition: PostgreSQL
+-- refuses a concurrent detach while one exists. A login whose expiry has no
+-- partition yet makes create_session() create the missing ones and retry.
+
+BEGIN;
+
+ALTER TABLE sessions RENAME TO sessions_unpartitioned;
+ALTER INDEX idx_sessions_user_id RENAME TO idx_sessions_unpartitioned_user_id;
+ALTER INDEX idx_sessions_expires_at RENAME TO idx_sessions_unpartitioned_expires_at;
+
+CREATE TABLE sessions (
+    id VARCHAR(255) NOT NULL,
+    user_id UUID NOT NULL REFERENCES users(id) ON DELETE CASCADE,
+    expires_at TIMESTAMP WITH TIME ZONE NOT NULL DEFAULT NOW() + INTERVAL '7 days',
+    created_at TIMESTAMP WITH TIME ZONE DEFAULT NOW(),
+    PRIMARY KEY (id, expires_at)
+) PARTITION BY RANGE (expires_at);
+
+CREATE INDEX idx_sessions_user_id ON sessions(user_id);
+
+-- Sessions last 7 days; keep the next 8 days of partitions ready
+SELECT ensure_session_partitions(8);
+
+INSERT INTO sessions (id, user_id, expires_at, created_at)
+SELECT id, user_id, expires_at, created_at
+FROM sessions_unpartitioned
+WHERE expires_at > NOW();
+
+DROP TABLE sessions_unpartitioned;
+
+COMMIT;